@@ -0,0 +1,315 @@
+#include "synthetic.h"
+
+#include "core/mark_validation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<std::uint64_t> g_allocations{ 0 };
+}
+
+void* operator new(std::size_t a_size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(a_size ? a_size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* a_ptr) noexcept
+{
+    std::free(a_ptr);
+}
+
+void operator delete(void* a_ptr, std::size_t) noexcept
+{
+    std::free(a_ptr);
+}
+
+namespace RFAB::Disenchant::Bench
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Options
+        {
+            std::vector<std::size_t> entries{ 100, 200, 1000, 2000, 10000, 20000, 50000 };
+            std::vector<std::size_t> depths{ 1, 4 };
+            std::vector<double> densities{ 0.0, 0.1, 0.5, 1.0 };
+            std::size_t samples{ 200 };
+            std::uint64_t seed{ 1 };
+        };
+
+        struct Result
+        {
+            std::string op;
+            double nsPerOp{ 0 };
+            double allocsPerOp{ 0 };
+            double p50{ 0 };
+            double p90{ 0 };
+            double p99{ 0 };
+            double max{ 0 };
+            std::size_t opsPerSample{ 0 };
+        };
+
+        volatile std::uintptr_t g_sink = 0;
+
+        // Runs a_op in batches sized so one sample takes a few microseconds, then reports the
+        // per-op time distribution across samples.
+        [[nodiscard]] Result Measure(std::string a_name, std::size_t a_samples, const std::function<void(std::size_t)>& a_op)
+        {
+            std::size_t counter = 0;
+            const auto calibrateStart = Clock::now();
+            a_op(counter++);
+            const auto single = std::chrono::duration<double, std::nano>(Clock::now() - calibrateStart).count();
+            const auto batch = std::clamp<std::size_t>(static_cast<std::size_t>(4000.0 / std::max(single, 1.0)), 1, 4096);
+
+            std::vector<double> perOp;
+            perOp.reserve(a_samples);
+
+            const auto allocsBefore = g_allocations.load(std::memory_order_relaxed);
+            double total = 0;
+            for (std::size_t sample = 0; sample < a_samples; ++sample) {
+                const auto start = Clock::now();
+                for (std::size_t i = 0; i < batch; ++i) {
+                    a_op(counter++);
+                }
+                const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                total += elapsed;
+                perOp.push_back(elapsed / static_cast<double>(batch));
+            }
+            const auto allocs = g_allocations.load(std::memory_order_relaxed) - allocsBefore;
+            const auto ops = static_cast<double>(a_samples * batch);
+
+            std::sort(perOp.begin(), perOp.end());
+            auto percentile = [&](double a_p) {
+                const auto index = static_cast<std::size_t>(a_p * static_cast<double>(perOp.size() - 1));
+                return perOp[index];
+            };
+
+            Result result;
+            result.op = std::move(a_name);
+            result.nsPerOp = total / ops;
+            result.allocsPerOp = static_cast<double>(allocs) / ops;
+            result.p50 = percentile(0.50);
+            result.p90 = percentile(0.90);
+            result.p99 = percentile(0.99);
+            result.max = perOp.back();
+            result.opsPerSample = batch;
+            return result;
+        }
+
+        // Mirrors TESObjectREFR::GetInventory(), which builds a fresh map of copied entries on
+        // every call before the plugin scans it.
+        [[nodiscard]] std::map<std::uint32_t, std::pair<std::int32_t, std::unique_ptr<InventoryEntry>>> CopyInventory(
+            const SyntheticInventory& a_inventory)
+        {
+            std::map<std::uint32_t, std::pair<std::int32_t, std::unique_ptr<InventoryEntry>>> map;
+            for (const auto& entry : a_inventory.entries) {
+                map.emplace(entry->objectFormID, std::make_pair(1, std::make_unique<InventoryEntry>(*entry)));
+            }
+            return map;
+        }
+
+        [[nodiscard]] std::vector<Result> RunSuite(const InventoryParams& a_params, std::size_t a_samples)
+        {
+            MarkStore store;
+            SyntheticInventory inventory(a_params, store);
+            auto& menu = inventory.menu;
+            const auto entryCount = inventory.entries.size();
+            const auto projectEntry = [](const std::unique_ptr<InventoryEntry>& a_entry) { return a_entry.get(); };
+
+            // Probe keys: marked ones when there are any, otherwise keys that miss.
+            std::vector<std::uint64_t> probeKeys = inventory.markedKeys;
+            if (probeKeys.empty()) {
+                probeKeys.push_back(MakeMarkKey(0x14, 0xFFFF));
+            }
+            std::vector<MarkSignature> probeSignatures = inventory.markedSignatures;
+            if (probeSignatures.empty()) {
+                probeSignatures.push_back(MakeMarkSignature(0xFFFFFFFF, 0xFFFFFFFF));
+            }
+
+            std::vector<Result> results;
+            results.push_back(Measure("IsEntryMarked", a_samples, [&](std::size_t a_i) {
+                g_sink = IsEntryMarked<SyntheticTraits>(store, inventory.entries[a_i % entryCount].get());
+            }));
+            std::vector<std::uint64_t> batchBits((probeKeys.size() + 63) / 64);
+            results.push_back(Measure("AreMarkedBatch", a_samples, [&](std::size_t) {
+                g_sink = store.AreMarked(probeKeys, batchBits.data());
+            }));
+            results.push_back(Measure("ResolveDisenchantSelection", a_samples, [&](std::size_t) {
+                g_sink = reinterpret_cast<std::uintptr_t>(ResolveDisenchantSelection<SyntheticTraits>(&menu));
+            }));
+            // Marked-row mask for the whole list: the per-row lookup the menu used to do, against
+            // one batched probe of every row's keys.
+            std::vector<std::uint64_t> rowBits((SyntheticTraits::RowCount(&menu) + 63) / 64);
+            results.push_back(Measure("MarkedRowsPerRow", a_samples, [&](std::size_t) {
+                std::fill(rowBits.begin(), rowBits.end(), 0);
+                const auto rows = SyntheticTraits::RowCount(&menu);
+                for (std::size_t row = 0; row < rows; ++row) {
+                    if (IsEntryMarked<SyntheticTraits>(store, SyntheticTraits::RowData(SyntheticTraits::RowAt(&menu, row)))) {
+                        rowBits[row / 64] |= std::uint64_t{ 1 } << (row % 64);
+                    }
+                }
+                g_sink = rowBits.empty() ? 0 : rowBits.front();
+            }));
+            MarkedRowScratch scratch;
+            results.push_back(Measure("MarkedRowsBatch", a_samples, [&](std::size_t) {
+                g_sink = CollectMarkedRows<SyntheticTraits>(store, &menu, scratch);
+            }));
+
+            // The raw probe over every row key, per instruction set the host supports.
+            const MarkProbeTable probe(inventory.markedKeys);
+            const auto& rowKeys = scratch.keys;
+            std::vector<std::uint64_t> rowKeyBits((rowKeys.size() + 63) / 64 + 1);
+            for (const auto isa : { ProbeIsa::kScalar, ProbeIsa::kSse2, ProbeIsa::kAvx2 }) {
+                if (isa > DetectProbeIsa()) {
+                    continue;
+                }
+                results.push_back(Measure(std::string("ProbeRowKeys/") + GetProbeIsaName(isa), a_samples, [&](std::size_t) {
+                    g_sink = probe.ContainsBatch(rowKeys.data(), rowKeys.size(), rowKeyBits.data(), isa);
+                }));
+            }
+
+            results.push_back(Measure("ForceEnableMarkedDisenchantRows", a_samples, [&](std::size_t) {
+                ForceEnableMarkedRows<SyntheticTraits>(store, &menu, scratch);
+            }));
+            results.push_back(Measure("ScanByKey", a_samples, [&](std::size_t a_i) {
+                g_sink = reinterpret_cast<std::uintptr_t>(
+                    FindEntryByKey<SyntheticTraits>(inventory.entries, probeKeys[a_i % probeKeys.size()], projectEntry));
+            }));
+            results.push_back(Measure("ScanBySignature", a_samples, [&](std::size_t a_i) {
+                g_sink = reinterpret_cast<std::uintptr_t>(
+                    FindEntryBySignature<SyntheticTraits>(inventory.entries, probeSignatures[a_i % probeSignatures.size()], projectEntry));
+            }));
+            results.push_back(Measure("GetInventoryScanByKey", a_samples, [&](std::size_t a_i) {
+                const auto map = CopyInventory(inventory);
+                g_sink = reinterpret_cast<std::uintptr_t>(FindEntryByKey<SyntheticTraits>(
+                    map, probeKeys[a_i % probeKeys.size()], [](const auto& a_item) { return a_item.second.second.get(); }));
+            }));
+
+            // Load-time validation: every held key plus as many marks again left behind by a
+            // removed plugin, on one thread and on all of them.
+            MarkValidationSnapshot validation;
+            for (const auto& entry : inventory.entries) {
+                SyntheticTraits::ForEachUniqueKey(entry.get(), [&](std::uint64_t a_key) {
+                    validation.heldKeys.push_back(a_key);
+                    return false;
+                });
+            }
+            std::sort(validation.heldKeys.begin(), validation.heldKeys.end());
+            validation.marks = inventory.markedKeys;
+            for (std::size_t i = 0; i < inventory.markedKeys.size(); ++i) {
+                validation.marks.push_back(MakeMarkKey(0xFE000800, static_cast<std::uint16_t>(i)));
+            }
+            std::sort(validation.marks.begin(), validation.marks.end());
+            validation.resolvedForms.push_back(0x14);
+            for (const std::size_t workers : { std::size_t{ 1 }, std::size_t{ std::thread::hardware_concurrency() } }) {
+                if (workers == 0 || (workers == 1 && results.back().op == "ValidateMarks/1")) {
+                    continue;
+                }
+                results.push_back(Measure("ValidateMarks/" + std::to_string(workers), a_samples, [&](std::size_t) {
+                    g_sink = ValidateMarks(validation, workers).staleKeys.size();
+                }));
+            }
+            return results;
+        }
+
+        template <class T>
+        [[nodiscard]] std::vector<T> ParseList(std::string_view a_text)
+        {
+            std::vector<T> values;
+            while (!a_text.empty()) {
+                const auto comma = a_text.find(',');
+                const std::string token(a_text.substr(0, comma));
+                if constexpr (std::is_floating_point_v<T>) {
+                    values.push_back(static_cast<T>(std::strtod(token.c_str(), nullptr)));
+                } else {
+                    values.push_back(static_cast<T>(std::strtoull(token.c_str(), nullptr, 10)));
+                }
+                if (comma == std::string_view::npos) {
+                    break;
+                }
+                a_text.remove_prefix(comma + 1);
+            }
+            return values;
+        }
+
+        [[nodiscard]] bool ParseOptions(int a_argc, char** a_argv, Options& a_options)
+        {
+            for (int i = 1; i < a_argc; ++i) {
+                const std::string_view arg = a_argv[i];
+                const auto hasValue = i + 1 < a_argc;
+                if (arg == "--entries" && hasValue) {
+                    a_options.entries = ParseList<std::size_t>(a_argv[++i]);
+                } else if (arg == "--depth" && hasValue) {
+                    a_options.depths = ParseList<std::size_t>(a_argv[++i]);
+                } else if (arg == "--density" && hasValue) {
+                    a_options.densities = ParseList<double>(a_argv[++i]);
+                } else if (arg == "--samples" && hasValue) {
+                    a_options.samples = std::max<std::size_t>(1, std::strtoull(a_argv[++i], nullptr, 10));
+                } else if (arg == "--seed" && hasValue) {
+                    a_options.seed = std::strtoull(a_argv[++i], nullptr, 10);
+                } else {
+                    std::fprintf(stderr,
+                        "usage: %s [--entries 100,1000,...] [--depth 1,4] [--density 0,0.1,1] [--samples N] [--seed N]\n",
+                        a_argv[0]);
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    int Run(int a_argc, char** a_argv)
+    {
+        Options options;
+        if (!ParseOptions(a_argc, a_argv, options)) {
+            return 1;
+        }
+
+        std::printf("[\n");
+        bool first = true;
+        for (const auto entries : options.entries) {
+            for (const auto depth : options.depths) {
+                for (const auto density : options.densities) {
+                    const InventoryParams params{ entries, std::max<std::size_t>(depth, 1), std::clamp(density, 0.0, 1.0), options.seed };
+                    for (const auto& result : RunSuite(params, options.samples)) {
+                        std::printf(
+                            "%s  {\"op\": \"%s\", \"entries\": %zu, \"stackDepth\": %zu, \"markDensity\": %.3f, "
+                            "\"nsPerOp\": %.2f, \"allocsPerOp\": %.3f, \"p50Ns\": %.2f, \"p90Ns\": %.2f, \"p99Ns\": %.2f, "
+                            "\"maxNs\": %.2f, \"opsPerSample\": %zu}",
+                            first ? "" : ",\n",
+                            result.op.c_str(), params.entries, params.stackDepth, params.markDensity,
+                            result.nsPerOp, result.allocsPerOp, result.p50, result.p90, result.p99, result.max,
+                            result.opsPerSample);
+                        first = false;
+                    }
+                    std::fflush(stdout);
+                }
+            }
+        }
+        std::printf("\n]\n");
+        return 0;
+    }
+}
+
+int main(int a_argc, char** a_argv)
+{
+    return RFAB::Disenchant::Bench::Run(a_argc, a_argv);
+}
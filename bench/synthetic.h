@@ -0,0 +1,227 @@
+#pragma once
+
+#include "core/menu_query.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace RFAB::Disenchant::Bench
+{
+    // Stand-ins shaped like the game's types: BSExtraData nodes hang off an ExtraDataList as a
+    // singly linked list, and an entry's extra lists are themselves a linked list.
+    enum class ExtraType : std::uint8_t
+    {
+        kCount,
+        kHealth,
+        kWorn,
+        kUniqueID,
+        kEnchantment,
+        kCharge
+    };
+
+    struct ExtraData
+    {
+        ExtraType type;
+        std::uint32_t formID{ 0 };
+        std::uint16_t uniqueID{ 0 };
+        ExtraData* next{ nullptr };
+    };
+
+    struct ExtraDataList
+    {
+        ExtraData* head{ nullptr };
+
+        [[nodiscard]] const ExtraData* GetByType(ExtraType a_type) const noexcept
+        {
+            for (auto* extra = head; extra; extra = extra->next) {
+                if (extra->type == a_type) {
+                    return extra;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    struct ExtraListNode
+    {
+        ExtraDataList* item{ nullptr };
+        ExtraListNode* next{ nullptr };
+    };
+
+    struct InventoryEntry
+    {
+        std::uint32_t objectFormID{ 0 };
+        std::uint32_t baseEnchantmentFormID{ 0 };
+        ExtraListNode* extraLists{ nullptr };
+    };
+
+    struct MenuRow
+    {
+        InventoryEntry* data{ nullptr };
+        bool selected{ false };
+        bool enabled{ false };
+    };
+
+    struct Menu
+    {
+        std::vector<std::unique_ptr<MenuRow>> rows;
+        std::size_t highlightIndex{ 0 };
+        InventoryEntry* selected{ nullptr };
+    };
+
+    struct SyntheticTraits
+    {
+        using Entry = InventoryEntry;
+        using Menu = Bench::Menu;
+        using Row = MenuRow;
+
+        [[nodiscard]] static std::uint32_t GetExtraEnchantment(Entry* a_entry) noexcept
+        {
+            for (auto* node = a_entry->extraLists; node; node = node->next) {
+                if (const auto* extra = node->item->GetByType(ExtraType::kEnchantment); extra && extra->formID) {
+                    return extra->formID;
+                }
+            }
+            return 0;
+        }
+
+        [[nodiscard]] static bool HasExtraEnchantment(Entry* a_entry) noexcept { return GetExtraEnchantment(a_entry) != 0; }
+
+        [[nodiscard]] static bool HasAnyEnchantment(Entry* a_entry) noexcept
+        {
+            return a_entry->baseEnchantmentFormID != 0 || HasExtraEnchantment(a_entry);
+        }
+
+        [[nodiscard]] static std::optional<MarkSignature> GetSignature(Entry* a_entry) noexcept
+        {
+            auto enchantment = a_entry->baseEnchantmentFormID;
+            if (!enchantment) {
+                enchantment = GetExtraEnchantment(a_entry);
+            }
+            if (!enchantment) {
+                return std::nullopt;
+            }
+            return MakeMarkSignature(a_entry->objectFormID, enchantment);
+        }
+
+        template <class F>
+        static void ForEachUniqueKey(Entry* a_entry, F&& a_visitor)
+        {
+            for (auto* node = a_entry->extraLists; node; node = node->next) {
+                if (const auto* extra = node->item->GetByType(ExtraType::kUniqueID)) {
+                    if (a_visitor(MakeMarkKey(extra->formID, extra->uniqueID))) {
+                        return;
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] static std::size_t RowCount(Menu* a_menu) noexcept { return a_menu->rows.size(); }
+        [[nodiscard]] static Row* RowAt(Menu* a_menu, std::size_t a_index) noexcept { return a_menu->rows[a_index].get(); }
+        [[nodiscard]] static std::size_t HighlightIndex(Menu* a_menu) noexcept { return a_menu->highlightIndex; }
+        [[nodiscard]] static Entry* SelectedData(Menu* a_menu) noexcept { return a_menu->selected; }
+        [[nodiscard]] static Entry* RowData(Row* a_row) noexcept { return a_row->data; }
+        [[nodiscard]] static bool IsRowSelected(Row* a_row) noexcept { return a_row->selected; }
+        static void SetRowEnabled(Row* a_row, bool a_enabled) noexcept { a_row->enabled = a_enabled; }
+    };
+
+    static_assert(MenuTraits<SyntheticTraits>);
+
+    struct InventoryParams
+    {
+        std::size_t entries{ 1000 };
+        std::size_t stackDepth{ 1 };
+        double markDensity{ 0.1 };
+        std::uint64_t seed{ 1 };
+    };
+
+    // Owns every node of a generated inventory. Marked entries carry a player enchantment on
+    // their first extra list and have their unique ID (and signature) in the store.
+    class SyntheticInventory
+    {
+    public:
+        SyntheticInventory(const InventoryParams& a_params, MarkStore& a_store)
+        {
+            std::mt19937_64 rng{ a_params.seed };
+            std::bernoulli_distribution marked{ a_params.markDensity };
+            std::bernoulli_distribution vanillaEnchanted{ 0.25 };
+
+            entries.reserve(a_params.entries);
+            MarkSet marks;
+            std::uint16_t nextUniqueID = 1;
+            for (std::size_t i = 0; i < a_params.entries; ++i) {
+                auto& entry = *entries.emplace_back(std::make_unique<InventoryEntry>());
+                entry.objectFormID = 0x00100000u + static_cast<std::uint32_t>(i);
+
+                const auto isMarked = marked(rng);
+                if (!isMarked && vanillaEnchanted(rng)) {
+                    entry.baseEnchantmentFormID = 0x00200000u + static_cast<std::uint32_t>(i % 64);
+                }
+
+                ExtraListNode* tail = nullptr;
+                for (std::size_t depth = 0; depth < a_params.stackDepth; ++depth) {
+                    auto& list = *lists.emplace_back(std::make_unique<ExtraDataList>());
+                    AddExtra(list, ExtraType::kCount);
+                    AddExtra(list, ExtraType::kHealth);
+                    if (depth == 0 && isMarked) {
+                        AddExtra(list, ExtraType::kCharge);
+                        AddExtra(list, ExtraType::kEnchantment).formID = 0xFF000000u + static_cast<std::uint32_t>(i);
+                    }
+                    auto& uniqueID = AddExtra(list, ExtraType::kUniqueID);
+                    uniqueID.formID = 0x14;
+                    uniqueID.uniqueID = nextUniqueID++;
+
+                    auto& node = *nodes.emplace_back(std::make_unique<ExtraListNode>());
+                    node.item = &list;
+                    (tail ? tail->next : entry.extraLists) = &node;
+                    tail = &node;
+
+                    if (depth == 0 && isMarked) {
+                        const auto key = MakeMarkKey(uniqueID.formID, uniqueID.uniqueID);
+                        marks.keys.Insert(key);
+                        markedKeys.push_back(key);
+                        if (const auto signature = SyntheticTraits::GetSignature(&entry)) {
+                            marks.signatures.insert(*signature);
+                            markedSignatures.push_back(*signature);
+                        }
+                    }
+                }
+
+                auto& row = *menu.rows.emplace_back(std::make_unique<MenuRow>());
+                row.data = &entry;
+            }
+            // One publish for the whole set instead of a snapshot rebuild per mark.
+            a_store.Replace(std::move(marks));
+
+            // Worst realistic selection: nothing selected, highlight past the end, and the only
+            // flagged row at the bottom, so ResolveDisenchantSelection walks the whole list.
+            menu.highlightIndex = menu.rows.size();
+            if (!menu.rows.empty()) {
+                menu.rows.back()->selected = true;
+            }
+        }
+
+        std::vector<std::unique_ptr<InventoryEntry>> entries;
+        std::vector<std::uint64_t> markedKeys;
+        std::vector<MarkSignature> markedSignatures;
+        Menu menu;
+
+    private:
+        ExtraData& AddExtra(ExtraDataList& a_list, ExtraType a_type)
+        {
+            auto& extra = *extras.emplace_back(std::make_unique<ExtraData>());
+            extra.type = a_type;
+            extra.next = a_list.head;
+            a_list.head = &extra;
+            return extra;
+        }
+
+        std::vector<std::unique_ptr<ExtraData>> extras;
+        std::vector<std::unique_ptr<ExtraDataList>> lists;
+        std::vector<std::unique_ptr<ExtraListNode>> nodes;
+    };
+}
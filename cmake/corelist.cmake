@@ -0,0 +1,43 @@
+set(core_headers ${core_headers}
+    src/core/adaptive_window.h
+    src/core/chrome_trace.h
+    src/core/codec.h
+    src/core/confirm_flow.h
+    src/core/deadline.h
+    src/core/entry_query.h
+    src/core/gating.h
+    src/core/hook_id.h
+    src/core/hook_trace.h
+    src/core/journal.h
+    src/core/latency_histogram.h
+    src/core/mark_key.h
+    src/core/mark_key_set.h
+    src/core/mark_location.h
+    src/core/mark_probe.h
+    src/core/mark_snapshot.h
+    src/core/mark_store.h
+    src/core/mark_validation.h
+    src/core/menu_query.h
+    src/core/message_gate.h
+    src/core/refresh_scheduler.h
+    src/core/row_prewarm.h
+    src/core/session_arena.h
+    src/core/ticks.h
+)
+set(core_sources ${core_sources}
+    src/core/adaptive_window.cpp
+    src/core/chrome_trace.cpp
+    src/core/codec.cpp
+    src/core/confirm_flow.cpp
+    src/core/gating.cpp
+    src/core/hook_trace.cpp
+    src/core/journal.cpp
+    src/core/latency_histogram.cpp
+    src/core/mark_key_set.cpp
+    src/core/mark_location.cpp
+    src/core/mark_probe.cpp
+    src/core/mark_snapshot.cpp
+    src/core/mark_store.cpp
+    src/core/mark_validation.cpp
+    src/core/session_arena.cpp
+)
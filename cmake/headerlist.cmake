@@ -1,5 +1,8 @@
 set(headers ${headers}
+    include/RFAB_Disenchant/MarkAPI.h
+    include/RFAB_Disenchant/Stats.h
 	src/PCH.h 
     src/log.h
     src/hook.h 
+    src/settings.h
 )
@@ -1,4 +1,5 @@
 set(sources ${sources}
     src/plugin.cpp
     src/hook.cpp
+    src/settings.cpp
 )
\ No newline at end of file
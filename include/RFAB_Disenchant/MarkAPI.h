@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+ * RFAB Disenchant mark queries, for inventory UIs, loot filters and sorting mods that want to
+ * know whether an item carries a custom enchantment the player marked for removal.
+ *
+ * Fetching:
+ *   Register a listener for "RFABDisenchant" with SKSE::MessagingInterface, then dispatch
+ *   RFAB_DISENCHANT_MSG_MARK_API_REQUEST to "RFABDisenchant" (data and length are ignored).
+ *   The plugin answers with RFAB_DISENCHANT_MSG_MARK_API_RESPONSE; the message data is the
+ *   `const RFABDisenchantMarkAPI*` itself and dataLen its size. The table lives for the whole
+ *   process; request it once (e.g. at kPostLoad) and keep the pointer.
+ *
+ * Identifying items:
+ *   An instance with an ExtraUniqueID is identified by its key, MakeKey(baseFormID, uniqueID).
+ *   One without is identified by its object and enchantment FormIDs (IsSignatureMarked).
+ *   An inventory entry is marked if any of its extra lists matches either form.
+ *
+ * Threading:
+ *   Every call is safe from any thread and never takes a lock: queries read an immutable
+ *   snapshot that the plugin republishes after each change. A batch call sees one snapshot
+ *   for all of its keys.
+ *
+ * Caching:
+ *   GetMarkGeneration() changes whenever the mark set does (including on game load). Cache
+ *   answers together with the generation and re-query when it moves.
+ *
+ * Versioning:
+ *   Check `version` and `size` before calling anything. New entries are only ever appended
+ *   and bump the version.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RFAB_DISENCHANT_PLUGIN_NAME
+#    define RFAB_DISENCHANT_PLUGIN_NAME "RFABDisenchant"
+#endif
+#define RFAB_DISENCHANT_MARK_API_VERSION 1u
+
+#define RFAB_DISENCHANT_MSG_MARK_API_REQUEST 0x52464441u  /* 'RFDA' */
+#define RFAB_DISENCHANT_MSG_MARK_API_RESPONSE 0x52464442u /* 'RFDB' */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RFABDisenchantMarkAPI
+{
+    uint32_t version;
+    uint32_t size;
+
+    /* Packs a base FormID and an ExtraUniqueID into a mark key. */
+    uint64_t (*MakeKey)(uint32_t baseFormID, uint16_t uniqueID);
+    /* Whether the instance identified by `key` is marked. */
+    int (*IsKeyMarked)(uint64_t key);
+    /* Whether the object/enchantment pair is marked (instances without an ExtraUniqueID). */
+    int (*IsSignatureMarked)(uint32_t objectFormID, uint32_t enchantmentFormID);
+    /* Sets bit i of `bits` (bits[i / 64] >> (i % 64)) when keys[i] is marked and clears it
+     * otherwise. `bits` must hold (count + 63) / 64 words. Returns the number of marked keys. */
+    size_t (*AreKeysMarked)(const uint64_t* keys, size_t count, uint64_t* bits);
+    /* Changes whenever the mark set changes. */
+    uint64_t (*GetMarkGeneration)(void);
+} RFABDisenchantMarkAPI;
+
+#ifdef __cplusplus
+}
+#endif
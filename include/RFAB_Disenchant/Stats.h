@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * RFAB Disenchant performance counters, for overlays and diagnostics plugins.
+ *
+ * Fetching:
+ *   Register a listener for "RFABDisenchant" with SKSE::MessagingInterface, then dispatch
+ *   RFAB_DISENCHANT_MSG_STATS_REQUEST to "RFABDisenchant" (data and length are ignored).
+ *   The plugin answers with RFAB_DISENCHANT_MSG_STATS_RESPONSE; the message data is the
+ *   `const RFABDisenchantStats*` itself and dataLen its size. Keep the pointer: the block
+ *   lives for the whole process and is updated in place.
+ *
+ * Reading:
+ *   Every counter is a naturally aligned 64-bit value the plugin updates with atomic
+ *   read-modify-writes, so plain aligned 64-bit loads (std::atomic_ref<const uint64_t>,
+ *   InterlockedOr64(x, 0), or a volatile read on x64) are tear-free. Fields are independent:
+ *   there is no snapshot across fields.
+ *
+ * Versioning:
+ *   Check `version` and `size` before touching any field. New fields are only ever appended
+ *   and bump the version; `size` covers everything the plugin actually writes.
+ *
+ * Hook counters are collected from the first stats request onwards, so nothing is paid until
+ * a tool asks. Hook time is in ticks; divide by `ticksPerSecond` (refreshed on every request).
+ */
+
+#include <stdint.h>
+
+#ifndef RFAB_DISENCHANT_PLUGIN_NAME
+#    define RFAB_DISENCHANT_PLUGIN_NAME "RFABDisenchant"
+#endif
+#define RFAB_DISENCHANT_STATS_VERSION 4u
+
+#define RFAB_DISENCHANT_MSG_STATS_REQUEST 0x52464453u  /* 'RFDS' */
+#define RFAB_DISENCHANT_MSG_STATS_RESPONSE 0x52464452u /* 'RFDR' */
+
+/* Hook slots, in order: ProcessUserEvent, ItemChangeEntry::SetData, ItemChangeEntry::Activate,
+ * MessageBoxMenu::ProcessMessage, MessageBoxMenu::PreDisplay, MessageBoxMenu::PostCreate,
+ * EnchantMenuCraftCallback::Run, EnchantMenuDisenchantCallback::Run, RemoveConfirmCallback::Run. */
+#define RFAB_DISENCHANT_STATS_HOOK_COUNT 9u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RFABDisenchantHookCounters
+{
+    uint64_t calls;
+    uint64_t totalTicks;
+} RFABDisenchantHookCounters;
+
+typedef struct RFABDisenchantStats
+{
+    uint32_t version;
+    uint32_t size;
+    uint32_t hookCount;
+    uint32_t reserved;
+    uint64_t ticksPerSecond;
+
+    RFABDisenchantHookCounters hooks[RFAB_DISENCHANT_STATS_HOOK_COUNT];
+
+    /* Player inventory walks (GetInventory + scan) performed by the plugin. */
+    uint64_t inventoryScans;
+    /* Mark-store lookups for inventory entries, and how many found a mark. */
+    uint64_t markLookups;
+    uint64_t markLookupHits;
+    /* Current mark-store contents. */
+    uint64_t markedKeys;
+    uint64_t markedSignatures;
+    /* UpdateConstructibleList / UpdateInterface calls, and UI tasks queued. */
+    uint64_t uiRefreshes;
+    uint64_t uiTasksQueued;
+
+    /* Version 2: menu refresh requests folded into an already queued refresh. */
+    uint64_t uiRefreshesCoalesced;
+
+    /* Version 3: MessageBoxMenu force-hides sent, and ones dropped because one was in flight. */
+    uint64_t forceHidesSent;
+    uint64_t forceHidesSaved;
+
+    /* Version 4: largest CraftingMenu session arena, and allocations it kept off the heap. */
+    uint64_t sessionArenaPeakBytes;
+    uint64_t sessionArenaAllocationsAvoided;
+} RFABDisenchantStats;
+
+#ifdef __cplusplus
+}
+#endif
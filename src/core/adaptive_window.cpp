@@ -0,0 +1,64 @@
+#include "adaptive_window.h"
+
+#include <algorithm>
+
+namespace RFAB::Disenchant
+{
+    AdaptiveWindow::AdaptiveWindow(std::uint32_t a_fallbackMs, std::uint32_t a_percentile, std::uint32_t a_headroomPercent) noexcept :
+        _fallbackMs(a_fallbackMs),
+        _percentile(std::min<std::uint32_t>(a_percentile, 100)),
+        _headroomPercent(a_headroomPercent),
+        _currentMs(a_fallbackMs)
+    {}
+
+    void AdaptiveWindow::SetBounds(std::uint32_t a_minMs, std::uint32_t a_maxMs)
+    {
+        std::scoped_lock lk(_lock);
+        _minMs = a_minMs;
+        _maxMs = std::max(a_minMs, a_maxMs);
+        RecomputeLocked();
+    }
+
+    std::uint32_t AdaptiveWindow::Record(std::uint32_t a_latencyMs)
+    {
+        std::scoped_lock lk(_lock);
+        _samples[_next] = a_latencyMs;
+        _next = (_next + 1) % kSamples;
+        _count = std::min(_count + 1, kSamples);
+        RecomputeLocked();
+        return _currentMs.load(std::memory_order_relaxed);
+    }
+
+    std::size_t AdaptiveWindow::SampleCount() const
+    {
+        std::scoped_lock lk(_lock);
+        return _count;
+    }
+
+    std::uint32_t AdaptiveWindow::MinMs() const
+    {
+        std::scoped_lock lk(_lock);
+        return _minMs;
+    }
+
+    std::uint32_t AdaptiveWindow::MaxMs() const
+    {
+        std::scoped_lock lk(_lock);
+        return _maxMs;
+    }
+
+    void AdaptiveWindow::RecomputeLocked()
+    {
+        std::uint64_t windowMs = _fallbackMs;
+        if (_count >= kMinSamples) {
+            std::array<std::uint32_t, kSamples> sorted;
+            std::copy_n(_samples.begin(), _count, sorted.begin());
+            const auto rank = (_count - 1) * _percentile / 100;
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + _count);
+            windowMs = static_cast<std::uint64_t>(sorted[rank]) * _headroomPercent / 100;
+        }
+
+        const auto clamped = std::clamp<std::uint64_t>(windowMs, _minMs, _maxMs);
+        _currentMs.store(static_cast<std::uint32_t>(clamped), std::memory_order_relaxed);
+    }
+}
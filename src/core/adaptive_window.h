@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace RFAB::Disenchant
+{
+    // Length of a suppression window, in ms, sized from measured latency instead of a constant:
+    // the given percentile of the last kSamples measurements, scaled by a headroom factor and
+    // clamped to the configured bounds. Until kMinSamples have been recorded it stays at the
+    // (clamped) fallback. Record() and Current() may be called from any thread.
+    class AdaptiveWindow
+    {
+    public:
+        static constexpr std::size_t kSamples = 64;
+        static constexpr std::size_t kMinSamples = 8;
+
+        AdaptiveWindow(std::uint32_t a_fallbackMs, std::uint32_t a_percentile, std::uint32_t a_headroomPercent) noexcept;
+        AdaptiveWindow(const AdaptiveWindow&) = delete;
+        AdaptiveWindow& operator=(const AdaptiveWindow&) = delete;
+
+        // Bounds with a_maxMs below a_minMs are widened to the single value a_minMs.
+        void SetBounds(std::uint32_t a_minMs, std::uint32_t a_maxMs);
+        // Adds one measurement and returns the resulting window.
+        std::uint32_t Record(std::uint32_t a_latencyMs);
+
+        [[nodiscard]] std::uint32_t Current() const noexcept { return _currentMs.load(std::memory_order_relaxed); }
+        [[nodiscard]] std::size_t SampleCount() const;
+        [[nodiscard]] std::uint32_t MinMs() const;
+        [[nodiscard]] std::uint32_t MaxMs() const;
+
+    private:
+        void RecomputeLocked();
+
+        mutable std::mutex _lock;
+        std::array<std::uint32_t, kSamples> _samples{};
+        std::size_t _next{ 0 };
+        std::size_t _count{ 0 };
+        std::uint32_t _fallbackMs;
+        std::uint32_t _percentile;
+        std::uint32_t _headroomPercent;
+        std::uint32_t _minMs{ 0 };
+        std::uint32_t _maxMs{ UINT32_MAX };
+        std::atomic<std::uint32_t> _currentMs;
+    };
+}
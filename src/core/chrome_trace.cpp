@@ -0,0 +1,205 @@
+#include "chrome_trace.h"
+
+#include "ticks.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+#    include <Windows.h>
+#else
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+        [[nodiscard]] std::uint32_t CurrentProcessId() noexcept
+        {
+#ifdef _WIN32
+            return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+            return static_cast<std::uint32_t>(::getpid());
+#endif
+        }
+    }
+
+    ChromeTraceRecorder::~ChromeTraceRecorder()
+    {
+        Stop();
+    }
+
+    std::uint32_t ChromeTraceRecorder::CurrentThreadId() noexcept
+    {
+        thread_local const auto id = []() {
+#ifdef _WIN32
+            return static_cast<std::uint32_t>(::GetCurrentThreadId());
+#else
+            return static_cast<std::uint32_t>(::syscall(SYS_gettid));
+#endif
+        }();
+        return id;
+    }
+
+    bool ChromeTraceRecorder::Start(const std::filesystem::path& a_path, const char* a_processName)
+    {
+        Stop();
+
+#ifdef _WIN32
+        _file = ::_wfopen(a_path.c_str(), L"wb");
+#else
+        _file = std::fopen(a_path.c_str(), "wb");
+#endif
+        if (!_file) {
+            return false;
+        }
+
+        _slots = std::make_unique<Slot[]>(kCapacity);
+        for (std::size_t i = 0; i < kCapacity; ++i) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _head.store(0, std::memory_order_relaxed);
+        _tail = 0;
+        _dropped.store(0, std::memory_order_relaxed);
+        _pid = CurrentProcessId();
+
+        std::fprintf(_file,
+            "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+            _pid, a_processName);
+        std::fflush(_file);
+
+        _stopping = false;
+        _flusher = std::thread(&ChromeTraceRecorder::FlushLoop, this);
+        return true;
+    }
+
+    void ChromeTraceRecorder::Stop()
+    {
+        if (!_flusher.joinable()) {
+            return;
+        }
+
+        {
+            std::scoped_lock lk(_lock);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        _flusher.join();
+
+        std::fprintf(_file, ",\n{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"count\":%llu}}\n]\n",
+            _pid, static_cast<unsigned long long>(Dropped()));
+        std::fclose(_file);
+        _file = nullptr;
+        _slots.reset();
+    }
+
+    void ChromeTraceRecorder::Complete(
+        const char* a_name, const char* a_category, std::uint64_t a_startNs, std::uint64_t a_endNs, std::uint64_t a_id) noexcept
+    {
+        Push({ a_name, a_category, a_startNs, a_endNs - a_startNs, a_id, CurrentThreadId(), ChromePhase::kComplete });
+    }
+
+    void ChromeTraceRecorder::Instant(const char* a_name, const char* a_category, std::uint64_t a_id) noexcept
+    {
+        Push({ a_name, a_category, ReadSteadyNs(), 0, a_id, CurrentThreadId(), ChromePhase::kInstant });
+    }
+
+    void ChromeTraceRecorder::FlowStart(const char* a_name, const char* a_category, std::uint64_t a_id) noexcept
+    {
+        Push({ a_name, a_category, ReadSteadyNs(), 0, a_id, CurrentThreadId(), ChromePhase::kFlowStart });
+    }
+
+    void ChromeTraceRecorder::FlowEnd(const char* a_name, const char* a_category, std::uint64_t a_id) noexcept
+    {
+        Push({ a_name, a_category, ReadSteadyNs(), 0, a_id, CurrentThreadId(), ChromePhase::kFlowEnd });
+    }
+
+    // Bounded multi-producer ring (Vyukov): each slot's sequence says whose turn it is, so a
+    // producer claims a slot with one CAS on the head and never waits on the consumer. A full
+    // ring drops the event instead of stalling the game thread.
+    void ChromeTraceRecorder::Push(const ChromeTraceEvent& a_event) noexcept
+    {
+        if (!_slots) {
+            return;
+        }
+
+        auto position = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = _slots[position & (kCapacity - 1)];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(sequence - position);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.event = a_event;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return;
+                }
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool ChromeTraceRecorder::Pop(ChromeTraceEvent& a_event) noexcept
+    {
+        auto& slot = _slots[_tail & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != _tail + 1) {
+            return false;
+        }
+
+        a_event = slot.event;
+        slot.sequence.store(_tail + kCapacity, std::memory_order_release);
+        ++_tail;
+        return true;
+    }
+
+    void ChromeTraceRecorder::FlushLoop()
+    {
+        std::unique_lock lk(_lock);
+        while (!_stopping) {
+            _wake.wait_for(lk, kFlushInterval);
+            Drain();
+        }
+    }
+
+    void ChromeTraceRecorder::Drain()
+    {
+        ChromeTraceEvent event;
+        bool wrote = false;
+        while (Pop(event)) {
+            const auto ts = static_cast<double>(event.tsNs) / 1000.0;
+            const auto phase = static_cast<char>(event.phase);
+            std::fprintf(_file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u",
+                event.name, event.category, phase, ts, _pid, event.tid);
+            switch (event.phase) {
+            case ChromePhase::kComplete:
+                std::fprintf(_file, ",\"dur\":%.3f", static_cast<double>(event.durNs) / 1000.0);
+                break;
+            case ChromePhase::kInstant:
+                std::fputs(",\"s\":\"t\"", _file);
+                break;
+            case ChromePhase::kFlowStart:
+                std::fprintf(_file, ",\"id\":%llu", static_cast<unsigned long long>(event.id));
+                break;
+            case ChromePhase::kFlowEnd:
+                std::fprintf(_file, ",\"id\":%llu,\"bp\":\"e\"", static_cast<unsigned long long>(event.id));
+                break;
+            }
+            if (event.id != 0 && (event.phase == ChromePhase::kComplete || event.phase == ChromePhase::kInstant)) {
+                std::fprintf(_file, ",\"args\":{\"id\":%llu}", static_cast<unsigned long long>(event.id));
+            }
+            std::fputc('}', _file);
+            wrote = true;
+        }
+
+        if (wrote) {
+            std::fflush(_file);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace RFAB::Disenchant
+{
+    enum class ChromePhase : char
+    {
+        kComplete = 'X',
+        kInstant = 'i',
+        kFlowStart = 's',
+        kFlowEnd = 'f'
+    };
+
+    // Names and categories must be string literals; only the pointers are stored.
+    struct ChromeTraceEvent
+    {
+        const char* name{ nullptr };
+        const char* category{ nullptr };
+        std::uint64_t tsNs{ 0 };
+        std::uint64_t durNs{ 0 };
+        std::uint64_t id{ 0 };
+        std::uint32_t tid{ 0 };
+        ChromePhase phase{ ChromePhase::kInstant };
+    };
+
+    // Writes Chrome trace-event JSON (about://tracing, Perfetto). Producers push into a bounded
+    // lock-free ring and never block; a background thread drains it to disk. Timestamps are
+    // steady_clock (QPC on Windows) microseconds, unrebased, so they line up with PresentMon
+    // and ETW captures of the same session. The file stays loadable if the game dies mid-run.
+    class ChromeTraceRecorder
+    {
+    public:
+        static constexpr std::size_t kCapacity = 1u << 15;
+
+        ChromeTraceRecorder() = default;
+        ChromeTraceRecorder(const ChromeTraceRecorder&) = delete;
+        ChromeTraceRecorder& operator=(const ChromeTraceRecorder&) = delete;
+        ~ChromeTraceRecorder();
+
+        [[nodiscard]] bool Start(const std::filesystem::path& a_path, const char* a_processName);
+        void Stop();
+
+        void Complete(const char* a_name, const char* a_category, std::uint64_t a_startNs, std::uint64_t a_endNs, std::uint64_t a_id = 0) noexcept;
+        void Instant(const char* a_name, const char* a_category, std::uint64_t a_id = 0) noexcept;
+        void FlowStart(const char* a_name, const char* a_category, std::uint64_t a_id) noexcept;
+        void FlowEnd(const char* a_name, const char* a_category, std::uint64_t a_id) noexcept;
+
+        [[nodiscard]] std::uint64_t NextId() noexcept { return _nextID.fetch_add(1, std::memory_order_relaxed); }
+        [[nodiscard]] std::uint64_t Dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+        [[nodiscard]] static std::uint32_t CurrentThreadId() noexcept;
+
+    private:
+        struct Slot
+        {
+            std::atomic<std::uint64_t> sequence{ 0 };
+            ChromeTraceEvent event;
+        };
+
+        void Push(const ChromeTraceEvent& a_event) noexcept;
+        [[nodiscard]] bool Pop(ChromeTraceEvent& a_event) noexcept;
+        void FlushLoop();
+        void Drain();
+
+        std::unique_ptr<Slot[]> _slots;
+        alignas(64) std::atomic<std::uint64_t> _head{ 0 };
+        alignas(64) std::uint64_t _tail{ 0 };
+        std::atomic<std::uint64_t> _dropped{ 0 };
+        std::atomic<std::uint64_t> _nextID{ 1 };
+
+        std::mutex _lock;
+        std::condition_variable _wake;
+        bool _stopping{ false };
+        std::thread _flusher;
+        std::FILE* _file{ nullptr };
+        std::uint32_t _pid{ 0 };
+    };
+}
@@ -0,0 +1,195 @@
+#include "codec.h"
+
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        [[nodiscard]] CodecResult ReadFlatMarkKeys(RecordReader& a_reader, MarkSet& a_marks)
+        {
+            std::uint32_t count = 0;
+            if (!a_reader.Read(count)) {
+                return { CodecError::kKeyCount };
+            }
+
+            for (std::uint32_t i = 0; i < count; ++i) {
+                std::uint64_t key = 0;
+                if (!a_reader.Read(key)) {
+                    return { CodecError::kKey, i };
+                }
+
+                a_marks.keys.Insert(key);
+            }
+            return {};
+        }
+
+        [[nodiscard]] CodecResult ReadMarkContainers(RecordReader& a_reader, MarkSet& a_marks)
+        {
+            std::uint32_t count = 0;
+            if (!a_reader.Read(count)) {
+                return { CodecError::kContainerCount };
+            }
+
+            for (std::uint32_t i = 0; i < count; ++i) {
+                MarkContainerHeader header;
+                if (!a_reader.Read(header)) {
+                    return { CodecError::kContainer, i };
+                }
+
+                UniqueIDContainer container;
+                bool valid = false;
+                if (header.kind == UniqueIDContainer::Kind::kArray && header.count <= UniqueIDContainer::kArrayMax) {
+                    std::vector<std::uint16_t> ids(header.count);
+                    valid = a_reader.ReadBytes(ids.data(), static_cast<std::uint32_t>(ids.size() * sizeof(std::uint16_t))) &&
+                            container.AssignArray(std::move(ids));
+                } else if (header.kind == UniqueIDContainer::Kind::kBitmap) {
+                    std::vector<std::uint64_t> words(UniqueIDContainer::kBitmapWords);
+                    valid = a_reader.ReadBytes(words.data(), static_cast<std::uint32_t>(words.size() * sizeof(std::uint64_t))) &&
+                            container.AssignBitmap(std::move(words)) && container.Size() == header.count;
+                }
+
+                if (!valid || !a_marks.keys.AppendContainer(header.baseID, std::move(container))) {
+                    return { CodecError::kContainer, i, header.baseID };
+                }
+            }
+            return {};
+        }
+    }
+
+    CodecResult WriteMarkRecord(RecordWriter& a_writer, const MarkSet& a_marks, const JournalLink& a_link)
+    {
+        if (!a_writer.Write(static_cast<std::uint32_t>(a_marks.keys.ContainerCount()))) {
+            return { CodecError::kContainerCount };
+        }
+
+        std::uint32_t index = 0;
+        CodecResult result;
+        a_marks.keys.ForEachContainer([&](std::uint32_t a_baseID, const UniqueIDContainer& a_container) {
+            if (!result) {
+                return;
+            }
+
+            MarkContainerHeader header;
+            header.baseID = a_baseID;
+            header.kind = a_container.GetKind();
+            header.count = static_cast<std::uint32_t>(a_container.Size());
+
+            const auto written =
+                a_writer.Write(header) &&
+                (header.kind == UniqueIDContainer::Kind::kArray ?
+                        a_writer.WriteBytes(a_container.Array().data(), static_cast<std::uint32_t>(a_container.Array().size_bytes())) :
+                        a_writer.WriteBytes(a_container.Bitmap().data(), static_cast<std::uint32_t>(a_container.Bitmap().size_bytes())));
+            if (!written) {
+                result = { CodecError::kContainer, index, a_baseID };
+            }
+            ++index;
+        });
+        if (!result) {
+            return result;
+        }
+
+        const auto signatureCount = static_cast<std::uint32_t>(a_marks.signatures.size());
+        if (!a_writer.Write(signatureCount)) {
+            return { CodecError::kSignatureCount };
+        }
+
+        index = 0;
+        for (const auto signature : a_marks.signatures) {
+            const auto objectFormID = GetSignatureObjectFormID(signature);
+            const auto enchantmentFormID = GetSignatureEnchantmentFormID(signature);
+            if (!a_writer.Write(objectFormID) || !a_writer.Write(enchantmentFormID)) {
+                return { CodecError::kSignature, index, static_cast<std::uint64_t>(signature) };
+            }
+            ++index;
+        }
+
+        if (!a_writer.Write(a_link.journalID) || !a_writer.Write(a_link.baseToken)) {
+            return { CodecError::kJournalLink };
+        }
+
+        return {};
+    }
+
+    CodecResult ReadMarkRecord(RecordReader& a_reader, std::uint32_t a_version, MarkSet& a_marks, JournalLink& a_link)
+    {
+        if (a_version >= 4) {
+            if (const auto result = ReadMarkContainers(a_reader, a_marks); !result) {
+                return result;
+            }
+        } else if (const auto result = ReadFlatMarkKeys(a_reader, a_marks); !result) {
+            return result;
+        }
+
+        if (a_version >= 2) {
+            std::uint32_t signatureCount = 0;
+            if (!a_reader.Read(signatureCount)) {
+                return { CodecError::kSignatureCount };
+            }
+
+            for (std::uint32_t i = 0; i < signatureCount; ++i) {
+                std::uint32_t objectFormID = 0;
+                std::uint32_t enchantmentFormID = 0;
+                if (!a_reader.Read(objectFormID) || !a_reader.Read(enchantmentFormID)) {
+                    return { CodecError::kSignature, i };
+                }
+
+                a_marks.signatures.insert(MakeMarkSignature(objectFormID, enchantmentFormID));
+            }
+        }
+
+        if (a_version >= 3) {
+            if (!a_reader.Read(a_link.journalID) || !a_reader.Read(a_link.baseToken)) {
+                return { CodecError::kJournalLink };
+            }
+        }
+
+        return {};
+    }
+
+    CodecResult WriteLocationRecord(RecordWriter& a_writer, std::span<const MarkLocationIndex::Entry> a_entries)
+    {
+        if (!a_writer.Write(static_cast<std::uint32_t>(a_entries.size()))) {
+            return { CodecError::kLocationCount };
+        }
+
+        std::uint32_t index = 0;
+        for (const auto& entry : a_entries) {
+            MarkLocationRecord record;
+            record.key = entry.key;
+            record.ownerFormID = entry.location.ownerFormID;
+            record.kind = entry.location.kind;
+            if (!a_writer.Write(record)) {
+                return { CodecError::kLocation, index, entry.key };
+            }
+            ++index;
+        }
+        return {};
+    }
+
+    CodecResult ReadLocationRecord(
+        RecordReader& a_reader,
+        std::uint32_t a_version,
+        std::uint32_t a_length,
+        std::vector<MarkLocationRecord>& a_records)
+    {
+        a_records.clear();
+        std::uint32_t count = 0;
+        if (a_version < 1 || a_length < sizeof(count) || !a_reader.Read(count)) {
+            return { CodecError::kLocationCount };
+        }
+        if (count > (a_length - sizeof(count)) / sizeof(MarkLocationRecord)) {
+            return { CodecError::kLocationCount, 0, count };
+        }
+
+        a_records.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            MarkLocationRecord record;
+            if (!a_reader.Read(record) || record.kind > MarkLocationKind::kWorld) {
+                return { CodecError::kLocation, i };
+            }
+            a_records.push_back(record);
+        }
+        return {};
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "mark_location.h"
+#include "mark_store.h"
+
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    constexpr std::uint32_t kSerializationRecordType = 'MARK';
+    constexpr std::uint32_t kSerializationVersion = 4;
+    constexpr std::uint32_t kLocationRecordType = 'MLOC';
+    constexpr std::uint32_t kLocationRecordVersion = 1;
+
+    class RecordWriter
+    {
+    public:
+        virtual ~RecordWriter() = default;
+
+        [[nodiscard]] virtual bool WriteBytes(const void* a_data, std::uint32_t a_size) = 0;
+
+        template <class T>
+            requires std::is_trivially_copyable_v<T>
+        [[nodiscard]] bool Write(const T& a_value)
+        {
+            return WriteBytes(&a_value, sizeof(T));
+        }
+    };
+
+    class RecordReader
+    {
+    public:
+        virtual ~RecordReader() = default;
+
+        [[nodiscard]] virtual bool ReadBytes(void* a_data, std::uint32_t a_size) = 0;
+
+        template <class T>
+            requires std::is_trivially_copyable_v<T>
+        [[nodiscard]] bool Read(T& a_value)
+        {
+            return ReadBytes(&a_value, sizeof(T));
+        }
+    };
+
+    struct JournalLink
+    {
+        std::uint64_t journalID{ 0 };
+        std::uint64_t baseToken{ 0 };
+    };
+
+    // Precedes each unique-ID container in a version 4+ record; followed by `count` 16-bit IDs
+    // (kArray) or UniqueIDContainer::kBitmapWords 64-bit words (kBitmap), as held in memory.
+    struct MarkContainerHeader
+    {
+        std::uint32_t baseID{ 0 };
+        UniqueIDContainer::Kind kind{ UniqueIDContainer::Kind::kArray };
+        std::uint16_t reserved{ 0 };
+        std::uint32_t count{ 0 };
+    };
+    static_assert(sizeof(MarkContainerHeader) == 12);
+
+    // One entry of the 'MLOC' record. ownerFormID is saved as-is; the loader resolves it.
+    struct MarkLocationRecord
+    {
+        std::uint64_t key{ 0 };
+        std::uint32_t ownerFormID{ 0 };
+        MarkLocationKind kind{ MarkLocationKind::kContainer };
+        std::uint8_t reserved[3]{};
+    };
+    static_assert(sizeof(MarkLocationRecord) == 16);
+
+    enum class CodecError : std::uint8_t
+    {
+        kNone,
+        kKeyCount,
+        kKey,
+        kContainerCount,
+        kContainer,
+        kSignatureCount,
+        kSignature,
+        kJournalLink,
+        kLocationCount,
+        kLocation
+    };
+
+    struct CodecResult
+    {
+        CodecError error{ CodecError::kNone };
+        std::uint32_t index{ 0 };
+        std::uint64_t value{ 0 };
+
+        [[nodiscard]] explicit operator bool() const noexcept { return error == CodecError::kNone; }
+    };
+
+    // Body of the 'MARK' record: the unique-ID marks, signature count, signature FormID pairs, and
+    // (version 3+) the journal link. Versions 1-3 store the marks as a key count and flat keys;
+    // version 4 stores a container count and each MarkKeySet container (header, then payload).
+    [[nodiscard]] CodecResult WriteMarkRecord(RecordWriter& a_writer, const MarkSet& a_marks, const JournalLink& a_link);
+    [[nodiscard]] CodecResult ReadMarkRecord(RecordReader& a_reader, std::uint32_t a_version, MarkSet& a_marks, JournalLink& a_link);
+
+    // Body of the 'MLOC' record: an entry count, then MarkLocationRecord entries sorted by key.
+    // a_length is the record size from the co-save; a count that cannot fit in it is rejected
+    // before anything is allocated for it.
+    [[nodiscard]] CodecResult WriteLocationRecord(RecordWriter& a_writer, std::span<const MarkLocationIndex::Entry> a_entries);
+    [[nodiscard]] CodecResult ReadLocationRecord(
+        RecordReader& a_reader,
+        std::uint32_t a_version,
+        std::uint32_t a_length,
+        std::vector<MarkLocationRecord>& a_records);
+}
@@ -0,0 +1,145 @@
+#include "confirm_flow.h"
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        // Deadline treats 0 as "not armed", so timestamps are stored off by one.
+        [[nodiscard]] constexpr std::uint32_t StampOf(std::uint32_t a_nowMs) noexcept
+        {
+            return a_nowMs + 1;
+        }
+    }
+
+    ConfirmFlow::ConfirmFlow() noexcept :
+        _forceHideWindow(3000, kForceHidePercentile, kWindowHeadroomPercent),
+        _suppressInputWindow(1500, kWindowPercentile, kWindowHeadroomPercent),
+        _allowNoDataWindow(250, kWindowPercentile, kWindowHeadroomPercent),
+        _confirmDebounceWindow(600, kWindowPercentile, kWindowHeadroomPercent)
+    {}
+
+    void ConfirmFlow::Configure(const ConfirmWindowBounds& a_bounds)
+    {
+        _forceHideWindow.SetBounds(a_bounds.forceHideMinMs, a_bounds.forceHideMaxMs);
+        _suppressInputWindow.SetBounds(a_bounds.suppressInputMinMs, a_bounds.suppressInputMaxMs);
+        _allowNoDataWindow.SetBounds(a_bounds.allowNoDataMinMs, a_bounds.allowNoDataMaxMs);
+        _confirmDebounceWindow.SetBounds(a_bounds.confirmDebounceMinMs, a_bounds.confirmDebounceMaxMs);
+    }
+
+    bool ConfirmFlow::TryBegin(std::uint32_t a_nowMs)
+    {
+        std::scoped_lock lk(_beginLock);
+        if (IsBusy() || _nextAllowed.IsPending(a_nowMs)) {
+            return false;
+        }
+
+        _open.store(true, std::memory_order_release);
+        _queued.store(true, std::memory_order_release);
+        _nextAllowed.Arm(a_nowMs, _confirmDebounceWindow.Current());
+        _closedAtMs.store(0, std::memory_order_release);
+        _swallowedWhileOpen.store(false, std::memory_order_release);
+        return true;
+    }
+
+    bool ConfirmFlow::Abort() noexcept
+    {
+        _open.store(false, std::memory_order_release);
+        _queued.store(false, std::memory_order_release);
+        _onMenu.store(false, std::memory_order_release);
+        return _swallowedWhileOpen.exchange(false, std::memory_order_acq_rel);
+    }
+
+    void ConfirmFlow::OnQueued(std::uint32_t a_nowMs)
+    {
+        _allowNoData.Arm(a_nowMs, _allowNoDataWindow.Current());
+        _showingOurs.store(true, std::memory_order_release);
+        _queuedAtMs.store(StampOf(a_nowMs), std::memory_order_release);
+        _queued.store(false, std::memory_order_release);
+    }
+
+    void ConfirmFlow::OnClosed(std::uint32_t a_nowMs)
+    {
+        _open.store(false, std::memory_order_release);
+        _onMenu.store(false, std::memory_order_release);
+        _showingOurs.store(false, std::memory_order_release);
+        _allowNoData.Clear();
+        _forceHide.Arm(a_nowMs, _forceHideWindow.Current());
+        _suppressInput.Arm(a_nowMs, _suppressInputWindow.Current());
+        _closedAtMs.store(StampOf(a_nowMs), std::memory_order_release);
+    }
+
+    void ConfirmFlow::OnMessageBoxData(bool a_ours) noexcept
+    {
+        if (a_ours) {
+            _allowNoData.Clear();
+            _onMenu.store(IsOpen(), std::memory_order_release);
+        }
+        _showingOurs.store(a_ours, std::memory_order_release);
+    }
+
+    bool ConfirmFlow::OnMessageBoxClosed() noexcept
+    {
+        return _onMenu.exchange(false, std::memory_order_acq_rel) && IsOpen();
+    }
+
+    std::optional<std::uint32_t> ConfirmFlow::OnMessageBoxSuppressed(std::uint32_t a_nowMs)
+    {
+        if (IsOpen()) {
+            _swallowedWhileOpen.store(true, std::memory_order_release);
+        }
+        return RecordPromptLatency(a_nowMs);
+    }
+
+    std::optional<std::uint32_t> ConfirmFlow::OnMessageBoxCreated(std::uint32_t a_nowMs)
+    {
+        if (!IsShowingOurs()) {
+            (void)RecordPromptLatency(a_nowMs);
+            return std::nullopt;
+        }
+
+        const auto queuedAt = _queuedAtMs.exchange(0, std::memory_order_acq_rel);
+        if (queuedAt == 0) {
+            return std::nullopt;
+        }
+
+        const auto latency = StampOf(a_nowMs) - queuedAt;
+        _allowNoDataWindow.Record(latency);
+        _confirmDebounceWindow.Record(latency);
+        _sampled.store(true, std::memory_order_release);
+        return latency;
+    }
+
+    std::optional<std::uint32_t> ConfirmFlow::RecordPromptLatency(std::uint32_t a_nowMs)
+    {
+        const auto closedAt = _closedAtMs.exchange(0, std::memory_order_acq_rel);
+        if (closedAt == 0) {
+            return std::nullopt;
+        }
+
+        // Prompts later than the force-hide upper bound belong to something else.
+        const auto latency = StampOf(a_nowMs) - closedAt;
+        if (latency > _forceHideWindow.MaxMs()) {
+            return std::nullopt;
+        }
+
+        _forceHideWindow.Record(latency);
+        _suppressInputWindow.Record(latency);
+        _sampled.store(true, std::memory_order_release);
+        return latency;
+    }
+
+    bool ConfirmFlow::ShouldSuppressMessageBox(std::uint32_t a_nowMs) noexcept
+    {
+        return IsBusy() || _forceHide.IsActive(a_nowMs);
+    }
+
+    bool ConfirmFlow::ShouldAllowNoData(std::uint32_t a_nowMs) noexcept
+    {
+        return _allowNoData.IsActive(a_nowMs);
+    }
+
+    bool ConfirmFlow::ShouldSuppressInput(std::uint32_t a_nowMs) noexcept
+    {
+        return _suppressInput.IsActive(a_nowMs);
+    }
+}
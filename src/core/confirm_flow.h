@@ -0,0 +1,116 @@
+#pragma once
+
+#include "adaptive_window.h"
+#include "deadline.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace RFAB::Disenchant
+{
+    // INI bounds for the adaptive windows, in ms.
+    struct ConfirmWindowBounds
+    {
+        std::uint32_t forceHideMinMs{ 500 };
+        std::uint32_t forceHideMaxMs{ 5000 };
+        std::uint32_t suppressInputMinMs{ 250 };
+        std::uint32_t suppressInputMaxMs{ 3000 };
+        std::uint32_t allowNoDataMinMs{ 100 };
+        std::uint32_t allowNoDataMaxMs{ 1000 };
+        std::uint32_t confirmDebounceMinMs{ 200 };
+        std::uint32_t confirmDebounceMaxMs{ 1500 };
+    };
+
+    // Timing state of the remove confirmation, shared by the hotkey, the UI task that queues the
+    // dialog, its callback and the MessageBoxMenu hooks. Every call takes the game's run-time
+    // clock in ms instead of reading it, so the same state machine runs under a virtual clock
+    // off-game. Safe to call from any thread.
+    //
+    // Window lengths follow our own dialog's measured latency: Run of the callback to the first
+    // message box suppressed after it (the vanilla prompt), and queueing of the confirmation to
+    // its PostCreate. The fallbacks are the old fixed windows, used until enough samples exist.
+    // A prompt that outlives the force-hide window is only ever seen once, so that window is
+    // sized from the slowest recent prompt, including ones that got through, not a percentile.
+    class ConfirmFlow
+    {
+    public:
+        static constexpr std::uint32_t kWindowPercentile = 95;
+        static constexpr std::uint32_t kForceHidePercentile = 100;
+        static constexpr std::uint32_t kWindowHeadroomPercent = 150;
+
+        ConfirmFlow() noexcept;
+        ConfirmFlow(const ConfirmFlow&) = delete;
+        ConfirmFlow& operator=(const ConfirmFlow&) = delete;
+
+        void Configure(const ConfirmWindowBounds& a_bounds);
+
+        // Hotkey: claims the confirmation slot unless one is open, queued, or debounced.
+        [[nodiscard]] bool TryBegin(std::uint32_t a_nowMs);
+        // The claimed confirmation could not be shown; frees the slot (the debounce stays).
+        // True when a foreign show was swallowed meanwhile, leaving MessageBoxMenu open for data
+        // that is no longer coming: the caller has to force-hide it.
+        [[nodiscard]] bool Abort() noexcept;
+        // Right before our MessageBoxData is queued.
+        void OnQueued(std::uint32_t a_nowMs);
+        // Our callback ran, whichever button: arms the vanilla prompt and input suppression.
+        void OnClosed(std::uint32_t a_nowMs);
+
+        // A show-like message with MessageBoxData was let through to MessageBoxMenu. Swallowed
+        // messages never reach the menu and must not be reported: a foreign prompt dropped while
+        // ours waits in the queue would otherwise get ours force-hidden at PostCreate.
+        void OnMessageBoxData(bool a_ours) noexcept;
+        // A MessageBoxMenu message or display was swallowed. Returns the Run-to-hide latency when
+        // this is the first suppression since OnClosed and it fell within the force-hide bound.
+        std::optional<std::uint32_t> OnMessageBoxSuppressed(std::uint32_t a_nowMs);
+        // PostCreate ran for a box that was let through. Returns the queue-to-display latency
+        // when it was our confirmation; a foreign box shown soon after ours closed is recorded
+        // as a prompt the force-hide window missed.
+        std::optional<std::uint32_t> OnMessageBoxCreated(std::uint32_t a_nowMs);
+        // MessageBoxMenu closed. True when our confirmation was on the menu and went away without
+        // its callback running (force-hidden or closed by the game); the caller must Abort().
+        [[nodiscard]] bool OnMessageBoxClosed() noexcept;
+
+        // Claimed and not yet answered. A foreign message swallowed meanwhile must not force-hide
+        // the menu: our data is in or on its way to the same MessageBoxMenu, and the force-hide
+        // would land after it.
+        [[nodiscard]] bool IsOpen() const noexcept { return _open.load(std::memory_order_acquire); }
+        [[nodiscard]] bool IsBusy() const noexcept { return IsOpen() || _queued.load(std::memory_order_acquire); }
+        [[nodiscard]] bool IsShowingOurs() const noexcept { return _showingOurs.load(std::memory_order_acquire); }
+
+        // Foreign message boxes are swallowed while ours is pending and for the force-hide window.
+        [[nodiscard]] bool ShouldSuppressMessageBox(std::uint32_t a_nowMs) noexcept;
+        [[nodiscard]] bool ShouldAllowNoData(std::uint32_t a_nowMs) noexcept;
+        [[nodiscard]] bool ShouldSuppressInput(std::uint32_t a_nowMs) noexcept;
+
+        [[nodiscard]] const AdaptiveWindow& ForceHideWindow() const noexcept { return _forceHideWindow; }
+        [[nodiscard]] const AdaptiveWindow& SuppressInputWindow() const noexcept { return _suppressInputWindow; }
+        [[nodiscard]] const AdaptiveWindow& AllowNoDataWindow() const noexcept { return _allowNoDataWindow; }
+        [[nodiscard]] const AdaptiveWindow& ConfirmDebounceWindow() const noexcept { return _confirmDebounceWindow; }
+        // True once after any window took a new sample.
+        [[nodiscard]] bool TakeSampled() noexcept { return _sampled.exchange(false, std::memory_order_acq_rel); }
+
+    private:
+        // Run-to-prompt sample for the first box seen after OnClosed, hidden or not.
+        std::optional<std::uint32_t> RecordPromptLatency(std::uint32_t a_nowMs);
+
+        std::mutex _beginLock;
+        std::atomic_bool _open{ false };
+        std::atomic_bool _queued{ false };
+        std::atomic_bool _showingOurs{ false };
+        std::atomic_bool _onMenu{ false };
+        std::atomic_bool _swallowedWhileOpen{ false };
+        Deadline _forceHide;
+        Deadline _allowNoData;
+        Deadline _suppressInput;
+        Deadline _nextAllowed;
+        AdaptiveWindow _forceHideWindow;
+        AdaptiveWindow _suppressInputWindow;
+        AdaptiveWindow _allowNoDataWindow;
+        AdaptiveWindow _confirmDebounceWindow;
+        std::atomic<std::uint32_t> _closedAtMs{ 0 };
+        std::atomic<std::uint32_t> _queuedAtMs{ 0 };
+        std::atomic_bool _sampled{ false };
+    };
+}
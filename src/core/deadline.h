@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace RFAB::Disenchant
+{
+    // A suppression window measured on the game's millisecond run-time clock.
+    // An expired window clears itself the first time it is queried past its end.
+    class Deadline
+    {
+    public:
+        void Arm(std::uint32_t a_nowMs, std::uint32_t a_durationMs) noexcept
+        {
+            _untilMs.store(a_nowMs + a_durationMs, std::memory_order_release);
+        }
+
+        void Clear() noexcept
+        {
+            _untilMs.store(0, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool IsActive(std::uint32_t a_nowMs) noexcept
+        {
+            const auto until = _untilMs.load(std::memory_order_acquire);
+            if (until == 0) {
+                return false;
+            }
+
+            if (a_nowMs > until) {
+                _untilMs.store(0, std::memory_order_release);
+                return false;
+            }
+
+            return true;
+        }
+
+        // True while a_nowMs has not yet reached the armed time; never clears.
+        [[nodiscard]] bool IsPending(std::uint32_t a_nowMs) const noexcept
+        {
+            const auto until = _untilMs.load(std::memory_order_acquire);
+            return until != 0 && a_nowMs < until;
+        }
+
+        [[nodiscard]] std::uint32_t GetUntil() const noexcept
+        {
+            return _untilMs.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<std::uint32_t> _untilMs{ 0 };
+    };
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "mark_key.h"
+#include "mark_store.h"
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace RFAB::Disenchant
+{
+    // Adapter over an inventory entry type. The game provides one over RE::InventoryEntryData;
+    // host tools provide stand-ins so the same lookups can run off-game.
+    //
+    // ForEachUniqueKey visits the MakeMarkKey of every ExtraUniqueID on the entry, in extra-list
+    // order, and stops early once the visitor returns true.
+    template <class T>
+    concept EntryTraits = requires(typename T::Entry* a_entry, bool (*a_visitor)(std::uint64_t)) {
+        { T::HasExtraEnchantment(a_entry) } -> std::same_as<bool>;
+        { T::HasAnyEnchantment(a_entry) } -> std::same_as<bool>;
+        { T::GetSignature(a_entry) } -> std::same_as<std::optional<MarkSignature>>;
+        T::ForEachUniqueKey(a_entry, a_visitor);
+    };
+
+    template <EntryTraits T>
+    [[nodiscard]] std::optional<std::uint64_t> GetAnyEntryKey(typename T::Entry* a_entry)
+    {
+        std::optional<std::uint64_t> result;
+        if (a_entry) {
+            T::ForEachUniqueKey(a_entry, [&](std::uint64_t a_key) {
+                result = a_key;
+                return true;
+            });
+        }
+        return result;
+    }
+
+    template <EntryTraits T>
+    [[nodiscard]] bool EntryHasKey(typename T::Entry* a_entry, std::uint64_t a_key)
+    {
+        bool found = false;
+        if (a_entry) {
+            T::ForEachUniqueKey(a_entry, [&](std::uint64_t a_candidate) {
+                found = a_candidate == a_key;
+                return found;
+            });
+        }
+        return found;
+    }
+
+    template <EntryTraits T>
+    [[nodiscard]] std::optional<std::uint64_t> FindMarkedKeyInEntry(const MarkStore& a_store, typename T::Entry* a_entry)
+    {
+        std::optional<std::uint64_t> result;
+        if (a_entry) {
+            T::ForEachUniqueKey(a_entry, [&](std::uint64_t a_key) {
+                if (a_store.IsMarked(a_key)) {
+                    result = a_key;
+                    return true;
+                }
+                return false;
+            });
+        }
+        return result;
+    }
+
+    // An entry counts as marked when one of its unique IDs or its signature is in the store, or
+    // when it carries a player-applied ExtraEnchantment at all. a_markedKey only ever receives a
+    // key that is itself marked; entries matched any other way report their signature.
+    template <EntryTraits T>
+    [[nodiscard]] bool IsEntryMarked(
+        const MarkStore& a_store,
+        typename T::Entry* a_entry,
+        std::optional<std::uint64_t>* a_markedKey = nullptr,
+        std::optional<MarkSignature>* a_markedSignature = nullptr)
+    {
+        if (a_markedKey) {
+            *a_markedKey = std::nullopt;
+        }
+
+        if (a_markedSignature) {
+            *a_markedSignature = std::nullopt;
+        }
+
+        if (!a_entry) {
+            return false;
+        }
+
+        const auto key = FindMarkedKeyInEntry<T>(a_store, a_entry);
+        if (key) {
+            if (a_markedKey) {
+                *a_markedKey = key;
+            }
+            return true;
+        }
+
+        const auto signature = T::GetSignature(a_entry);
+        if ((signature && a_store.IsMarked(*signature)) || T::HasExtraEnchantment(a_entry)) {
+            if (a_markedSignature) {
+                *a_markedSignature = signature;
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    // Inventory scans. a_project maps an element of a_inventory to a T::Entry* (or nullptr).
+    template <EntryTraits T, class R, class Proj = std::identity>
+    [[nodiscard]] typename T::Entry* FindEntryByKey(R&& a_inventory, std::uint64_t a_key, Proj a_project = {})
+    {
+        for (auto&& element : a_inventory) {
+            auto* entry = std::invoke(a_project, element);
+            if (entry && EntryHasKey<T>(entry, a_key)) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    template <EntryTraits T, class R, class Proj = std::identity>
+    [[nodiscard]] typename T::Entry* FindEntryBySignature(R&& a_inventory, MarkSignature a_signature, Proj a_project = {})
+    {
+        for (auto&& element : a_inventory) {
+            auto* entry = std::invoke(a_project, element);
+            if (!entry) {
+                continue;
+            }
+
+            const auto signature = T::GetSignature(entry);
+            if (signature && *signature == a_signature) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+}
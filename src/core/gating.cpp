@@ -0,0 +1,141 @@
+#include "gating.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        [[nodiscard]] bool EqualsNoCase(std::string_view a_lhs, std::string_view a_rhs) noexcept
+        {
+            return a_lhs.size() == a_rhs.size() &&
+                   std::equal(a_lhs.begin(), a_lhs.end(), a_rhs.begin(), [](char a_l, char a_r) {
+                       return std::tolower(static_cast<unsigned char>(a_l)) == std::tolower(static_cast<unsigned char>(a_r));
+                   });
+        }
+    }
+
+    bool IsLearnControlName(std::string_view a_control) noexcept
+    {
+        return a_control == "Accept" || a_control == "accept" || a_control == "Click" ||
+               a_control == "click" || a_control == "YButton" || a_control == "yButton" ||
+               a_control == "Activate" || a_control == "activate" || a_control == "Equip" ||
+               a_control == "equip";
+    }
+
+    bool IsMouseSelectControlName(std::string_view a_control) noexcept
+    {
+        return EqualsNoCase(a_control, "RightEquip") || EqualsNoCase(a_control, "LeftEquip");
+    }
+
+    bool ShouldSuppressVanillaDisenchantPrompt(const SelectionTargets& a_targets) noexcept
+    {
+        if (a_targets.AnyMarked()) {
+            return true;
+        }
+
+        return a_targets.AnyPresent() && !a_targets.ActiveHasEnchantment();
+    }
+
+    bool ShouldBlockVanillaDisenchant(const SelectionTargets& a_targets) noexcept
+    {
+        const auto staleSelectionNoEnchant =
+            (a_targets.resolved.present && !a_targets.resolved.hasEnchantment) ||
+            (a_targets.selected.present && !a_targets.selected.hasEnchantment) ||
+            (a_targets.highlighted.present && !a_targets.highlighted.hasEnchantment);
+        return a_targets.AnyMarked() || staleSelectionNoEnchant;
+    }
+
+    UserEventDecision DecideUserEvent(const UserEventInput& a_input) noexcept
+    {
+        UserEventDecision decision;
+        if (!a_input.inDisenchant) {
+            return decision;
+        }
+
+        if (a_input.suppressInput && a_input.isLearn) {
+            decision.consume = true;
+            return decision;
+        }
+
+        const auto& targets = a_input.targets;
+        const auto highlightedStale = targets.highlighted.present && !targets.highlighted.hasEnchantment;
+
+        if (targets.AnyMarked()) {
+            decision.forceEnableMarkedRows = true;
+
+            if (a_input.isLearn) {
+                decision.consume = true;
+                return decision;
+            }
+
+            if (a_input.physicalLMB || a_input.isMouseSelect) {
+                decision.consume = true;
+                if (highlightedStale) {
+                    return decision;
+                }
+
+                decision.selectHighlighted = a_input.highlightedRow;
+                decision.showConfirm = !a_input.suppressConfirm;
+                return decision;
+            }
+        }
+
+        if (a_input.isMouseSelect) {
+            decision.consume = true;
+            decision.selectHighlighted = a_input.highlightedRow && !highlightedStale;
+            return decision;
+        }
+
+        if (a_input.isLearn && !targets.AnyMarked() && targets.AnyPresent() && !targets.ActiveHasEnchantment()) {
+            decision.consume = true;
+        }
+
+        return decision;
+    }
+
+    ActivateDecision DecideActivate(const ActivateInput& a_input) noexcept
+    {
+        if (!a_input.inDisenchant) {
+            return ActivateDecision::kPassThrough;
+        }
+
+        if (a_input.suppressInput || !a_input.hasEnchantment) {
+            return ActivateDecision::kIgnore;
+        }
+
+        return a_input.marked ? ActivateDecision::kSelectMarked : ActivateDecision::kPassThrough;
+    }
+
+    RowDecoration DecideRowDecoration(const RowInput& a_input) noexcept
+    {
+        if (!a_input.inDisenchantList || !a_input.hasData) {
+            return RowDecoration::kNone;
+        }
+
+        if (!a_input.hasEnchantment) {
+            return RowDecoration::kForceDisabled;
+        }
+
+        return a_input.marked ? RowDecoration::kForceEnabled : RowDecoration::kNone;
+    }
+
+    bool ShouldForceHideMessageBoxMessage(const MessageBoxInput& a_input) noexcept
+    {
+        if (!a_input.showLike || a_input.isOurConfirm) {
+            return false;
+        }
+
+        if (!a_input.hasData && a_input.allowNoData) {
+            return false;
+        }
+
+        return a_input.suppress;
+    }
+
+    bool ShouldForceHideMessageBoxDisplay(bool a_suppress, bool a_allow) noexcept
+    {
+        return a_suppress && !a_allow;
+    }
+}
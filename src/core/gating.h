@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace RFAB::Disenchant
+{
+    // What the hooks know about one of the candidate disenchant targets (the menu's selected
+    // item, the highlighted row, or the resolved selection).
+    struct TargetState
+    {
+        bool present{ false };
+        bool marked{ false };
+        bool hasEnchantment{ false };
+    };
+
+    struct SelectionTargets
+    {
+        TargetState selected;
+        TargetState highlighted;
+        TargetState resolved;
+
+        [[nodiscard]] bool AnyMarked() const noexcept
+        {
+            return selected.marked || highlighted.marked || resolved.marked;
+        }
+
+        [[nodiscard]] bool AnyPresent() const noexcept
+        {
+            return selected.present || highlighted.present || resolved.present;
+        }
+
+        // Highlighted row wins over the selected item, which wins over the resolved selection.
+        [[nodiscard]] bool ActiveHasEnchantment() const noexcept
+        {
+            return highlighted.present ? highlighted.hasEnchantment :
+                   (selected.present ? selected.hasEnchantment : resolved.hasEnchantment);
+        }
+    };
+
+    struct UserEventInput
+    {
+        bool inDisenchant{ false };
+        bool suppressInput{ false };
+        bool suppressConfirm{ false };
+        bool isLearn{ false };
+        bool isMouseSelect{ false };
+        bool physicalLMB{ false };
+        bool highlightedRow{ false };
+        SelectionTargets targets;
+    };
+
+    struct UserEventDecision
+    {
+        bool forceEnableMarkedRows{ false };
+        bool selectHighlighted{ false };
+        bool showConfirm{ false };
+        bool consume{ false };
+
+        [[nodiscard]] bool operator==(const UserEventDecision&) const = default;
+    };
+
+    enum class ActivateDecision : std::uint8_t
+    {
+        kPassThrough,
+        kIgnore,
+        kSelectMarked
+    };
+
+    struct ActivateInput
+    {
+        bool inDisenchant{ false };
+        bool suppressInput{ false };
+        bool hasEnchantment{ false };
+        bool marked{ false };
+    };
+
+    enum class RowDecoration : std::uint8_t
+    {
+        kNone,
+        kForceEnabled,
+        kForceDisabled
+    };
+
+    struct RowInput
+    {
+        bool inDisenchantList{ false };
+        bool hasData{ false };
+        bool marked{ false };
+        bool hasEnchantment{ false };
+    };
+
+    struct MessageBoxInput
+    {
+        bool showLike{ false };
+        bool hasData{ false };
+        bool isOurConfirm{ false };
+        bool suppress{ false };
+        bool allowNoData{ false };
+    };
+
+    [[nodiscard]] bool IsLearnControlName(std::string_view a_control) noexcept;
+    [[nodiscard]] bool IsMouseSelectControlName(std::string_view a_control) noexcept;
+
+    [[nodiscard]] bool ShouldSuppressVanillaDisenchantPrompt(const SelectionTargets& a_targets) noexcept;
+    [[nodiscard]] bool ShouldBlockVanillaDisenchant(const SelectionTargets& a_targets) noexcept;
+    [[nodiscard]] UserEventDecision DecideUserEvent(const UserEventInput& a_input) noexcept;
+    [[nodiscard]] ActivateDecision DecideActivate(const ActivateInput& a_input) noexcept;
+    // Rows whose enchantment is already gone are forced disabled; marked rows are forced enabled.
+    [[nodiscard]] RowDecoration DecideRowDecoration(const RowInput& a_input) noexcept;
+
+    // True when a show-like MessageBoxMenu message should be swallowed and the menu force-hidden.
+    [[nodiscard]] bool ShouldForceHideMessageBoxMessage(const MessageBoxInput& a_input) noexcept;
+    // True when PreDisplay/PostCreate should force-hide instead of running vanilla.
+    [[nodiscard]] bool ShouldForceHideMessageBoxDisplay(bool a_suppress, bool a_allow) noexcept;
+}
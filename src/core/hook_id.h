@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace RFAB::Disenchant
+{
+    enum class HookId : std::uint8_t
+    {
+        kProcessUserEvent,
+        kItemSetData,
+        kItemActivate,
+        kMessageBoxProcessMessage,
+        kMessageBoxPreDisplay,
+        kMessageBoxPostCreate,
+        kCraftRun,
+        kDisenchantRun,
+        kRemoveConfirmRun,
+
+        kTotal
+    };
+
+    inline constexpr auto kHookCount = static_cast<std::size_t>(HookId::kTotal);
+
+    inline constexpr std::array<std::string_view, kHookCount> kHookNames{
+        "ProcessUserEvent",
+        "ItemChangeEntry::SetData",
+        "ItemChangeEntry::Activate",
+        "MessageBoxMenu::ProcessMessage",
+        "MessageBoxMenu::PreDisplay",
+        "MessageBoxMenu::PostCreate",
+        "EnchantMenuCraftCallback::Run",
+        "EnchantMenuDisenchantCallback::Run",
+        "RemoveConfirmCallback::Run"
+    };
+
+    [[nodiscard]] constexpr std::string_view GetHookName(HookId a_hook) noexcept
+    {
+        const auto index = static_cast<std::size_t>(a_hook);
+        return index < kHookCount ? kHookNames[index] : std::string_view{ "<unknown>" };
+    }
+}
@@ -0,0 +1,352 @@
+#include "hook_trace.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        constexpr std::uint32_t kTraceMagic = 'RFDT';
+        constexpr std::uint32_t kTraceVersion = 1;
+        constexpr std::size_t kRecordSize = 24;
+        constexpr std::size_t kFlushThreshold = 64 * 1024;
+
+        [[nodiscard]] std::uint32_t PackBits(std::initializer_list<bool> a_bits) noexcept
+        {
+            std::uint32_t packed = 0;
+            std::uint32_t bit = 0;
+            for (const auto value : a_bits) {
+                packed |= static_cast<std::uint32_t>(value) << bit++;
+            }
+            return packed;
+        }
+
+        [[nodiscard]] constexpr bool Bit(std::uint32_t a_bits, std::uint32_t a_index) noexcept
+        {
+            return ((a_bits >> a_index) & 1u) != 0;
+        }
+
+        [[nodiscard]] std::uint32_t PackTarget(const TargetState& a_target) noexcept
+        {
+            return PackBits({ a_target.present, a_target.marked, a_target.hasEnchantment });
+        }
+
+        [[nodiscard]] TargetState UnpackTarget(std::uint32_t a_bits) noexcept
+        {
+            return { Bit(a_bits, 0), Bit(a_bits, 1), Bit(a_bits, 2) };
+        }
+
+        template <class T>
+        void Store(std::byte* a_dst, std::size_t a_offset, T a_value) noexcept
+        {
+            std::memcpy(a_dst + a_offset, &a_value, sizeof(T));
+        }
+
+        template <class T>
+        [[nodiscard]] T Load(const std::byte* a_src, std::size_t a_offset) noexcept
+        {
+            T value;
+            std::memcpy(&value, a_src + a_offset, sizeof(T));
+            return value;
+        }
+    }
+
+    std::uint32_t PackTraceInput(const SelectionTargets& a_targets) noexcept
+    {
+        return PackTarget(a_targets.selected) | (PackTarget(a_targets.highlighted) << 3u) | (PackTarget(a_targets.resolved) << 6u);
+    }
+
+    SelectionTargets UnpackSelectionTargets(std::uint32_t a_bits) noexcept
+    {
+        return { UnpackTarget(a_bits & 7u), UnpackTarget((a_bits >> 3u) & 7u), UnpackTarget((a_bits >> 6u) & 7u) };
+    }
+
+    std::uint32_t PackTraceInput(const UserEventInput& a_input) noexcept
+    {
+        const auto flags = PackBits({ a_input.inDisenchant,
+            a_input.suppressInput,
+            a_input.suppressConfirm,
+            a_input.isLearn,
+            a_input.isMouseSelect,
+            a_input.physicalLMB,
+            a_input.highlightedRow });
+        return flags | (PackTraceInput(a_input.targets) << 8u);
+    }
+
+    UserEventInput UnpackUserEventInput(std::uint32_t a_bits) noexcept
+    {
+        UserEventInput input;
+        input.inDisenchant = Bit(a_bits, 0);
+        input.suppressInput = Bit(a_bits, 1);
+        input.suppressConfirm = Bit(a_bits, 2);
+        input.isLearn = Bit(a_bits, 3);
+        input.isMouseSelect = Bit(a_bits, 4);
+        input.physicalLMB = Bit(a_bits, 5);
+        input.highlightedRow = Bit(a_bits, 6);
+        input.targets = UnpackSelectionTargets(a_bits >> 8u);
+        return input;
+    }
+
+    std::uint32_t PackTraceInput(const ActivateInput& a_input) noexcept
+    {
+        return PackBits({ a_input.inDisenchant, a_input.suppressInput, a_input.hasEnchantment, a_input.marked });
+    }
+
+    ActivateInput UnpackActivateInput(std::uint32_t a_bits) noexcept
+    {
+        return { Bit(a_bits, 0), Bit(a_bits, 1), Bit(a_bits, 2), Bit(a_bits, 3) };
+    }
+
+    std::uint32_t PackTraceInput(const RowInput& a_input) noexcept
+    {
+        return PackBits({ a_input.inDisenchantList, a_input.hasData, a_input.marked, a_input.hasEnchantment });
+    }
+
+    RowInput UnpackRowInput(std::uint32_t a_bits) noexcept
+    {
+        return { Bit(a_bits, 0), Bit(a_bits, 1), Bit(a_bits, 2), Bit(a_bits, 3) };
+    }
+
+    std::uint32_t PackTraceInput(const MessageBoxInput& a_input) noexcept
+    {
+        return PackBits({ a_input.showLike, a_input.hasData, a_input.isOurConfirm, a_input.suppress, a_input.allowNoData });
+    }
+
+    MessageBoxInput UnpackMessageBoxInput(std::uint32_t a_bits) noexcept
+    {
+        return { Bit(a_bits, 0), Bit(a_bits, 1), Bit(a_bits, 2), Bit(a_bits, 3), Bit(a_bits, 4) };
+    }
+
+    std::uint32_t PackTraceDisplayInput(bool a_suppress, bool a_allow) noexcept
+    {
+        return PackBits({ a_suppress, a_allow });
+    }
+
+    std::uint32_t PackTraceDecision(const UserEventDecision& a_decision) noexcept
+    {
+        return PackBits({ a_decision.forceEnableMarkedRows, a_decision.selectHighlighted, a_decision.showConfirm, a_decision.consume });
+    }
+
+    UserEventDecision UnpackUserEventDecision(std::uint32_t a_bits) noexcept
+    {
+        return { Bit(a_bits, 0), Bit(a_bits, 1), Bit(a_bits, 2), Bit(a_bits, 3) };
+    }
+
+    TraceWriter::~TraceWriter()
+    {
+        Close();
+    }
+
+    bool TraceWriter::Open(const std::filesystem::path& a_path)
+    {
+        Close();
+
+        std::scoped_lock lk(_lock);
+#ifdef _WIN32
+        _file = ::_wfopen(a_path.c_str(), L"wb");
+#else
+        _file = std::fopen(a_path.c_str(), "wb");
+#endif
+        if (!_file) {
+            return false;
+        }
+
+        _buffer.clear();
+        _buffer.reserve(kFlushThreshold + kRecordSize + 256);
+        _controls.clear();
+
+        const std::uint32_t header[2]{ kTraceMagic, kTraceVersion };
+        Append(header, sizeof(header));
+        return true;
+    }
+
+    void TraceWriter::Close()
+    {
+        std::scoped_lock lk(_lock);
+        if (!_file) {
+            return;
+        }
+
+        FlushLocked();
+        std::fclose(_file);
+        _file = nullptr;
+    }
+
+    std::uint16_t TraceWriter::InternControl(std::string_view a_name)
+    {
+        if (a_name.empty()) {
+            return 0;
+        }
+
+        std::scoped_lock lk(_lock);
+        if (!_file) {
+            return 0;
+        }
+
+        const std::string name(a_name.substr(0, 255));
+        if (const auto it = _controls.find(name); it != _controls.end()) {
+            return it->second;
+        }
+
+        if (_controls.size() >= 0xFFFE) {
+            return 0;
+        }
+
+        const auto id = static_cast<std::uint16_t>(_controls.size() + 1);
+        _controls.emplace(name, id);
+
+        std::byte record[4];
+        Store(record, 0, TraceRecordKind::kControlName);
+        Store(record, 1, static_cast<std::uint8_t>(name.size()));
+        Store(record, 2, id);
+        Append(record, sizeof(record));
+        Append(name.data(), name.size());
+        return id;
+    }
+
+    void TraceWriter::WriteHook(const HookTraceEvent& a_event)
+    {
+        std::byte record[kRecordSize];
+        Store(record, 0, TraceRecordKind::kHook);
+        Store(record, 1, a_event.hook);
+        Store(record, 2, a_event.controlID);
+        Store(record, 4, a_event.durationNs);
+        Store(record, 8, a_event.timestampNs);
+        Store(record, 16, a_event.input);
+        Store(record, 20, a_event.decision);
+
+        std::scoped_lock lk(_lock);
+        if (_file) {
+            Append(record, sizeof(record));
+        }
+    }
+
+    void TraceWriter::WriteMarkDelta(const MarkDeltaEvent& a_event)
+    {
+        std::byte record[kRecordSize]{};
+        Store(record, 0, TraceRecordKind::kMarkDelta);
+        Store(record, 1, a_event.op);
+        Store(record, 8, a_event.timestampNs);
+        Store(record, 16, a_event.value);
+
+        std::scoped_lock lk(_lock);
+        if (_file) {
+            Append(record, sizeof(record));
+        }
+    }
+
+    void TraceWriter::Flush()
+    {
+        std::scoped_lock lk(_lock);
+        FlushLocked();
+    }
+
+    void TraceWriter::Append(const void* a_data, std::size_t a_size)
+    {
+        const auto* bytes = static_cast<const std::byte*>(a_data);
+        _buffer.insert(_buffer.end(), bytes, bytes + a_size);
+        if (_buffer.size() >= kFlushThreshold) {
+            FlushLocked();
+        }
+    }
+
+    void TraceWriter::FlushLocked()
+    {
+        if (_file && !_buffer.empty()) {
+            std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+            std::fflush(_file);
+        }
+        _buffer.clear();
+    }
+
+    TraceReader::~TraceReader()
+    {
+        if (_file) {
+            std::fclose(_file);
+        }
+    }
+
+    bool TraceReader::Open(const std::filesystem::path& a_path)
+    {
+        if (_file) {
+            std::fclose(_file);
+        }
+        _controls.assign(1, std::string{});
+
+#ifdef _WIN32
+        _file = ::_wfopen(a_path.c_str(), L"rb");
+#else
+        _file = std::fopen(a_path.c_str(), "rb");
+#endif
+        if (!_file) {
+            return false;
+        }
+
+        std::uint32_t header[2]{};
+        if (std::fread(header, sizeof(header), 1, _file) != 1 || header[0] != kTraceMagic || header[1] != kTraceVersion) {
+            std::fclose(_file);
+            _file = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool TraceReader::Next(TraceEvent& a_event)
+    {
+        while (_file) {
+            std::byte prefix[4];
+            if (std::fread(prefix, sizeof(prefix), 1, _file) != 1) {
+                return false;
+            }
+
+            const auto kind = Load<TraceRecordKind>(prefix, 0);
+            if (kind == TraceRecordKind::kControlName) {
+                const auto length = Load<std::uint8_t>(prefix, 1);
+                const auto id = Load<std::uint16_t>(prefix, 2);
+                std::string name(length, '\0');
+                if (length != 0 && std::fread(name.data(), length, 1, _file) != 1) {
+                    return false;
+                }
+                if (_controls.size() <= id) {
+                    _controls.resize(id + 1u);
+                }
+                _controls[id] = std::move(name);
+                continue;
+            }
+
+            std::byte record[kRecordSize];
+            std::memcpy(record, prefix, sizeof(prefix));
+            if (std::fread(record + sizeof(prefix), kRecordSize - sizeof(prefix), 1, _file) != 1) {
+                return false;
+            }
+
+            a_event.kind = kind;
+            if (kind == TraceRecordKind::kHook) {
+                a_event.hook.hook = Load<HookId>(record, 1);
+                a_event.hook.controlID = Load<std::uint16_t>(record, 2);
+                a_event.hook.durationNs = Load<std::uint32_t>(record, 4);
+                a_event.hook.timestampNs = Load<std::uint64_t>(record, 8);
+                a_event.hook.input = Load<std::uint32_t>(record, 16);
+                a_event.hook.decision = Load<std::uint32_t>(record, 20);
+                return true;
+            }
+
+            if (kind == TraceRecordKind::kMarkDelta) {
+                a_event.markDelta.op = Load<JournalOp>(record, 1);
+                a_event.markDelta.timestampNs = Load<std::uint64_t>(record, 8);
+                a_event.markDelta.value = Load<std::uint64_t>(record, 16);
+                return true;
+            }
+
+            return false;
+        }
+
+        return false;
+    }
+
+    std::string_view TraceReader::GetControlName(std::uint16_t a_id) const noexcept
+    {
+        return a_id < _controls.size() ? std::string_view{ _controls[a_id] } : std::string_view{};
+    }
+}
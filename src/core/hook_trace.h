@@ -0,0 +1,114 @@
+#pragma once
+
+#include "gating.h"
+#include "hook_id.h"
+#include "journal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    // Compact binary trace of hook invocations: one 24-byte record per hook entry or mark
+    // store change, plus a one-off record the first time each control name is seen.
+    enum class TraceRecordKind : std::uint8_t
+    {
+        kHook = 1,
+        kControlName = 2,
+        kMarkDelta = 3
+    };
+
+    struct HookTraceEvent
+    {
+        HookId hook{ HookId::kTotal };
+        std::uint16_t controlID{ 0 };
+        std::uint32_t durationNs{ 0 };
+        std::uint64_t timestampNs{ 0 };
+        std::uint32_t input{ 0 };
+        std::uint32_t decision{ 0 };
+    };
+
+    struct MarkDeltaEvent
+    {
+        JournalOp op{ JournalOp::kMarkKey };
+        std::uint64_t timestampNs{ 0 };
+        std::uint64_t value{ 0 };
+    };
+
+    struct TraceEvent
+    {
+        TraceRecordKind kind{ TraceRecordKind::kHook };
+        HookTraceEvent hook;
+        MarkDeltaEvent markDelta;
+    };
+
+    // Bit packing of the gating inputs and decisions, so the replay tool can rerun the exact
+    // decision a recorded hook made.
+    [[nodiscard]] std::uint32_t PackTraceInput(const SelectionTargets& a_targets) noexcept;
+    [[nodiscard]] std::uint32_t PackTraceInput(const UserEventInput& a_input) noexcept;
+    [[nodiscard]] std::uint32_t PackTraceInput(const ActivateInput& a_input) noexcept;
+    [[nodiscard]] std::uint32_t PackTraceInput(const RowInput& a_input) noexcept;
+    [[nodiscard]] std::uint32_t PackTraceInput(const MessageBoxInput& a_input) noexcept;
+    [[nodiscard]] std::uint32_t PackTraceDisplayInput(bool a_suppress, bool a_allow) noexcept;
+
+    [[nodiscard]] SelectionTargets UnpackSelectionTargets(std::uint32_t a_bits) noexcept;
+    [[nodiscard]] UserEventInput UnpackUserEventInput(std::uint32_t a_bits) noexcept;
+    [[nodiscard]] ActivateInput UnpackActivateInput(std::uint32_t a_bits) noexcept;
+    [[nodiscard]] RowInput UnpackRowInput(std::uint32_t a_bits) noexcept;
+    [[nodiscard]] MessageBoxInput UnpackMessageBoxInput(std::uint32_t a_bits) noexcept;
+
+    [[nodiscard]] std::uint32_t PackTraceDecision(const UserEventDecision& a_decision) noexcept;
+    [[nodiscard]] UserEventDecision UnpackUserEventDecision(std::uint32_t a_bits) noexcept;
+
+    class TraceWriter
+    {
+    public:
+        TraceWriter() = default;
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+        ~TraceWriter();
+
+        [[nodiscard]] bool Open(const std::filesystem::path& a_path);
+        void Close();
+        [[nodiscard]] bool IsOpen() const noexcept { return _file != nullptr; }
+
+        // Returns the id for a control name, emitting its definition record on first use.
+        [[nodiscard]] std::uint16_t InternControl(std::string_view a_name);
+        void WriteHook(const HookTraceEvent& a_event);
+        void WriteMarkDelta(const MarkDeltaEvent& a_event);
+        void Flush();
+
+    private:
+        void Append(const void* a_data, std::size_t a_size);
+        void FlushLocked();
+
+        std::mutex _lock;
+        std::FILE* _file{ nullptr };
+        std::vector<std::byte> _buffer;
+        std::unordered_map<std::string, std::uint16_t> _controls;
+    };
+
+    class TraceReader
+    {
+    public:
+        TraceReader() = default;
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+        ~TraceReader();
+
+        [[nodiscard]] bool Open(const std::filesystem::path& a_path);
+        [[nodiscard]] bool Next(TraceEvent& a_event);
+        [[nodiscard]] std::string_view GetControlName(std::uint16_t a_id) const noexcept;
+
+    private:
+        std::FILE* _file{ nullptr };
+        std::vector<std::string> _controls;
+    };
+}
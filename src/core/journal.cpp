@@ -0,0 +1,277 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#    include <Windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace RFAB::Disenchant
+{
+    MarkJournal::~MarkJournal()
+    {
+        Close();
+    }
+
+    std::uint32_t MarkJournal::MakeCheck(
+        const Header& a_header, std::size_t a_index, std::uint8_t a_op, std::uint64_t a_value) noexcept
+    {
+        // splitmix64 finalizer; binding the base token, reset epoch and slot index means records
+        // left over from before a reset, or shifted by a torn write, never validate.
+        auto x = a_value ^ (a_header.baseToken * 0x9E3779B97F4A7C15ull) ^ (static_cast<std::uint64_t>(a_header.epoch) << 40u) ^
+                 (static_cast<std::uint64_t>(a_index) << 8u) ^ a_op;
+        x = (x ^ (x >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27u)) * 0x94D049BB133111EBull;
+        x ^= x >> 31u;
+        const auto check = static_cast<std::uint32_t>(x);
+        return check != 0 ? check : 1;
+    }
+
+    MarkJournal::Record* MarkJournal::GetRecords() const noexcept
+    {
+        return reinterpret_cast<Record*>(static_cast<std::byte*>(_view) + sizeof(Header));
+    }
+
+    bool MarkJournal::Open(const std::filesystem::path& a_path)
+    {
+        Close();
+
+        std::error_code ec;
+        std::filesystem::create_directories(a_path.parent_path(), ec);
+
+        std::size_t existingBytes = 0;
+#ifdef _WIN32
+        _file = ::CreateFileW(
+            a_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            _file = nullptr;
+            return false;
+        }
+
+        LARGE_INTEGER size{};
+        if (::GetFileSizeEx(_file, &size)) {
+            existingBytes = static_cast<std::size_t>(size.QuadPart);
+        }
+#else
+        _fd = ::open(a_path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (_fd < 0) {
+            return false;
+        }
+
+        struct stat st{};
+        if (::fstat(_fd, &st) == 0) {
+            existingBytes = static_cast<std::size_t>(st.st_size);
+        }
+#endif
+
+        auto capacity = kInitialCapacity;
+        if (existingBytes > sizeof(Header)) {
+            capacity = std::max(capacity, (existingBytes - sizeof(Header)) / sizeof(Record));
+        }
+
+        if (!Map(capacity)) {
+            Close();
+            return false;
+        }
+
+        auto* header = GetHeader();
+        if (header->magic != kMagic || header->version != kVersion || header->recordSize != sizeof(Record)) {
+            std::memset(header, 0, sizeof(Header));
+            header->magic = kMagic;
+            header->version = kVersion;
+            header->recordSize = sizeof(Record);
+            header->baseToken = 0;
+        }
+
+        _count = ScanValidCount();
+        // Records past a torn or corrupt one would validate again once appends refill the gap;
+        // clear them so the journal ends where the valid prefix does.
+        auto* records = GetRecords();
+        for (auto index = _count; index < _capacity && records[index].op != 0; ++index) {
+            std::memset(&records[index], 0, sizeof(Record));
+        }
+        return true;
+    }
+
+    void MarkJournal::Close()
+    {
+        Unmap();
+#ifdef _WIN32
+        if (_file) {
+            ::CloseHandle(_file);
+            _file = nullptr;
+        }
+#else
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+#endif
+        _count = 0;
+    }
+
+    bool MarkJournal::Map(std::size_t a_capacity)
+    {
+        const auto bytes = sizeof(Header) + a_capacity * sizeof(Record);
+#ifdef _WIN32
+        const auto high = static_cast<DWORD>(static_cast<std::uint64_t>(bytes) >> 32u);
+        const auto low = static_cast<DWORD>(bytes & 0xFFFFFFFFu);
+        _mapping = ::CreateFileMappingW(_file, nullptr, PAGE_READWRITE, high, low, nullptr);
+        if (!_mapping) {
+            return false;
+        }
+
+        _view = ::MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+        if (!_view) {
+            ::CloseHandle(_mapping);
+            _mapping = nullptr;
+            return false;
+        }
+#else
+        struct stat st{};
+        if (::fstat(_fd, &st) != 0) {
+            return false;
+        }
+        if (static_cast<std::size_t>(st.st_size) < bytes && ::ftruncate(_fd, static_cast<off_t>(bytes)) != 0) {
+            return false;
+        }
+
+        auto* view = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        _view = view;
+#endif
+        _capacity = a_capacity;
+        return true;
+    }
+
+    void MarkJournal::Unmap()
+    {
+#ifdef _WIN32
+        if (_view) {
+            ::UnmapViewOfFile(_view);
+        }
+        if (_mapping) {
+            ::CloseHandle(_mapping);
+            _mapping = nullptr;
+        }
+#else
+        if (_view) {
+            ::munmap(_view, sizeof(Header) + _capacity * sizeof(Record));
+        }
+#endif
+        _view = nullptr;
+        _capacity = 0;
+    }
+
+    bool MarkJournal::Grow()
+    {
+        const auto capacity = _capacity * 2;
+        Unmap();
+        return Map(capacity);
+    }
+
+    std::size_t MarkJournal::ScanValidCount() const noexcept
+    {
+        const auto& header = *GetHeader();
+        const auto* records = GetRecords();
+
+        std::size_t count = 0;
+        while (count < _capacity) {
+            const auto& record = records[count];
+            if (record.op == 0 || record.check != MakeCheck(header, count, record.op, record.value)) {
+                break;
+            }
+            ++count;
+        }
+
+        return count;
+    }
+
+    bool MarkJournal::Append(JournalOp a_op, std::uint64_t a_value)
+    {
+        if (!IsOpen()) {
+            return false;
+        }
+
+        if (_count >= _capacity && !Grow()) {
+            return false;
+        }
+
+        const auto op = static_cast<std::uint8_t>(a_op);
+        auto& record = GetRecords()[_count];
+        record.value = a_value;
+        record.op = op;
+        std::memset(record.reserved, 0, sizeof(record.reserved));
+        // The check goes last: a record torn before this store fails validation on replay.
+        std::atomic_signal_fence(std::memory_order_release);
+        record.check = MakeCheck(*GetHeader(), _count, op, a_value);
+        ++_count;
+        return true;
+    }
+
+    bool MarkJournal::Reset(std::uint64_t a_baseToken)
+    {
+        if (!IsOpen()) {
+            return false;
+        }
+
+        auto* header = GetHeader();
+        header->baseToken = a_baseToken;
+        ++header->epoch;
+        // Belt and braces next to the epoch: the first slot no longer parses as a record.
+        std::memset(GetRecords(), 0, sizeof(Record));
+        _count = 0;
+        return true;
+    }
+
+    std::uint64_t MarkJournal::BaseToken() const noexcept
+    {
+        return IsOpen() ? GetHeader()->baseToken : 0;
+    }
+
+    std::size_t MarkJournal::Replay(const ReplayCallback& a_callback) const
+    {
+        if (!IsOpen()) {
+            return 0;
+        }
+
+        const auto* records = GetRecords();
+        for (std::size_t i = 0; i < _count; ++i) {
+            a_callback(static_cast<JournalOp>(records[i].op), records[i].value);
+        }
+
+        return _count;
+    }
+
+    std::size_t MarkJournal::RemoveEmpty(const std::filesystem::path& a_folder)
+    {
+        std::error_code ec;
+        std::vector<std::filesystem::path> empty;
+        for (const auto& file : std::filesystem::directory_iterator(a_folder, ec)) {
+            if (!file.is_regular_file(ec) || file.path().extension() != kExtension) {
+                continue;
+            }
+
+            MarkJournal journal;
+            if (journal.Open(file.path()) && journal.Size() == 0) {
+                empty.push_back(file.path());
+            }
+        }
+
+        std::size_t removed = 0;
+        for (const auto& path : empty) {
+            removed += std::filesystem::remove(path, ec) ? 1 : 0;
+        }
+        return removed;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace RFAB::Disenchant
+{
+    enum class JournalOp : std::uint8_t
+    {
+        kMarkKey = 1,
+        kUnmarkKey = 2,
+        kMarkSignature = 3,
+        kUnmarkSignature = 4
+    };
+
+    // Append-only, memory-mapped log of mark store operations made since the last co-save.
+    // Records live in the OS page cache as soon as they are written, so a CTD loses nothing;
+    // each record is self-validating against the header's base token and reset epoch, which
+    // lets a reset only rewrite the header: records from before it never validate again, even
+    // when a later reset returns to the same base token.
+    class MarkJournal
+    {
+    public:
+        struct Record
+        {
+            std::uint8_t op;
+            std::uint8_t reserved[3];
+            std::uint32_t check;
+            std::uint64_t value;
+        };
+        static_assert(sizeof(Record) == 16);
+
+        using ReplayCallback = std::function<void(JournalOp, std::uint64_t)>;
+
+        MarkJournal() = default;
+        MarkJournal(const MarkJournal&) = delete;
+        MarkJournal& operator=(const MarkJournal&) = delete;
+        ~MarkJournal();
+
+        [[nodiscard]] bool Open(const std::filesystem::path& a_path);
+        void Close();
+        [[nodiscard]] bool IsOpen() const noexcept { return _view != nullptr; }
+
+        [[nodiscard]] bool Append(JournalOp a_op, std::uint64_t a_value);
+        [[nodiscard]] bool Reset(std::uint64_t a_baseToken);
+        [[nodiscard]] std::uint64_t BaseToken() const noexcept;
+        [[nodiscard]] std::size_t Size() const noexcept { return _count; }
+
+        std::size_t Replay(const ReplayCallback& a_callback) const;
+
+        // Deletes every journal in a_folder that holds no valid record; such a journal carries
+        // nothing a fresh one would not. Returns how many were removed.
+        static std::size_t RemoveEmpty(const std::filesystem::path& a_folder);
+
+        static constexpr auto kExtension = ".rfdj";
+
+    private:
+        struct Header
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint64_t baseToken;
+            std::uint32_t recordSize;
+            std::uint32_t epoch;  // bumped by every reset
+            std::uint64_t reserved2;
+        };
+        static_assert(sizeof(Header) == 32);
+
+        static constexpr std::uint32_t kMagic = 'RFDJ';
+        static constexpr std::uint32_t kVersion = 2;
+        static constexpr std::size_t kInitialCapacity = 4096;
+
+        [[nodiscard]] static std::uint32_t MakeCheck(
+            const Header& a_header, std::size_t a_index, std::uint8_t a_op, std::uint64_t a_value) noexcept;
+        [[nodiscard]] Header* GetHeader() const noexcept { return static_cast<Header*>(_view); }
+        [[nodiscard]] Record* GetRecords() const noexcept;
+        [[nodiscard]] bool Map(std::size_t a_capacity);
+        void Unmap();
+        [[nodiscard]] bool Grow();
+        [[nodiscard]] std::size_t ScanValidCount() const noexcept;
+
+        void* _view{ nullptr };
+        std::size_t _capacity{ 0 };
+        std::size_t _count{ 0 };
+#ifdef _WIN32
+        void* _file{ nullptr };
+        void* _mapping{ nullptr };
+#else
+        int _fd{ -1 };
+#endif
+    };
+}
@@ -0,0 +1,47 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+
+namespace RFAB::Disenchant
+{
+    static_assert(LatencyHistogram::BucketIndex(~std::uint64_t{ 0 }) == LatencyHistogram::kBucketCount - 1);
+    static_assert(LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1) == ~std::uint64_t{ 0 });
+    static_assert(LatencyHistogram::BucketIndex(LatencyHistogram::BucketUpperBound(100)) == 100);
+    static_assert(LatencyHistogram::BucketIndex(LatencyHistogram::BucketUpperBound(100) + 1) == 101);
+
+    LatencySummary LatencyHistogram::Collect(bool a_reset) noexcept
+    {
+        std::array<std::uint64_t, kBucketCount> counts;
+        LatencySummary summary;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            counts[i] = a_reset ? _buckets[i].exchange(0, std::memory_order_relaxed) : _buckets[i].load(std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        summary.total = a_reset ? _total.exchange(0, std::memory_order_relaxed) : _total.load(std::memory_order_relaxed);
+        summary.max = a_reset ? _max.exchange(0, std::memory_order_relaxed) : _max.load(std::memory_order_relaxed);
+        if (summary.count == 0) {
+            return summary;
+        }
+
+        const auto rankP50 = (summary.count + 1) / 2;
+        const auto rankP99 = summary.count - summary.count / 100;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount && seen < rankP99; ++i) {
+            if (counts[i] == 0) {
+                continue;
+            }
+
+            const auto before = seen;
+            seen += counts[i];
+            const auto value = std::min(BucketUpperBound(i), summary.max);
+            if (before < rankP50 && seen >= rankP50) {
+                summary.p50 = value;
+            }
+            if (seen >= rankP99) {
+                summary.p99 = value;
+            }
+        }
+
+        return summary;
+    }
+}
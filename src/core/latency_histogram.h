@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace RFAB::Disenchant
+{
+    struct LatencySummary
+    {
+        std::uint64_t count{ 0 };
+        std::uint64_t total{ 0 };
+        std::uint64_t p50{ 0 };
+        std::uint64_t p99{ 0 };
+        std::uint64_t max{ 0 };
+    };
+
+    // Log-linear (HDR-style) histogram of tick counts: one power-of-two group per bit width,
+    // split into 8 linear sub-buckets, so any recorded value is reported within 12.5%.
+    // Record() is wait-free apart from the max CAS and safe to call from any thread.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr std::uint32_t kSubBucketBits = 3;
+        static constexpr std::uint32_t kSubBuckets = 1u << kSubBucketBits;
+        static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+        void Record(std::uint64_t a_value) noexcept
+        {
+            _buckets[BucketIndex(a_value)].fetch_add(1, std::memory_order_relaxed);
+            _total.fetch_add(a_value, std::memory_order_relaxed);
+
+            auto max = _max.load(std::memory_order_relaxed);
+            while (a_value > max && !_max.compare_exchange_weak(max, a_value, std::memory_order_relaxed)) {}
+        }
+
+        // Summarises everything recorded so far; with a_reset the histogram starts over, so
+        // consecutive calls each cover the interval since the previous one. Values recorded
+        // concurrently land in either this interval or the next.
+        [[nodiscard]] LatencySummary Collect(bool a_reset) noexcept;
+
+        [[nodiscard]] static constexpr std::size_t BucketIndex(std::uint64_t a_value) noexcept
+        {
+            if (a_value < kSubBuckets) {
+                return static_cast<std::size_t>(a_value);
+            }
+
+            const auto msb = static_cast<std::uint32_t>(std::bit_width(a_value)) - 1;
+            const auto sub = (a_value >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+            return (msb - kSubBucketBits + 1) * kSubBuckets + static_cast<std::size_t>(sub);
+        }
+
+        // Largest value that maps to a_index.
+        [[nodiscard]] static constexpr std::uint64_t BucketUpperBound(std::size_t a_index) noexcept
+        {
+            if (a_index < kSubBuckets) {
+                return a_index;
+            }
+
+            const auto msb = static_cast<std::uint32_t>(a_index / kSubBuckets) + kSubBucketBits - 1;
+            const auto sub = static_cast<std::uint64_t>(a_index % kSubBuckets);
+            const auto width = std::uint64_t{ 1 } << (msb - kSubBucketBits);
+            return ((kSubBuckets + sub) << (msb - kSubBucketBits)) + (width - 1);
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, kBucketCount> _buckets{};
+        std::atomic<std::uint64_t> _total{ 0 };
+        std::atomic<std::uint64_t> _max{ 0 };
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace RFAB::Disenchant
+{
+    // Object + enchantment FormID pair; identifies a mark when the instance has no ExtraUniqueID.
+    enum class MarkSignature : std::uint64_t
+    {
+    };
+
+    struct MarkSignatureHash
+    {
+        [[nodiscard]] std::size_t operator()(MarkSignature a_sig) const noexcept
+        {
+            return std::hash<std::uint64_t>{}(static_cast<std::uint64_t>(a_sig));
+        }
+    };
+
+    [[nodiscard]] constexpr std::uint64_t MakeMarkKey(std::uint32_t a_baseID, std::uint16_t a_uniqueID) noexcept
+    {
+        return (static_cast<std::uint64_t>(a_baseID) << 16u) | static_cast<std::uint64_t>(a_uniqueID);
+    }
+
+    [[nodiscard]] constexpr MarkSignature MakeMarkSignature(std::uint32_t a_objectFormID, std::uint32_t a_enchantmentFormID) noexcept
+    {
+        const auto raw = (static_cast<std::uint64_t>(a_objectFormID) << 32u) | static_cast<std::uint64_t>(a_enchantmentFormID);
+        return static_cast<MarkSignature>(raw);
+    }
+
+    [[nodiscard]] constexpr std::uint32_t GetSignatureObjectFormID(MarkSignature a_signature) noexcept
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint64_t>(a_signature) >> 32u);
+    }
+
+    [[nodiscard]] constexpr std::uint32_t GetSignatureEnchantmentFormID(MarkSignature a_signature) noexcept
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint64_t>(a_signature) & 0xFFFFFFFFu);
+    }
+}
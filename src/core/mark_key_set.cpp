@@ -0,0 +1,295 @@
+#include "mark_key_set.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        constexpr std::uint64_t kMaxKey = (std::uint64_t{ 1 } << 48u) - 1;
+
+        [[nodiscard]] constexpr std::uint32_t GetKeyBaseID(std::uint64_t a_key) noexcept
+        {
+            return static_cast<std::uint32_t>(a_key >> 16u);
+        }
+
+        [[nodiscard]] constexpr std::uint16_t GetKeyUniqueID(std::uint64_t a_key) noexcept
+        {
+            return static_cast<std::uint16_t>(a_key & 0xFFFFu);
+        }
+
+        [[nodiscard]] constexpr std::uint64_t BitOf(std::uint16_t a_id) noexcept
+        {
+            return std::uint64_t{ 1 } << (a_id % 64u);
+        }
+    }
+
+    bool UniqueIDContainer::Contains(std::uint16_t a_id) const noexcept
+    {
+        if (!_bitmap.empty()) {
+            return (_bitmap[a_id / 64u] & BitOf(a_id)) != 0;
+        }
+        return std::binary_search(_array.begin(), _array.end(), a_id);
+    }
+
+    bool UniqueIDContainer::Insert(std::uint16_t a_id)
+    {
+        if (!_bitmap.empty()) {
+            auto& word = _bitmap[a_id / 64u];
+            if (word & BitOf(a_id)) {
+                return false;
+            }
+            word |= BitOf(a_id);
+            ++_count;
+            return true;
+        }
+
+        const auto it = std::lower_bound(_array.begin(), _array.end(), a_id);
+        if (it != _array.end() && *it == a_id) {
+            return false;
+        }
+        _array.insert(it, a_id);
+        ++_count;
+        if (_array.size() > kArrayMax) {
+            ToBitmap();
+        }
+        return true;
+    }
+
+    bool UniqueIDContainer::Erase(std::uint16_t a_id)
+    {
+        if (!_bitmap.empty()) {
+            auto& word = _bitmap[a_id / 64u];
+            if (!(word & BitOf(a_id))) {
+                return false;
+            }
+            word &= ~BitOf(a_id);
+            --_count;
+            if (_count <= kBitmapMin) {
+                ToArray();
+            }
+            return true;
+        }
+
+        const auto it = std::lower_bound(_array.begin(), _array.end(), a_id);
+        if (it == _array.end() || *it != a_id) {
+            return false;
+        }
+        _array.erase(it);
+        --_count;
+        return true;
+    }
+
+    bool UniqueIDContainer::AssignArray(std::vector<std::uint16_t> a_ids)
+    {
+        if (a_ids.empty() || a_ids.size() > kArrayMax || std::adjacent_find(a_ids.begin(), a_ids.end(), std::greater_equal<>{}) != a_ids.end()) {
+            return false;
+        }
+
+        _count = static_cast<std::uint32_t>(a_ids.size());
+        _array = std::move(a_ids);
+        _bitmap.clear();
+        return true;
+    }
+
+    bool UniqueIDContainer::AssignBitmap(std::vector<std::uint64_t> a_words)
+    {
+        if (a_words.size() != kBitmapWords) {
+            return false;
+        }
+
+        std::uint32_t count = 0;
+        for (const auto word : a_words) {
+            count += static_cast<std::uint32_t>(std::popcount(word));
+        }
+        if (count == 0) {
+            return false;
+        }
+
+        _count = count;
+        _bitmap = std::move(a_words);
+        _array.clear();
+        if (_count <= kArrayMax) {
+            ToArray();
+        }
+        return true;
+    }
+
+    void UniqueIDContainer::ToBitmap()
+    {
+        _bitmap.assign(kBitmapWords, 0);
+        for (const auto id : _array) {
+            _bitmap[id / 64u] |= BitOf(id);
+        }
+        _array.clear();
+        _array.shrink_to_fit();
+    }
+
+    void UniqueIDContainer::ToArray()
+    {
+        std::vector<std::uint16_t> ids;
+        ids.reserve(_count);
+        ForEach([&](std::uint16_t a_id) { ids.push_back(a_id); });
+        _array = std::move(ids);
+        _bitmap.clear();
+        _bitmap.shrink_to_fit();
+    }
+
+    auto MarkKeySet::FindDense(std::uint32_t a_baseID) noexcept -> std::vector<Container>::iterator
+    {
+        const auto it = std::lower_bound(_dense.begin(), _dense.end(), a_baseID, [](const Container& a_container, std::uint32_t a_id) {
+            return a_container.first < a_id;
+        });
+        return it != _dense.end() && it->first == a_baseID ? it : _dense.end();
+    }
+
+    auto MarkKeySet::FindDense(std::uint32_t a_baseID) const noexcept -> std::vector<Container>::const_iterator
+    {
+        return const_cast<MarkKeySet*>(this)->FindDense(a_baseID);
+    }
+
+    std::uint32_t MarkKeySet::HighestBase() const noexcept
+    {
+        const auto sparse = _sparse.empty() ? 0 : GetKeyBaseID(_sparse.back());
+        const auto dense = _dense.empty() ? 0 : _dense.back().first;
+        return std::max(sparse, dense);
+    }
+
+    bool MarkKeySet::Contains(std::uint64_t a_key) const noexcept
+    {
+        if (a_key > kMaxKey) {
+            return false;
+        }
+
+        if (std::binary_search(_sparse.begin(), _sparse.end(), a_key)) {
+            return true;
+        }
+        const auto it = FindDense(GetKeyBaseID(a_key));
+        return it != _dense.end() && it->second.Contains(GetKeyUniqueID(a_key));
+    }
+
+    bool MarkKeySet::Insert(std::uint64_t a_key)
+    {
+        if (a_key > kMaxKey) {
+            return false;
+        }
+
+        const auto baseID = GetKeyBaseID(a_key);
+        if (const auto dense = FindDense(baseID); dense != _dense.end()) {
+            if (!dense->second.Insert(GetKeyUniqueID(a_key))) {
+                return false;
+            }
+            ++_size;
+            return true;
+        }
+
+        const auto it = std::lower_bound(_sparse.begin(), _sparse.end(), a_key);
+        if (it != _sparse.end() && *it == a_key) {
+            return false;
+        }
+        _sparse.insert(it, a_key);
+        ++_size;
+
+        const auto high = static_cast<std::uint64_t>(baseID) << 16u;
+        const auto first = std::lower_bound(_sparse.begin(), _sparse.end(), high);
+        const auto last = std::upper_bound(first, _sparse.end(), high | 0xFFFFu);
+        if (static_cast<std::size_t>(last - first) > kDenseMin) {
+            Promote(baseID);
+        }
+        return true;
+    }
+
+    bool MarkKeySet::Erase(std::uint64_t a_key)
+    {
+        if (a_key > kMaxKey) {
+            return false;
+        }
+
+        if (const auto dense = FindDense(GetKeyBaseID(a_key)); dense != _dense.end()) {
+            if (!dense->second.Erase(GetKeyUniqueID(a_key))) {
+                return false;
+            }
+            --_size;
+            if (dense->second.Size() < kSparseMax) {
+                Demote(dense);
+            }
+            return true;
+        }
+
+        const auto it = std::lower_bound(_sparse.begin(), _sparse.end(), a_key);
+        if (it == _sparse.end() || *it != a_key) {
+            return false;
+        }
+        _sparse.erase(it);
+        --_size;
+        return true;
+    }
+
+    void MarkKeySet::Promote(std::uint32_t a_baseID)
+    {
+        const auto high = static_cast<std::uint64_t>(a_baseID) << 16u;
+        const auto first = std::lower_bound(_sparse.begin(), _sparse.end(), high);
+        const auto last = std::upper_bound(first, _sparse.end(), high | 0xFFFFu);
+
+        std::vector<std::uint16_t> ids;
+        ids.reserve(static_cast<std::size_t>(last - first));
+        for (auto it = first; it != last; ++it) {
+            ids.push_back(GetKeyUniqueID(*it));
+        }
+        _sparse.erase(first, last);
+
+        UniqueIDContainer container;
+        (void)container.AssignArray(std::move(ids));
+        const auto at = std::lower_bound(_dense.begin(), _dense.end(), a_baseID, [](const Container& a_container, std::uint32_t a_id) {
+            return a_container.first < a_id;
+        });
+        _dense.insert(at, Container{ a_baseID, std::move(container) });
+    }
+
+    void MarkKeySet::Demote(std::vector<Container>::iterator a_dense)
+    {
+        const auto high = static_cast<std::uint64_t>(a_dense->first) << 16u;
+        const auto at = std::lower_bound(_sparse.begin(), _sparse.end(), high);
+        std::vector<std::uint64_t> keys;
+        keys.reserve(a_dense->second.Size());
+        a_dense->second.ForEach([&](std::uint16_t a_id) { keys.push_back(high | a_id); });
+        _sparse.insert(at, keys.begin(), keys.end());
+        _dense.erase(a_dense);
+    }
+
+    void MarkKeySet::Clear() noexcept
+    {
+        _sparse.clear();
+        _dense.clear();
+        _size = 0;
+    }
+
+    std::size_t MarkKeySet::ContainerCount() const noexcept
+    {
+        std::size_t count = _dense.size();
+        for (std::size_t i = 0; i < _sparse.size(); ++i) {
+            if (i == 0 || GetKeyBaseID(_sparse[i]) != GetKeyBaseID(_sparse[i - 1])) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    bool MarkKeySet::AppendContainer(std::uint32_t a_baseID, UniqueIDContainer a_container)
+    {
+        if (a_container.Empty() || (_size != 0 && HighestBase() >= a_baseID)) {
+            return false;
+        }
+
+        _size += a_container.Size();
+        if (a_container.Size() > kDenseMin) {
+            _dense.emplace_back(a_baseID, std::move(a_container));
+            return true;
+        }
+
+        const auto high = static_cast<std::uint64_t>(a_baseID) << 16u;
+        a_container.ForEach([&](std::uint16_t a_id) { _sparse.push_back(high | a_id); });
+        return true;
+    }
+}
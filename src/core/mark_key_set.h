@@ -0,0 +1,154 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    // Unique IDs marked under one base FormID, stored Roaring-style: a sorted array of 16-bit IDs
+    // while sparse, a 65536-bit bitmap once it holds more than kArrayMax of them (the point where
+    // the array would outgrow the bitmap's 8 KiB). A bitmap only turns back into an array at half
+    // that, so erasing and inserting around the boundary does not convert every time.
+    class UniqueIDContainer
+    {
+    public:
+        enum class Kind : std::uint16_t
+        {
+            kArray,
+            kBitmap
+        };
+
+        static constexpr std::size_t kArrayMax = 4096;
+        static constexpr std::size_t kBitmapMin = kArrayMax / 2;
+        static constexpr std::size_t kBitmapWords = 65536 / 64;
+
+        [[nodiscard]] bool Contains(std::uint16_t a_id) const noexcept;
+        bool Insert(std::uint16_t a_id);
+        bool Erase(std::uint16_t a_id);
+
+        [[nodiscard]] std::size_t Size() const noexcept { return _count; }
+        [[nodiscard]] bool Empty() const noexcept { return _count == 0; }
+        [[nodiscard]] Kind GetKind() const noexcept { return _bitmap.empty() ? Kind::kArray : Kind::kBitmap; }
+
+        // Raw payload in the current kind; this is also the co-save layout.
+        [[nodiscard]] std::span<const std::uint16_t> Array() const noexcept { return _array; }
+        [[nodiscard]] std::span<const std::uint64_t> Bitmap() const noexcept { return _bitmap; }
+
+        // Adopt a payload read back from the co-save. Fail (leaving the container untouched) on an
+        // array that is not strictly ascending or too long, or a bitmap of the wrong size.
+        [[nodiscard]] bool AssignArray(std::vector<std::uint16_t> a_ids);
+        [[nodiscard]] bool AssignBitmap(std::vector<std::uint64_t> a_words);
+
+        // Visits IDs in ascending order.
+        template <class F>
+        void ForEach(F&& a_visitor) const
+        {
+            if (_bitmap.empty()) {
+                for (const auto id : _array) {
+                    a_visitor(id);
+                }
+                return;
+            }
+
+            for (std::size_t word = 0; word < _bitmap.size(); ++word) {
+                for (auto bits = _bitmap[word]; bits != 0; bits &= bits - 1) {
+                    a_visitor(static_cast<std::uint16_t>(word * 64 + static_cast<std::size_t>(std::countr_zero(bits))));
+                }
+            }
+        }
+
+    private:
+        void ToBitmap();
+        void ToArray();
+
+        std::vector<std::uint16_t> _array;
+        std::vector<std::uint64_t> _bitmap;
+        std::uint32_t _count{ 0 };
+    };
+
+    // Set of mark keys (MakeMarkKey: base FormID << 16 | unique ID). The base is the instance's
+    // own object, so most bases hold a single marked ID; those keys live in one flat sorted
+    // vector. A base is only given its own UniqueIDContainer once it holds more than kDenseMin
+    // IDs, and goes back to the flat vector below kSparseMax, so a base hovering at one size does
+    // not flip between the two. Keys with bits above 48 cannot come from MakeMarkKey and are
+    // never stored.
+    class MarkKeySet
+    {
+    public:
+        using Container = std::pair<std::uint32_t, UniqueIDContainer>;
+
+        static constexpr std::size_t kDenseMin = 64;
+        static constexpr std::size_t kSparseMax = 16;
+
+        [[nodiscard]] bool Contains(std::uint64_t a_key) const noexcept;
+        bool Insert(std::uint64_t a_key);
+        bool Erase(std::uint64_t a_key);
+        void Clear() noexcept;
+
+        [[nodiscard]] std::size_t Size() const noexcept { return _size; }
+        [[nodiscard]] bool Empty() const noexcept { return _size == 0; }
+
+        // Number of distinct bases, i.e. of containers ForEachContainer visits.
+        [[nodiscard]] std::size_t ContainerCount() const noexcept;
+        // Visits one (base FormID, container) per base in ascending base order. Bases kept in the
+        // flat vector are handed over as a temporary array container; this is the co-save layout.
+        template <class F>
+        void ForEachContainer(F&& a_visitor) const
+        {
+            auto sparse = _sparse.begin();
+            const auto flushSparseBelow = [&](std::uint64_t a_limit) {
+                while (sparse != _sparse.end() && *sparse < a_limit) {
+                    const auto baseID = static_cast<std::uint32_t>(*sparse >> 16u);
+                    std::vector<std::uint16_t> ids;
+                    for (; sparse != _sparse.end() && static_cast<std::uint32_t>(*sparse >> 16u) == baseID; ++sparse) {
+                        ids.push_back(static_cast<std::uint16_t>(*sparse & 0xFFFFu));
+                    }
+                    UniqueIDContainer container;
+                    (void)container.AssignArray(std::move(ids));
+                    a_visitor(baseID, static_cast<const UniqueIDContainer&>(container));
+                }
+            };
+
+            for (const auto& [baseID, container] : _dense) {
+                flushSparseBelow(static_cast<std::uint64_t>(baseID) << 16u);
+                a_visitor(baseID, container);
+            }
+            flushSparseBelow(~std::uint64_t{ 0 });
+        }
+        // Adds a container for a base above every base already present; used by the co-save
+        // reader, which stores containers in ascending order.
+        [[nodiscard]] bool AppendContainer(std::uint32_t a_baseID, UniqueIDContainer a_container);
+
+        // Visits keys in ascending order.
+        template <class F>
+        void ForEach(F&& a_visitor) const
+        {
+            auto sparse = _sparse.begin();
+            for (const auto& [baseID, container] : _dense) {
+                const auto high = static_cast<std::uint64_t>(baseID) << 16u;
+                for (; sparse != _sparse.end() && *sparse < high; ++sparse) {
+                    a_visitor(*sparse);
+                }
+                container.ForEach([&](std::uint16_t a_id) { a_visitor(high | a_id); });
+            }
+            for (; sparse != _sparse.end(); ++sparse) {
+                a_visitor(*sparse);
+            }
+        }
+
+    private:
+        [[nodiscard]] std::vector<Container>::iterator FindDense(std::uint32_t a_baseID) noexcept;
+        [[nodiscard]] std::vector<Container>::const_iterator FindDense(std::uint32_t a_baseID) const noexcept;
+        [[nodiscard]] std::uint32_t HighestBase() const noexcept;
+        void Promote(std::uint32_t a_baseID);
+        void Demote(std::vector<Container>::iterator a_dense);
+
+        std::vector<std::uint64_t> _sparse;  // ascending; bases without a container
+        std::vector<Container> _dense;       // ascending by base, none holding fewer than kSparseMax IDs
+        std::size_t _size{ 0 };
+    };
+}
@@ -0,0 +1,91 @@
+#include "mark_location.h"
+
+#include <algorithm>
+
+namespace RFAB::Disenchant
+{
+    void MarkLocationIndex::Set(std::uint64_t a_key, MarkLocation a_location)
+    {
+        std::scoped_lock lk(_lock);
+        _byKey.insert_or_assign(a_key, a_location);
+    }
+
+    bool MarkLocationIndex::Erase(std::uint64_t a_key)
+    {
+        std::scoped_lock lk(_lock);
+        return _byKey.erase(a_key) != 0;
+    }
+
+    void MarkLocationIndex::Clear()
+    {
+        std::scoped_lock lk(_lock);
+        _byKey.clear();
+    }
+
+    void MarkLocationIndex::Replace(std::span<const Entry> a_entries)
+    {
+        std::scoped_lock lk(_lock);
+        _byKey.clear();
+        _byKey.reserve(a_entries.size());
+        for (const auto& entry : a_entries) {
+            _byKey.insert_or_assign(entry.key, entry.location);
+        }
+    }
+
+    std::optional<MarkLocation> MarkLocationIndex::Find(std::uint64_t a_key) const
+    {
+        std::scoped_lock lk(_lock);
+        const auto it = _byKey.find(a_key);
+        return it != _byKey.end() ? std::optional(it->second) : std::nullopt;
+    }
+
+    std::vector<MarkLocationIndex::Entry> MarkLocationIndex::Entries() const
+    {
+        std::vector<Entry> entries;
+        {
+            std::scoped_lock lk(_lock);
+            entries.reserve(_byKey.size());
+            for (const auto& [key, location] : _byKey) {
+                entries.push_back({ key, location });
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a_lhs, const Entry& a_rhs) { return a_lhs.key < a_rhs.key; });
+        return entries;
+    }
+
+    std::size_t MarkLocationIndex::Size() const
+    {
+        std::scoped_lock lk(_lock);
+        return _byKey.size();
+    }
+
+    bool MarkLocationIndex::Move(const MarkStore& a_store, std::uint64_t a_key, std::optional<MarkLocation> a_to)
+    {
+        if (!a_store.IsMarked(a_key)) {
+            return false;
+        }
+
+        std::scoped_lock lk(_lock);
+        if (a_to) {
+            _byKey.insert_or_assign(a_key, *a_to);
+        } else {
+            _byKey.erase(a_key);
+        }
+        return true;
+    }
+
+    std::size_t MarkLocationIndex::Prune(const MarkStore& a_store)
+    {
+        std::scoped_lock lk(_lock);
+        std::vector<std::uint64_t> stale;
+        for (const auto& [key, location] : _byKey) {
+            if (!a_store.IsMarked(key)) {
+                stale.push_back(key);
+            }
+        }
+        for (const auto key : stale) {
+            _byKey.erase(key);
+        }
+        return stale.size();
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "mark_store.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    enum class MarkLocationKind : std::uint8_t
+    {
+        kContainer,  // in the inventory of ownerFormID (the player, a follower, a chest)
+        kWorld       // dropped; ownerFormID is the loose reference
+    };
+
+    struct MarkLocation
+    {
+        std::uint32_t ownerFormID{ 0 };
+        MarkLocationKind kind{ MarkLocationKind::kContainer };
+
+        [[nodiscard]] bool operator==(const MarkLocation&) const = default;
+    };
+
+    // Last known owner of each marked instance, so "where is this item" is one hash lookup instead
+    // of an inventory walk, and a container change only touches the keys that moved. Kept current
+    // from container-changed events, which carry the moved instance's base object and unique ID,
+    // i.e. its ExtraUniqueID and so its key. All members take an internal lock.
+    class MarkLocationIndex
+    {
+    public:
+        struct Entry
+        {
+            std::uint64_t key{ 0 };
+            MarkLocation location;
+        };
+
+        void Set(std::uint64_t a_key, MarkLocation a_location);
+        bool Erase(std::uint64_t a_key);
+        void Clear();
+        void Replace(std::span<const Entry> a_entries);
+
+        [[nodiscard]] std::optional<MarkLocation> Find(std::uint64_t a_key) const;
+        [[nodiscard]] std::vector<Entry> Entries() const;
+        [[nodiscard]] std::size_t Size() const;
+
+        // One container change of the instance with a_key; a_to is empty when it was destroyed.
+        // Keys that are not marked are left out of the index. Returns true when a_key was moved.
+        bool Move(const MarkStore& a_store, std::uint64_t a_key, std::optional<MarkLocation> a_to);
+
+        // Drops entries for keys that are no longer marked. Returns how many went.
+        std::size_t Prune(const MarkStore& a_store);
+
+    private:
+        mutable std::mutex _lock;
+        std::unordered_map<std::uint64_t, MarkLocation> _byKey;
+    };
+}
@@ -0,0 +1,263 @@
+#include "mark_probe.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#    define RFAB_PROBE_X86 1
+#    include <immintrin.h>
+#    if defined(_MSC_VER)
+#        include <intrin.h>
+#        define RFAB_TARGET_AVX2
+#    else
+#        define RFAB_TARGET_AVX2 __attribute__((target("avx2")))
+#    endif
+#else
+#    define RFAB_PROBE_X86 0
+#endif
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        // Keys are 48-bit (FormID << 16 | unique ID), so all-ones never names a real instance.
+        constexpr std::uint64_t kEmptySlot = ~std::uint64_t{ 0 };
+        constexpr std::uint64_t kHashMultiplier = 0x9E3779B97F4A7C15ull;
+
+        [[nodiscard]] std::uint64_t BucketIndex(std::uint64_t a_key, std::uint32_t a_shift) noexcept
+        {
+            return (a_key * kHashMultiplier) >> a_shift;
+        }
+
+        void SetBit(std::uint64_t* a_bits, std::size_t a_index) noexcept
+        {
+            a_bits[a_index / 64] |= std::uint64_t{ 1 } << (a_index % 64);
+        }
+
+#if RFAB_PROBE_X86
+        [[nodiscard]] bool DetectAvx2() noexcept
+        {
+#    if defined(_MSC_VER)
+            int regs[4]{};
+            __cpuid(regs, 0);
+            if (regs[0] < 7) {
+                return false;
+            }
+            __cpuid(regs, 1);
+            const bool osxsave = (regs[2] & (1 << 27)) != 0;
+            const bool avx = (regs[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+                return false;
+            }
+            __cpuidex(regs, 7, 0);
+            return (regs[1] & (1 << 5)) != 0;
+#    else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#    endif
+        }
+
+        // SSE2 has no 64-bit compare: compare 32-bit halves and require both halves to match.
+        [[nodiscard]] int MatchMaskSse2(__m128i a_lanes, __m128i a_needle) noexcept
+        {
+            const auto halves = _mm_cmpeq_epi32(a_lanes, a_needle);
+            const auto swapped = _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1));
+            return _mm_movemask_epi8(_mm_and_si128(halves, swapped));
+        }
+#endif
+    }
+
+    ProbeIsa DetectProbeIsa() noexcept
+    {
+#if RFAB_PROBE_X86
+        static const ProbeIsa isa = DetectAvx2() ? ProbeIsa::kAvx2 : ProbeIsa::kSse2;
+        return isa;
+#else
+        return ProbeIsa::kScalar;
+#endif
+    }
+
+    const char* GetProbeIsaName(ProbeIsa a_isa) noexcept
+    {
+        switch (a_isa) {
+        case ProbeIsa::kAvx2:
+            return "avx2";
+        case ProbeIsa::kSse2:
+            return "sse2";
+        case ProbeIsa::kScalar:
+            break;
+        }
+        return "scalar";
+    }
+
+    MarkProbeTable::MarkProbeTable(std::span<const std::uint64_t> a_keys)
+    {
+        if (a_keys.empty()) {
+            return;
+        }
+
+        // Capacity of at least twice the key count keeps every probe chain short and guarantees
+        // that a free slot ends each one.
+        const auto bucketCount = std::bit_ceil(std::max<std::size_t>(2, (a_keys.size() * 2 + kBucketSlots - 1) / kBucketSlots));
+        _buckets.assign(bucketCount, Bucket{ { kEmptySlot, kEmptySlot, kEmptySlot, kEmptySlot } });
+        _mask = bucketCount - 1;
+        _shift = static_cast<std::uint32_t>(64 - std::countr_zero(bucketCount));
+
+        for (const auto key : a_keys) {
+            if (key == kEmptySlot) {
+                continue;
+            }
+
+            for (auto index = BucketIndex(key, _shift);; index = (index + 1) & _mask) {
+                auto& slots = _buckets[index].slots;
+                const auto free = std::find(std::begin(slots), std::end(slots), kEmptySlot);
+                if (free != std::end(slots)) {
+                    *free = key;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool MarkProbeTable::Contains(std::uint64_t a_key) const noexcept
+    {
+        if (_buckets.empty() || a_key == kEmptySlot) {
+            return false;
+        }
+
+        for (auto index = BucketIndex(a_key, _shift);; index = (index + 1) & _mask) {
+            bool hasFree = false;
+            for (const auto slot : _buckets[index].slots) {
+                if (slot == a_key) {
+                    return true;
+                }
+                hasFree = hasFree || slot == kEmptySlot;
+            }
+            if (hasFree) {
+                return false;
+            }
+        }
+    }
+
+    std::size_t MarkProbeTable::ContainsBatch(const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits) const noexcept
+    {
+        return ContainsBatch(a_keys, a_count, a_bits, DetectProbeIsa());
+    }
+
+#if RFAB_PROBE_X86
+    namespace
+    {
+        // Distance, in keys, at which the next bucket is prefetched while the current one is probed.
+        constexpr std::size_t kPrefetchDistance = 8;
+
+        RFAB_TARGET_AVX2 std::size_t ProbeBatchAvx2(
+            const std::uint64_t* a_buckets,
+            std::uint64_t a_mask,
+            std::uint32_t a_shift,
+            const std::uint64_t* a_keys,
+            std::size_t a_count,
+            std::uint64_t* a_bits) noexcept
+        {
+            const auto empty = _mm256_set1_epi64x(static_cast<long long>(kEmptySlot));
+            std::size_t found = 0;
+            for (std::size_t i = 0; i < a_count; ++i) {
+                if (i + kPrefetchDistance < a_count) {
+                    const auto ahead = BucketIndex(a_keys[i + kPrefetchDistance], a_shift);
+                    _mm_prefetch(reinterpret_cast<const char*>(a_buckets + ahead * MarkProbeTable::kBucketSlots), _MM_HINT_T0);
+                }
+
+                const auto key = a_keys[i];
+                if (key == kEmptySlot) {
+                    continue;
+                }
+
+                const auto needle = _mm256_set1_epi64x(static_cast<long long>(key));
+                for (auto index = BucketIndex(key, a_shift);; index = (index + 1) & a_mask) {
+                    const auto lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(a_buckets + index * MarkProbeTable::kBucketSlots));
+                    if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(lanes, needle)) != 0) {
+                        SetBit(a_bits, i);
+                        ++found;
+                        break;
+                    }
+                    if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(lanes, empty)) != 0) {
+                        break;
+                    }
+                }
+            }
+            return found;
+        }
+
+        std::size_t ProbeBatchSse2(
+            const std::uint64_t* a_buckets,
+            std::uint64_t a_mask,
+            std::uint32_t a_shift,
+            const std::uint64_t* a_keys,
+            std::size_t a_count,
+            std::uint64_t* a_bits) noexcept
+        {
+            const auto empty = _mm_set1_epi64x(static_cast<long long>(kEmptySlot));
+            std::size_t found = 0;
+            for (std::size_t i = 0; i < a_count; ++i) {
+                if (i + kPrefetchDistance < a_count) {
+                    const auto ahead = BucketIndex(a_keys[i + kPrefetchDistance], a_shift);
+                    _mm_prefetch(reinterpret_cast<const char*>(a_buckets + ahead * MarkProbeTable::kBucketSlots), _MM_HINT_T0);
+                }
+
+                const auto key = a_keys[i];
+                if (key == kEmptySlot) {
+                    continue;
+                }
+
+                const auto needle = _mm_set1_epi64x(static_cast<long long>(key));
+                for (auto index = BucketIndex(key, a_shift);; index = (index + 1) & a_mask) {
+                    const auto* bucket = reinterpret_cast<const __m128i*>(a_buckets + index * MarkProbeTable::kBucketSlots);
+                    const auto low = _mm_load_si128(bucket);
+                    const auto high = _mm_load_si128(bucket + 1);
+                    if ((MatchMaskSse2(low, needle) | MatchMaskSse2(high, needle)) != 0) {
+                        SetBit(a_bits, i);
+                        ++found;
+                        break;
+                    }
+                    if ((MatchMaskSse2(low, empty) | MatchMaskSse2(high, empty)) != 0) {
+                        break;
+                    }
+                }
+            }
+            return found;
+        }
+    }
+#endif
+
+    std::size_t MarkProbeTable::ContainsBatch(
+        const std::uint64_t* a_keys,
+        std::size_t a_count,
+        std::uint64_t* a_bits,
+        ProbeIsa a_isa) const noexcept
+    {
+        std::fill_n(a_bits, (a_count + 63) / 64, std::uint64_t{ 0 });
+        if (_buckets.empty() || a_count == 0) {
+            return 0;
+        }
+
+#if RFAB_PROBE_X86
+        const auto* buckets = _buckets.front().slots;
+        if (a_isa == ProbeIsa::kAvx2 && DetectProbeIsa() == ProbeIsa::kAvx2) {
+            return ProbeBatchAvx2(buckets, _mask, _shift, a_keys, a_count, a_bits);
+        }
+        if (a_isa != ProbeIsa::kScalar) {
+            return ProbeBatchSse2(buckets, _mask, _shift, a_keys, a_count, a_bits);
+        }
+#else
+        (void)a_isa;
+#endif
+
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < a_count; ++i) {
+            if (Contains(a_keys[i])) {
+                SetBit(a_bits, i);
+                ++found;
+            }
+        }
+        return found;
+    }
+}
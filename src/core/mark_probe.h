@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    enum class ProbeIsa : std::uint8_t
+    {
+        kScalar,
+        kSse2,
+        kAvx2
+    };
+
+    // Best instruction set this CPU (and OS) supports for probing; detected once.
+    [[nodiscard]] ProbeIsa DetectProbeIsa() noexcept;
+    [[nodiscard]] const char* GetProbeIsaName(ProbeIsa a_isa) noexcept;
+
+    // Open-addressing set of mark keys laid out for SIMD probing: four keys per 32-byte bucket,
+    // kept at most half full, probed bucket by bucket until a hit or a bucket with a free slot.
+    // A few hundred marks fit in a handful of cache lines. Immutable once built.
+    class MarkProbeTable
+    {
+    public:
+        static constexpr std::size_t kBucketSlots = 4;
+
+        MarkProbeTable() = default;
+        explicit MarkProbeTable(std::span<const std::uint64_t> a_keys);
+
+        [[nodiscard]] bool Contains(std::uint64_t a_key) const noexcept;
+
+        // Sets bit i of a_bits (a_bits[i / 64] >> (i % 64)) when a_keys[i] is present and clears it
+        // otherwise; a_bits must hold (a_count + 63) / 64 words. Returns the number present. The
+        // overload without a_isa uses DetectProbeIsa().
+        std::size_t ContainsBatch(const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits) const noexcept;
+        std::size_t ContainsBatch(const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits, ProbeIsa a_isa) const noexcept;
+
+        [[nodiscard]] std::size_t BucketCount() const noexcept { return _buckets.size(); }
+
+    private:
+        struct alignas(32) Bucket
+        {
+            std::uint64_t slots[kBucketSlots];
+        };
+
+        std::vector<Bucket> _buckets;
+        std::uint64_t _mask{ 0 };
+        std::uint32_t _shift{ 63 };
+    };
+}
@@ -0,0 +1,177 @@
+#include "mark_snapshot.h"
+
+#include "mark_store.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        // Moves a_value into a_into unless it is in a_outOf, in which case it is dropped from there:
+        // a flip back to the base's state cancels the pending one.
+        template <class T>
+        void FlipOverlay(std::vector<T>& a_into, std::vector<T>& a_outOf, T a_value)
+        {
+            if (const auto it = std::lower_bound(a_outOf.begin(), a_outOf.end(), a_value); it != a_outOf.end() && *it == a_value) {
+                a_outOf.erase(it);
+                return;
+            }
+            a_into.insert(std::lower_bound(a_into.begin(), a_into.end(), a_value), a_value);
+        }
+
+        template <class T>
+        [[nodiscard]] bool InOverlay(const std::vector<T>& a_overlay, T a_value) noexcept
+        {
+            return !a_overlay.empty() && std::binary_search(a_overlay.begin(), a_overlay.end(), a_value);
+        }
+
+        [[nodiscard]] std::unique_ptr<MarkSnapshot> Derive(const MarkSnapshot& a_previous, std::uint64_t a_generation)
+        {
+            auto next = std::make_unique<MarkSnapshot>(a_previous);
+            next->generation = a_generation;
+            return next;
+        }
+    }
+
+    std::unique_ptr<const MarkSnapshot> MarkSnapshot::Build(const MarkSet& a_marks, std::uint64_t a_generation)
+    {
+        std::vector<std::uint64_t> keys;
+        keys.reserve(a_marks.keys.Size());
+        a_marks.keys.ForEach([&](std::uint64_t a_key) { keys.push_back(a_key); });
+
+        auto base = std::make_shared<MarkSnapshotBase>();
+        base->keyProbe = MarkProbeTable(keys);
+        base->signatures.assign(a_marks.signatures.begin(), a_marks.signatures.end());
+        std::sort(base->signatures.begin(), base->signatures.end());
+
+        auto snapshot = std::make_unique<MarkSnapshot>();
+        snapshot->generation = a_generation;
+        snapshot->keyCount = keys.size();
+        snapshot->signatureCount = base->signatures.size();
+        snapshot->base = std::move(base);
+        return snapshot;
+    }
+
+    std::unique_ptr<const MarkSnapshot> MarkSnapshot::With(
+        const MarkSnapshot& a_previous, std::uint64_t a_key, bool a_marked, std::uint64_t a_generation)
+    {
+        if (a_previous.addedKeys.size() + a_previous.removedKeys.size() >= kMaxOverlay) {
+            return nullptr;
+        }
+
+        auto next = Derive(a_previous, a_generation);
+        if (a_marked) {
+            FlipOverlay(next->addedKeys, next->removedKeys, a_key);
+            ++next->keyCount;
+        } else {
+            FlipOverlay(next->removedKeys, next->addedKeys, a_key);
+            --next->keyCount;
+        }
+        return next;
+    }
+
+    std::unique_ptr<const MarkSnapshot> MarkSnapshot::With(
+        const MarkSnapshot& a_previous, MarkSignature a_signature, bool a_marked, std::uint64_t a_generation)
+    {
+        if (a_previous.addedSignatures.size() + a_previous.removedSignatures.size() >= kMaxOverlay) {
+            return nullptr;
+        }
+
+        auto next = Derive(a_previous, a_generation);
+        if (a_marked) {
+            FlipOverlay(next->addedSignatures, next->removedSignatures, a_signature);
+            ++next->signatureCount;
+        } else {
+            FlipOverlay(next->removedSignatures, next->addedSignatures, a_signature);
+            --next->signatureCount;
+        }
+        return next;
+    }
+
+    bool MarkSnapshot::Contains(std::uint64_t a_key) const noexcept
+    {
+        if (InOverlay(addedKeys, a_key)) {
+            return true;
+        }
+        return !InOverlay(removedKeys, a_key) && base->keyProbe.Contains(a_key);
+    }
+
+    bool MarkSnapshot::Contains(MarkSignature a_signature) const noexcept
+    {
+        if (InOverlay(addedSignatures, a_signature)) {
+            return true;
+        }
+        return !InOverlay(removedSignatures, a_signature) &&
+               std::binary_search(base->signatures.begin(), base->signatures.end(), a_signature);
+    }
+
+    std::size_t MarkSnapshot::ContainsBatch(const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits) const noexcept
+    {
+        auto found = base->keyProbe.ContainsBatch(a_keys, a_count, a_bits);
+        if (addedKeys.empty() && removedKeys.empty()) {
+            return found;
+        }
+
+        for (std::size_t i = 0; i < a_count; ++i) {
+            const auto bit = std::uint64_t{ 1 } << (i % 64);
+            auto& word = a_bits[i / 64];
+            if (!(word & bit) && InOverlay(addedKeys, a_keys[i])) {
+                word |= bit;
+                ++found;
+            } else if ((word & bit) && InOverlay(removedKeys, a_keys[i])) {
+                word &= ~bit;
+                --found;
+            }
+        }
+        return found;
+    }
+
+    MarkSnapshotCell::ReadGuard::ReadGuard(const MarkSnapshotCell& a_cell) noexcept :
+        _cell(a_cell),
+        _epoch(a_cell._epoch.load(std::memory_order_seq_cst) & 1u)
+    {
+        // The counter goes up before the pointer is read; a publisher that swaps after this
+        // point either is seen by the load below or waits for this epoch to drain.
+        _cell._readers[_epoch].fetch_add(1, std::memory_order_seq_cst);
+        _snapshot = _cell._current.load(std::memory_order_seq_cst);
+    }
+
+    MarkSnapshotCell::ReadGuard::~ReadGuard()
+    {
+        _cell._readers[_epoch].fetch_sub(1, std::memory_order_release);
+    }
+
+    MarkSnapshotCell::MarkSnapshotCell() :
+        _current(new MarkSnapshot{})
+    {}
+
+    MarkSnapshotCell::~MarkSnapshotCell()
+    {
+        delete _current.load(std::memory_order_relaxed);
+    }
+
+    void MarkSnapshotCell::Publish(std::unique_ptr<const MarkSnapshot> a_snapshot)
+    {
+        const auto* previous = _current.exchange(a_snapshot.release(), std::memory_order_seq_cst);
+
+        // A reader may have picked its epoch just before a flip, so one drain is not enough:
+        // flip and drain twice, after which nobody can still hold the previous pointer.
+        for (int pass = 0; pass < 2; ++pass) {
+            const auto epoch = _epoch.fetch_add(1, std::memory_order_seq_cst) & 1u;
+            WaitForReaders(epoch);
+        }
+
+        delete previous;
+    }
+
+    void MarkSnapshotCell::WaitForReaders(std::uint32_t a_epoch) const noexcept
+    {
+        for (std::uint32_t spins = 0; _readers[a_epoch].load(std::memory_order_acquire) != 0; ++spins) {
+            if (spins > 64) {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "mark_key.h"
+#include "mark_probe.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    struct MarkSet;
+
+    // What a full rebuild of a snapshot produces: every key in a SIMD-probed hash table and the
+    // signatures sorted. Shared by every snapshot derived from it by single-mark updates.
+    struct MarkSnapshotBase
+    {
+        MarkProbeTable keyProbe;
+        std::vector<MarkSignature> signatures;
+    };
+
+    // Immutable view of the mark set as of one generation. The bulk lives in a shared base; marks
+    // changed since it was built sit in small sorted overlays, so a single mark or unmark copies
+    // only those instead of rebuilding the table. Lookups never touch the store's lock.
+    struct MarkSnapshot
+    {
+        // Overlay size past which a single-mark update rebuilds the base instead.
+        static constexpr std::size_t kMaxOverlay = 256;
+
+        std::uint64_t generation{ 0 };
+        std::shared_ptr<const MarkSnapshotBase> base{ std::make_shared<const MarkSnapshotBase>() };
+        std::vector<std::uint64_t> addedKeys;             // ascending, not in base
+        std::vector<std::uint64_t> removedKeys;           // ascending, in base
+        std::vector<MarkSignature> addedSignatures;       // ascending, not in base
+        std::vector<MarkSignature> removedSignatures;     // ascending, in base
+        std::size_t keyCount{ 0 };
+        std::size_t signatureCount{ 0 };
+
+        [[nodiscard]] static std::unique_ptr<const MarkSnapshot> Build(const MarkSet& a_marks, std::uint64_t a_generation);
+        // a_previous with one key (or signature) flipped to a_marked, which must differ from its
+        // state in a_previous. Returns nullptr once the overlays would outgrow kMaxOverlay.
+        [[nodiscard]] static std::unique_ptr<const MarkSnapshot> With(
+            const MarkSnapshot& a_previous, std::uint64_t a_key, bool a_marked, std::uint64_t a_generation);
+        [[nodiscard]] static std::unique_ptr<const MarkSnapshot> With(
+            const MarkSnapshot& a_previous, MarkSignature a_signature, bool a_marked, std::uint64_t a_generation);
+
+        [[nodiscard]] bool Contains(std::uint64_t a_key) const noexcept;
+        [[nodiscard]] bool Contains(MarkSignature a_signature) const noexcept;
+        // MarkProbeTable::ContainsBatch against this generation, overlays included.
+        std::size_t ContainsBatch(const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits) const noexcept;
+    };
+
+    // Read-copy-update cell for the current snapshot. Readers pin the snapshot by bumping one of
+    // two epoch counters and never block; a publisher swaps the pointer, then waits until both
+    // epochs have drained once before freeing the old snapshot. Publishers must be serialized by
+    // the caller and must not publish while holding a ReadGuard on the same thread.
+    class MarkSnapshotCell
+    {
+    public:
+        class ReadGuard
+        {
+        public:
+            explicit ReadGuard(const MarkSnapshotCell& a_cell) noexcept;
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+            ~ReadGuard();
+
+            [[nodiscard]] const MarkSnapshot& operator*() const noexcept { return *_snapshot; }
+            [[nodiscard]] const MarkSnapshot* operator->() const noexcept { return _snapshot; }
+
+        private:
+            const MarkSnapshotCell& _cell;
+            std::uint32_t _epoch;
+            const MarkSnapshot* _snapshot;
+        };
+
+        MarkSnapshotCell();
+        MarkSnapshotCell(const MarkSnapshotCell&) = delete;
+        MarkSnapshotCell& operator=(const MarkSnapshotCell&) = delete;
+        ~MarkSnapshotCell();
+
+        [[nodiscard]] ReadGuard Read() const noexcept { return ReadGuard(*this); }
+        void Publish(std::unique_ptr<const MarkSnapshot> a_snapshot);
+
+    private:
+        void WaitForReaders(std::uint32_t a_epoch) const noexcept;
+
+        std::atomic<const MarkSnapshot*> _current;
+        mutable std::atomic<std::uint32_t> _epoch{ 0 };
+        mutable std::array<std::atomic<std::uint32_t>, 2> _readers{};
+    };
+}
@@ -0,0 +1,252 @@
+#include "mark_store.h"
+
+#include <algorithm>
+
+namespace RFAB::Disenchant
+{
+    bool MarkStore::Mark(std::uint64_t a_key)
+    {
+        std::scoped_lock lk(_lock);
+        if (!_marks.keys.Insert(a_key)) {
+            return false;
+        }
+
+        Journal(JournalOp::kMarkKey, a_key);
+        PublishLocked(a_key, true);
+        return true;
+    }
+
+    bool MarkStore::Mark(MarkSignature a_signature)
+    {
+        std::scoped_lock lk(_lock);
+        if (!_marks.signatures.insert(a_signature).second) {
+            return false;
+        }
+
+        Journal(JournalOp::kMarkSignature, static_cast<std::uint64_t>(a_signature));
+        PublishLocked(a_signature, true);
+        return true;
+    }
+
+    bool MarkStore::Unmark(std::uint64_t a_key)
+    {
+        std::scoped_lock lk(_lock);
+        if (!_marks.keys.Erase(a_key)) {
+            return false;
+        }
+
+        Journal(JournalOp::kUnmarkKey, a_key);
+        PublishLocked(a_key, false);
+        return true;
+    }
+
+    bool MarkStore::Unmark(MarkSignature a_signature)
+    {
+        std::scoped_lock lk(_lock);
+        if (_marks.signatures.erase(a_signature) == 0) {
+            return false;
+        }
+
+        Journal(JournalOp::kUnmarkSignature, static_cast<std::uint64_t>(a_signature));
+        PublishLocked(a_signature, false);
+        return true;
+    }
+
+    std::size_t MarkStore::Mark(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures)
+    {
+        std::scoped_lock lk(_lock);
+        std::size_t added = 0;
+        for (const auto key : a_keys) {
+            if (_marks.keys.Insert(key)) {
+                Journal(JournalOp::kMarkKey, key);
+                ++added;
+            }
+        }
+        for (const auto signature : a_signatures) {
+            if (_marks.signatures.insert(signature).second) {
+                Journal(JournalOp::kMarkSignature, static_cast<std::uint64_t>(signature));
+                ++added;
+            }
+        }
+
+        if (added != 0) {
+            PublishLocked();
+        }
+        return added;
+    }
+
+    std::size_t MarkStore::Unmark(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures)
+    {
+        std::scoped_lock lk(_lock);
+        std::size_t removed = 0;
+        for (const auto key : a_keys) {
+            if (_marks.keys.Erase(key)) {
+                Journal(JournalOp::kUnmarkKey, key);
+                ++removed;
+            }
+        }
+        for (const auto signature : a_signatures) {
+            if (_marks.signatures.erase(signature) != 0) {
+                Journal(JournalOp::kUnmarkSignature, static_cast<std::uint64_t>(signature));
+                ++removed;
+            }
+        }
+
+        if (removed != 0) {
+            PublishLocked();
+        }
+        return removed;
+    }
+
+    bool MarkStore::IsMarked(std::uint64_t a_key) const
+    {
+        return _snapshot.Read()->Contains(a_key);
+    }
+
+    bool MarkStore::IsMarked(MarkSignature a_signature) const
+    {
+        return _snapshot.Read()->Contains(a_signature);
+    }
+
+    std::size_t MarkStore::AreMarked(std::span<const std::uint64_t> a_keys, std::uint64_t* a_bits) const
+    {
+        return _snapshot.Read()->ContainsBatch(a_keys.data(), a_keys.size(), a_bits);
+    }
+
+    std::uint64_t MarkStore::Generation() const
+    {
+        return _snapshot.Read()->generation;
+    }
+
+    std::size_t MarkStore::KeyCount() const
+    {
+        return _snapshot.Read()->keyCount;
+    }
+
+    std::size_t MarkStore::SignatureCount() const
+    {
+        return _snapshot.Read()->signatureCount;
+    }
+
+    void MarkStore::Replace(MarkSet a_marks)
+    {
+        std::scoped_lock lk(_lock);
+        _marks = std::move(a_marks);
+        PublishLocked();
+    }
+
+    void MarkStore::Clear()
+    {
+        std::scoped_lock lk(_lock);
+        _marks.keys.Clear();
+        _marks.signatures.clear();
+        PublishLocked();
+    }
+
+    bool MarkStore::AttachJournal(const std::filesystem::path& a_path, std::uint64_t a_baseToken, std::size_t* a_replayed)
+    {
+        if (a_replayed) {
+            *a_replayed = 0;
+        }
+
+        std::scoped_lock lk(_lock);
+        _journalFailed = false;
+        if (!_journal.Open(a_path)) {
+            _journalFailed = true;
+            return false;
+        }
+
+        if (_journal.BaseToken() != a_baseToken) {
+            return _journal.Reset(a_baseToken);
+        }
+
+        // The token only moves on the next save, so the same save loaded twice would find these
+        // ops again; they are spent once replayed.
+        const auto replayed = _journal.Replay([this](JournalOp a_op, std::uint64_t a_value) { Apply(a_op, a_value); });
+        if (replayed != 0) {
+            PublishLocked();
+        }
+        if (a_replayed) {
+            *a_replayed = replayed;
+        }
+        if (!_journal.Reset(a_baseToken)) {
+            _journal.Close();
+            _journalFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool MarkStore::CompactJournal(std::uint64_t a_baseToken)
+    {
+        std::scoped_lock lk(_lock);
+        return _journal.Reset(a_baseToken);
+    }
+
+    void MarkStore::DetachJournal()
+    {
+        std::scoped_lock lk(_lock);
+        _journal.Close();
+        _journalFailed = false;
+    }
+
+    bool MarkStore::HasJournal() const
+    {
+        std::scoped_lock lk(_lock);
+        return _journal.IsOpen();
+    }
+
+    bool MarkStore::JournalFailed() const
+    {
+        std::scoped_lock lk(_lock);
+        return _journalFailed;
+    }
+
+    void MarkStore::Apply(JournalOp a_op, std::uint64_t a_value)
+    {
+        switch (a_op) {
+        case JournalOp::kMarkKey:
+            _marks.keys.Insert(a_value);
+            break;
+        case JournalOp::kUnmarkKey:
+            _marks.keys.Erase(a_value);
+            break;
+        case JournalOp::kMarkSignature:
+            _marks.signatures.insert(static_cast<MarkSignature>(a_value));
+            break;
+        case JournalOp::kUnmarkSignature:
+            _marks.signatures.erase(static_cast<MarkSignature>(a_value));
+            break;
+        }
+    }
+
+    void MarkStore::PublishLocked()
+    {
+        _snapshot.Publish(MarkSnapshot::Build(_marks, ++_generation));
+    }
+
+    template <class T>
+    void MarkStore::PublishLocked(T a_changed, bool a_marked)
+    {
+        std::unique_ptr<const MarkSnapshot> next;
+        {
+            const auto current = _snapshot.Read();
+            next = MarkSnapshot::With(*current, a_changed, a_marked, _generation + 1);
+        }
+        if (!next) {
+            PublishLocked();
+            return;
+        }
+
+        ++_generation;
+        _snapshot.Publish(std::move(next));
+    }
+
+    void MarkStore::Journal(JournalOp a_op, std::uint64_t a_value)
+    {
+        if (_journal.IsOpen() && !_journal.Append(a_op, a_value)) {
+            _journal.Close();
+            _journalFailed = true;
+        }
+    }
+}
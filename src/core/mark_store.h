@@ -0,0 +1,85 @@
+#pragma once
+
+#include "journal.h"
+#include "mark_key.h"
+#include "mark_key_set.h"
+#include "mark_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <unordered_set>
+
+namespace RFAB::Disenchant
+{
+    struct MarkSet
+    {
+        MarkKeySet keys;
+        std::unordered_set<MarkSignature, MarkSignatureHash> signatures;
+    };
+
+    // Thread-safe set of marked instances. Every change that goes through Mark/Unmark is also
+    // appended to the attached journal, if any. Writers serialize on a mutex and publish an
+    // immutable snapshot; every query reads the published snapshot without locking. A single
+    // mark or unmark publishes an overlay on the previous snapshot rather than a rebuild.
+    class MarkStore
+    {
+    public:
+        bool Mark(std::uint64_t a_key);
+        bool Mark(MarkSignature a_signature);
+        bool Unmark(std::uint64_t a_key);
+        bool Unmark(MarkSignature a_signature);
+        // Batch forms: one lock and one snapshot rebuild for the whole set, journaling each
+        // change. Return how many actually changed state. Callers touching more than one mark
+        // at a time go through these rather than publishing once per mark.
+        std::size_t Mark(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures);
+        std::size_t Unmark(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures);
+
+        [[nodiscard]] bool IsMarked(std::uint64_t a_key) const;
+        [[nodiscard]] bool IsMarked(MarkSignature a_signature) const;
+        // Sets bit i of a_bits (which holds (keys + 63) / 64 words) when a_keys[i] is marked, all
+        // against one generation. Returns the number of marked keys.
+        std::size_t AreMarked(std::span<const std::uint64_t> a_keys, std::uint64_t* a_bits) const;
+        // Bumped by every change; callers caching query results revalidate when it moves.
+        [[nodiscard]] std::uint64_t Generation() const;
+
+        [[nodiscard]] std::size_t KeyCount() const;
+        [[nodiscard]] std::size_t SignatureCount() const;
+
+        // Replaces the contents without journaling; used when restoring from the co-save.
+        void Replace(MarkSet a_marks);
+        void Clear();
+
+        template <class F>
+        decltype(auto) Visit(F&& a_visitor) const
+        {
+            std::scoped_lock lk(_lock);
+            return std::forward<F>(a_visitor)(_marks);
+        }
+
+        // Opens the journal at a_path. If it was compacted against a_baseToken its ops are
+        // replayed on top of the current contents; either way it is then reset to a_baseToken,
+        // so no op is ever replayed twice.
+        [[nodiscard]] bool AttachJournal(const std::filesystem::path& a_path, std::uint64_t a_baseToken, std::size_t* a_replayed = nullptr);
+        [[nodiscard]] bool CompactJournal(std::uint64_t a_baseToken);
+        void DetachJournal();
+        [[nodiscard]] bool HasJournal() const;
+        [[nodiscard]] bool JournalFailed() const;
+
+    private:
+        void Apply(JournalOp a_op, std::uint64_t a_value);
+        void Journal(JournalOp a_op, std::uint64_t a_value);
+        void PublishLocked();
+        template <class T>
+        void PublishLocked(T a_changed, bool a_marked);
+
+        mutable std::mutex _lock;
+        MarkSet _marks;
+        std::uint64_t _generation{ 0 };
+        MarkSnapshotCell _snapshot;
+        MarkJournal _journal;
+        bool _journalFailed{ false };
+    };
+}
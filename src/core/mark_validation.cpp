@@ -0,0 +1,139 @@
+#include "mark_validation.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        // Below this many keys per worker a thread costs more than the lookups it takes over.
+        constexpr std::size_t kMinKeysPerWorker = 4096;
+        // Keys judged between two looks at the stop token.
+        constexpr std::size_t kKeysPerStopCheck = 1024;
+
+        [[nodiscard]] bool Resolves(const MarkValidationSnapshot& a_snapshot, std::uint32_t a_formID)
+        {
+            return std::binary_search(a_snapshot.resolvedForms.begin(), a_snapshot.resolvedForms.end(), a_formID);
+        }
+
+        [[nodiscard]] const MarkLocationIndex::Entry* FindLocation(const MarkValidationSnapshot& a_snapshot, std::uint64_t a_key)
+        {
+            const auto it = std::lower_bound(
+                a_snapshot.locations.begin(),
+                a_snapshot.locations.end(),
+                a_key,
+                [](const MarkLocationIndex::Entry& a_entry, std::uint64_t a_value) { return a_entry.key < a_value; });
+            return it != a_snapshot.locations.end() && it->key == a_key ? &*it : nullptr;
+        }
+
+        [[nodiscard]] std::size_t WorkerCount(std::size_t a_requested, std::size_t a_keys)
+        {
+            auto workers = a_requested != 0 ? a_requested : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+            return std::clamp<std::size_t>(a_keys / kMinKeysPerWorker, 1, workers);
+        }
+    }
+
+    MarkVerdict ValidateMarkKey(const MarkValidationSnapshot& a_snapshot, std::uint64_t a_key)
+    {
+        if (std::binary_search(a_snapshot.heldKeys.begin(), a_snapshot.heldKeys.end(), a_key)) {
+            return MarkVerdict::kHeld;
+        }
+
+        if (!Resolves(a_snapshot, static_cast<std::uint32_t>(a_key >> 16u))) {
+            return MarkVerdict::kStale;
+        }
+
+        // The index lags behind moves it never saw an event for, so "on the player but not held"
+        // proves nothing; only an owner that is itself gone condemns the key.
+        if (const auto* entry = FindLocation(a_snapshot, a_key); entry && entry->location.ownerFormID != a_snapshot.playerFormID) {
+            return Resolves(a_snapshot, entry->location.ownerFormID) ? MarkVerdict::kElsewhere : MarkVerdict::kStale;
+        }
+
+        return MarkVerdict::kUnknown;
+    }
+
+    MarkVerdict ValidateMarkSignature(const MarkValidationSnapshot& a_snapshot, MarkSignature a_signature)
+    {
+        if (std::binary_search(a_snapshot.heldSignatures.begin(), a_snapshot.heldSignatures.end(), a_signature)) {
+            return MarkVerdict::kHeld;
+        }
+
+        return Resolves(a_snapshot, GetSignatureObjectFormID(a_signature)) && Resolves(a_snapshot, GetSignatureEnchantmentFormID(a_signature)) ?
+                   MarkVerdict::kUnknown :
+                   MarkVerdict::kStale;
+    }
+
+    MarkValidationResult ValidateMarks(const MarkValidationSnapshot& a_snapshot, std::size_t a_workers, std::stop_token a_stop)
+    {
+        const auto& keys = a_snapshot.marks;
+        std::vector<MarkVerdict> verdicts(keys.size());
+        const auto judge = [&](std::size_t a_begin, std::size_t a_end) {
+            for (auto block = a_begin; block < a_end && !a_stop.stop_requested(); block += kKeysPerStopCheck) {
+                const auto blockEnd = std::min(block + kKeysPerStopCheck, a_end);
+                std::transform(keys.begin() + block, keys.begin() + blockEnd, verdicts.begin() + block, [&](std::uint64_t a_key) {
+                    return ValidateMarkKey(a_snapshot, a_key);
+                });
+            }
+        };
+
+        // Every worker writes a disjoint slice of verdicts against the shared read-only snapshot;
+        // the calling thread takes the first slice itself.
+        MarkValidationResult result;
+        result.workers = WorkerCount(a_workers, keys.size());
+        const auto slice = (keys.size() + result.workers - 1) / result.workers;
+        {
+            std::vector<std::jthread> pool;
+            pool.reserve(result.workers - 1);
+            for (std::size_t worker = 1; worker < result.workers; ++worker) {
+                const auto begin = std::min(worker * slice, keys.size());
+                const auto end = std::min(begin + slice, keys.size());
+                pool.emplace_back(judge, begin, end);
+            }
+            judge(0, std::min(slice, keys.size()));
+        }
+        if (a_stop.stop_requested()) {
+            result.stopped = true;
+            return result;
+        }
+
+        const auto tally = [&](MarkVerdict a_verdict) {
+            switch (a_verdict) {
+            case MarkVerdict::kHeld:
+                ++result.held;
+                break;
+            case MarkVerdict::kElsewhere:
+                ++result.elsewhere;
+                break;
+            case MarkVerdict::kUnknown:
+                ++result.unknown;
+                break;
+            case MarkVerdict::kStale:
+                break;
+            }
+        };
+
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            tally(verdicts[i]);
+            if (verdicts[i] == MarkVerdict::kStale) {
+                result.staleKeys.push_back(keys[i]);
+            } else if (verdicts[i] == MarkVerdict::kHeld) {
+                const auto* entry = FindLocation(a_snapshot, keys[i]);
+                if (!entry || entry->location.ownerFormID != a_snapshot.playerFormID) {
+                    result.reindexKeys.push_back(keys[i]);
+                }
+            }
+        }
+
+        // Signature marks are a legacy of saves from before unique IDs and are let go with the
+        // last carried instance of their pair, so there are few enough of them to judge inline.
+        for (const auto signature : a_snapshot.signatures) {
+            const auto verdict = ValidateMarkSignature(a_snapshot, signature);
+            tally(verdict);
+            if (verdict == MarkVerdict::kStale) {
+                result.staleSignatures.push_back(signature);
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mark_key.h"
+#include "mark_location.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stop_token>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    // Flat, read-only copy of everything load-time validation looks at, captured on the game
+    // thread so the checks themselves can run on any thread without touching a game object.
+    struct MarkValidationSnapshot
+    {
+        std::vector<std::uint64_t> marks;                 // marked keys, ascending
+        std::vector<MarkSignature> signatures;            // marked signatures
+        std::vector<MarkLocationIndex::Entry> locations;  // ascending by key
+        std::vector<std::uint64_t> heldKeys;              // ExtraUniqueID keys in the player's inventory, ascending
+        std::vector<MarkSignature> heldSignatures;        // object + enchantment of the player's entries, ascending
+        std::vector<std::uint32_t> resolvedForms;         // FormIDs referenced by the above that still resolve, ascending
+        std::uint32_t playerFormID{ 0x14 };
+        std::uint64_t generation{ 0 };                    // MarkStore::Generation() at capture
+    };
+
+    enum class MarkVerdict : std::uint8_t
+    {
+        kHeld,       // in the player's inventory
+        kElsewhere,  // indexed at another owner that still exists
+        kUnknown,    // not held, and the index has nothing better than the player or no entry; kept
+        kStale       // its base form is gone, or the index places it at an owner that is gone
+    };
+
+    [[nodiscard]] MarkVerdict ValidateMarkKey(const MarkValidationSnapshot& a_snapshot, std::uint64_t a_key);
+    [[nodiscard]] MarkVerdict ValidateMarkSignature(const MarkValidationSnapshot& a_snapshot, MarkSignature a_signature);
+
+    struct MarkValidationResult
+    {
+        std::vector<std::uint64_t> staleKeys;
+        std::vector<MarkSignature> staleSignatures;
+        std::vector<std::uint64_t> reindexKeys;  // held keys the location index does not place on the player
+        std::size_t held{ 0 };
+        std::size_t elsewhere{ 0 };
+        std::size_t unknown{ 0 };
+        std::size_t workers{ 0 };
+        bool stopped{ false };  // a_stop fired; the verdicts are incomplete and must not be applied
+    };
+
+    // Judges every mark in a_snapshot, splitting the keys across up to a_workers threads
+    // (0: one per hardware thread). Small sets stay on the calling thread. Every worker polls
+    // a_stop between blocks of keys.
+    [[nodiscard]] MarkValidationResult ValidateMarks(
+        const MarkValidationSnapshot& a_snapshot,
+        std::size_t a_workers = 0,
+        std::stop_token a_stop = {});
+}
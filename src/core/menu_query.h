@@ -0,0 +1,171 @@
+#pragma once
+
+#include "entry_query.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace RFAB::Disenchant
+{
+    // Adapter over the enchanting menu's list. RowAt returns nullptr for rows that are not
+    // item rows (the game's skyrim_cast to ItemChangeEntry failing).
+    template <class T>
+    concept MenuTraits = EntryTraits<T> && requires(typename T::Menu* a_menu, typename T::Row* a_row, std::size_t a_index) {
+        { T::RowCount(a_menu) } -> std::convertible_to<std::size_t>;
+        { T::RowAt(a_menu, a_index) } -> std::same_as<typename T::Row*>;
+        { T::HighlightIndex(a_menu) } -> std::convertible_to<std::size_t>;
+        { T::SelectedData(a_menu) } -> std::same_as<typename T::Entry*>;
+        { T::RowData(a_row) } -> std::same_as<typename T::Entry*>;
+        { T::IsRowSelected(a_row) } -> std::same_as<bool>;
+        T::SetRowEnabled(a_row, true);
+    };
+
+    template <MenuTraits T>
+    [[nodiscard]] typename T::Row* GetHighlightedRow(typename T::Menu* a_menu)
+    {
+        if (!a_menu) {
+            return nullptr;
+        }
+
+        const std::size_t index = T::HighlightIndex(a_menu);
+        return index < T::RowCount(a_menu) ? T::RowAt(a_menu, index) : nullptr;
+    }
+
+    // Selected item, then highlighted row, then the first row flagged selected, then the first row.
+    template <MenuTraits T>
+    [[nodiscard]] typename T::Entry* ResolveDisenchantSelection(typename T::Menu* a_menu)
+    {
+        if (!a_menu) {
+            return nullptr;
+        }
+
+        if (auto* selected = T::SelectedData(a_menu)) {
+            return selected;
+        }
+
+        if (auto* highlighted = GetHighlightedRow<T>(a_menu)) {
+            if (auto* data = T::RowData(highlighted)) {
+                return data;
+            }
+        }
+
+        const std::size_t count = T::RowCount(a_menu);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto* row = T::RowAt(a_menu, i);
+            if (row && T::IsRowSelected(row)) {
+                if (auto* data = T::RowData(row)) {
+                    return data;
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            auto* row = T::RowAt(a_menu, i);
+            if (row) {
+                if (auto* data = T::RowData(row)) {
+                    return data;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Reusable buffers for CollectMarkedRows, so a refresh does not allocate once warmed up.
+    struct MarkedRowScratch
+    {
+        explicit MarkedRowScratch(std::pmr::memory_resource* a_resource = std::pmr::get_default_resource()) :
+            keys(a_resource),
+            keyRows(a_resource),
+            keyBits(a_resource),
+            rowBits(a_resource)
+        {}
+
+        std::pmr::vector<std::uint64_t> keys;
+        std::pmr::vector<std::uint32_t> keyRows;
+        std::pmr::vector<std::uint64_t> keyBits;
+        std::pmr::vector<std::uint64_t> rowBits;
+
+        [[nodiscard]] bool IsRowMarked(std::size_t a_row) const noexcept
+        {
+            return a_row / 64 < rowBits.size() && ((rowBits[a_row / 64] >> (a_row % 64)) & 1u) != 0;
+        }
+    };
+
+    // Same verdict as IsEntryMarked for every row, but the unique-ID keys of all rows go through
+    // one MarkStore::AreMarked batch; only rows none of whose keys hit pay for the signature and
+    // ExtraEnchantment checks. Fills a_scratch.rowBits (bit i = row i) and returns the marked count.
+    template <MenuTraits T>
+    std::size_t CollectMarkedRows(const MarkStore& a_store, typename T::Menu* a_menu, MarkedRowScratch& a_scratch)
+    {
+        a_scratch.keys.clear();
+        a_scratch.keyRows.clear();
+        a_scratch.rowBits.clear();
+        if (!a_menu) {
+            return 0;
+        }
+
+        const std::size_t count = T::RowCount(a_menu);
+        a_scratch.rowBits.assign((count + 63) / 64, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto* row = T::RowAt(a_menu, i);
+            auto* data = row ? T::RowData(row) : nullptr;
+            if (data) {
+                T::ForEachUniqueKey(data, [&](std::uint64_t a_key) {
+                    a_scratch.keys.push_back(a_key);
+                    a_scratch.keyRows.push_back(static_cast<std::uint32_t>(i));
+                    return false;
+                });
+            }
+        }
+
+        a_scratch.keyBits.resize((a_scratch.keys.size() + 63) / 64);
+        if (a_store.AreMarked(a_scratch.keys, a_scratch.keyBits.data()) != 0) {
+            for (std::size_t k = 0; k < a_scratch.keys.size(); ++k) {
+                if ((a_scratch.keyBits[k / 64] >> (k % 64)) & 1u) {
+                    const auto row = a_scratch.keyRows[k];
+                    a_scratch.rowBits[row / 64] |= std::uint64_t{ 1 } << (row % 64);
+                }
+            }
+        }
+
+        std::size_t marked = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (a_scratch.IsRowMarked(i)) {
+                ++marked;
+                continue;
+            }
+
+            auto* row = T::RowAt(a_menu, i);
+            auto* data = row ? T::RowData(row) : nullptr;
+            if (!data) {
+                continue;
+            }
+
+            const auto signature = T::GetSignature(data);
+            if ((signature && a_store.IsMarked(*signature)) || T::HasExtraEnchantment(data)) {
+                a_scratch.rowBits[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+                ++marked;
+            }
+        }
+        return marked;
+    }
+
+    template <MenuTraits T>
+    void ForceEnableMarkedRows(const MarkStore& a_store, typename T::Menu* a_menu, MarkedRowScratch& a_scratch)
+    {
+        if (CollectMarkedRows<T>(a_store, a_menu, a_scratch) == 0) {
+            return;
+        }
+
+        const std::size_t count = T::RowCount(a_menu);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (a_scratch.IsRowMarked(i)) {
+                T::SetRowEnabled(T::RowAt(a_menu, i), true);
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace RFAB::Disenchant
+{
+    // Keeps at most one copy of a UI message in flight. TryBegin() succeeds for the first sender;
+    // everyone after that is counted as saved until the owner calls End() once the recipient has
+    // seen the message, or can no longer see it.
+    class PendingMessageGate
+    {
+    public:
+        [[nodiscard]] bool TryBegin() noexcept
+        {
+            if (_inFlight.exchange(true, std::memory_order_acq_rel)) {
+                _saved.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            _sent.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void End() noexcept
+        {
+            _inFlight.store(false, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool InFlight() const noexcept { return _inFlight.load(std::memory_order_acquire); }
+        [[nodiscard]] std::uint64_t Sent() const noexcept { return _sent.load(std::memory_order_relaxed); }
+        [[nodiscard]] std::uint64_t Saved() const noexcept { return _saved.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic_bool _inFlight{ false };
+        std::atomic<std::uint64_t> _sent{ 0 };
+        std::atomic<std::uint64_t> _saved{ 0 };
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace RFAB::Disenchant
+{
+    // How much of the enchanting menu has to be rebuilt. Each level includes everything below it.
+    enum class RefreshLevel : std::uint8_t
+    {
+        kNone,
+        kInterface,  // UpdateInterface
+        kRows,       // re-apply per-row enabled/disabled state, then kInterface
+        kList,       // UpdateConstructibleList, then kRows
+        kReload      // re-show the crafting menu, then kList
+    };
+
+    // Collects refresh requests from any thread and hands out one combined level per flush.
+    // Only the request that finds nothing pending gets true from Request(), so exactly one flush
+    // is queued no matter how many paths ask before it runs.
+    class RefreshScheduler
+    {
+    public:
+        // Raises the pending level to at least a_level. Returns true when the caller must queue
+        // the flush.
+        [[nodiscard]] bool Request(RefreshLevel a_level) noexcept
+        {
+            if (a_level == RefreshLevel::kNone) {
+                return false;
+            }
+
+            _requests.fetch_add(1, std::memory_order_relaxed);
+            const auto level = static_cast<std::uint8_t>(a_level);
+            auto pending = _pending.load(std::memory_order_relaxed);
+            while (pending < level && !_pending.compare_exchange_weak(pending, level, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            }
+            return pending == static_cast<std::uint8_t>(RefreshLevel::kNone);
+        }
+
+        // Claims the pending level for the flush about to run. Requests made from here on queue
+        // the next flush.
+        [[nodiscard]] RefreshLevel Take() noexcept
+        {
+            const auto level = static_cast<RefreshLevel>(_pending.exchange(0, std::memory_order_acq_rel));
+            if (level != RefreshLevel::kNone) {
+                _flushes.fetch_add(1, std::memory_order_relaxed);
+            }
+            return level;
+        }
+
+        [[nodiscard]] std::uint64_t Requests() const noexcept { return _requests.load(std::memory_order_relaxed); }
+        [[nodiscard]] std::uint64_t Flushes() const noexcept { return _flushes.load(std::memory_order_relaxed); }
+
+        // Requests folded into a flush that was already queued.
+        [[nodiscard]] std::uint64_t Coalesced() const noexcept
+        {
+            const auto flushes = Flushes();
+            const auto requests = Requests();
+            return requests > flushes ? requests - flushes : 0;
+        }
+
+    private:
+        std::atomic<std::uint8_t> _pending{ 0 };
+        std::atomic<std::uint64_t> _requests{ 0 };
+        std::atomic<std::uint64_t> _flushes{ 0 };
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <unordered_map>
+
+namespace RFAB::Disenchant
+{
+    struct PrewarmedRow
+    {
+        bool marked{ false };
+        bool hasEnchantment{ false };
+    };
+
+    // Row state computed ahead of the first Disenchant list pass, keyed by inventory entry.
+    // Everything in it belongs to one mark store generation; a lookup under any other generation
+    // misses, and Begin() starts over. Retire() turns it off for the rest of the session once
+    // live evaluation is cheaper than trusting it. Not thread-safe.
+    class RowPrewarmCache
+    {
+    public:
+        explicit RowPrewarmCache(std::pmr::memory_resource* a_resource = std::pmr::get_default_resource()) :
+            _rows(a_resource)
+        {}
+
+        void Begin(std::uint64_t a_generation)
+        {
+            _rows.clear();
+            _generation = a_generation;
+            _active = true;
+        }
+
+        void Put(const void* a_entry, PrewarmedRow a_row)
+        {
+            if (_active) {
+                _rows.insert_or_assign(a_entry, a_row);
+            }
+        }
+
+        [[nodiscard]] std::optional<PrewarmedRow> Find(const void* a_entry, std::uint64_t a_generation)
+        {
+            if (!_active) {
+                return std::nullopt;
+            }
+
+            const auto it = a_generation == _generation ? _rows.find(a_entry) : _rows.end();
+            if (it == _rows.end()) {
+                ++_misses;
+                return std::nullopt;
+            }
+            ++_hits;
+            return it->second;
+        }
+
+        void Retire() noexcept
+        {
+            _rows.clear();
+            _active = false;
+        }
+
+        [[nodiscard]] bool Active() const noexcept { return _active; }
+        [[nodiscard]] std::uint64_t Generation() const noexcept { return _generation; }
+        [[nodiscard]] std::size_t Size() const noexcept { return _rows.size(); }
+        [[nodiscard]] std::size_t Hits() const noexcept { return _hits; }
+        [[nodiscard]] std::size_t Misses() const noexcept { return _misses; }
+
+    private:
+        std::pmr::unordered_map<const void*, PrewarmedRow> _rows;
+        std::uint64_t _generation{ 0 };
+        std::size_t _hits{ 0 };
+        std::size_t _misses{ 0 };
+        bool _active{ false };
+    };
+}
@@ -0,0 +1,88 @@
+#include "session_arena.h"
+
+#include <algorithm>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        // Row maps and bucket arrays for a few thousand rows stay below this, so their blocks
+        // are pooled (and recycled) rather than passed straight through to the arena.
+        constexpr std::size_t kLargestPooledBlock = 256 * 1024;
+
+        [[nodiscard]] std::pmr::pool_options PoolOptions()
+        {
+            std::pmr::pool_options options;
+            options.largest_required_pool_block = kLargestPooledBlock;
+            return options;
+        }
+    }
+
+    void* SessionArena::CountingUpstream::do_allocate(std::size_t a_bytes, std::size_t a_alignment)
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(a_bytes, a_alignment);
+    }
+
+    void SessionArena::CountingUpstream::do_deallocate(void* a_ptr, std::size_t a_bytes, std::size_t a_alignment)
+    {
+        std::pmr::new_delete_resource()->deallocate(a_ptr, a_bytes, a_alignment);
+    }
+
+    SessionArena::SessionArena() :
+        _buffer(_inline.data(), _inline.size(), &_upstream),
+        _pool(PoolOptions(), this)
+    {}
+
+    void SessionArena::Begin()
+    {
+        if (_active) {
+            End();
+        }
+
+        _session = {};
+        _upstream.allocations = 0;
+        _owner = std::this_thread::get_id();
+        _active = true;
+    }
+
+    SessionArena::Usage SessionArena::End()
+    {
+        const auto usage = _session;
+        // The pool's chunks live in the buffer; drop its bookkeeping first.
+        _pool.release();
+        _buffer.release();
+        _session = {};
+        _upstream.allocations = 0;
+        _owner = {};
+        _active = false;
+        _totalAvoided += usage.HeapAllocationsAvoided();
+        return usage;
+    }
+
+    std::pmr::memory_resource* SessionArena::Resource() noexcept
+    {
+        if (_active && _owner == std::this_thread::get_id()) {
+            return this;
+        }
+        return std::pmr::get_default_resource();
+    }
+
+    std::pmr::memory_resource* SessionArena::PoolResource() noexcept
+    {
+        if (_active && _owner == std::this_thread::get_id()) {
+            return &_pool;
+        }
+        return std::pmr::get_default_resource();
+    }
+
+    void* SessionArena::do_allocate(std::size_t a_bytes, std::size_t a_alignment)
+    {
+        auto* ptr = _buffer.allocate(a_bytes, a_alignment);
+        _session.bytes += a_bytes;
+        ++_session.allocations;
+        _session.upstreamAllocations = _upstream.allocations;
+        _peakBytes = std::max(_peakBytes, _session.bytes);
+        return ptr;
+    }
+}
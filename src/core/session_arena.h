@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+
+namespace RFAB::Disenchant
+{
+    // Monotonic arena for data that only lives while one CraftingMenu is open: row scratch,
+    // stripped-instance lists, unique-ID batches. Allocations are pointer bumps and are never
+    // freed one by one; End() drops the whole session at once, keeping the inline first block.
+    //
+    // Monotonic memory is never reused, so containers that free or regrow during the session
+    // (hash maps that rehash or erase, vectors cleared and refilled) take PoolResource() instead:
+    // a pool carved from the arena that recycles freed blocks.
+    //
+    // Not thread-safe. The arena serves only the thread that called Begin(); Resource() and
+    // PoolResource() hand every other thread, and every caller outside a session, the default
+    // heap resource.
+    class SessionArena final : private std::pmr::memory_resource
+    {
+    public:
+        static constexpr std::size_t kInlineBytes = 16 * 1024;
+
+        struct Usage
+        {
+            std::size_t bytes{ 0 };
+            std::size_t allocations{ 0 };
+            // Blocks the arena itself took from the heap; the rest of the allocations avoided it.
+            std::size_t upstreamAllocations{ 0 };
+
+            [[nodiscard]] std::size_t HeapAllocationsAvoided() const noexcept
+            {
+                return allocations > upstreamAllocations ? allocations - upstreamAllocations : 0;
+            }
+        };
+
+        SessionArena();
+        SessionArena(const SessionArena&) = delete;
+        SessionArena& operator=(const SessionArena&) = delete;
+
+        void Begin();
+        // Releases everything allocated since Begin() and returns what the session used. Anything
+        // still holding arena memory must be gone by now.
+        Usage End();
+
+        [[nodiscard]] bool Active() const noexcept { return _active; }
+        [[nodiscard]] std::pmr::memory_resource* Resource() noexcept;
+        [[nodiscard]] std::pmr::memory_resource* PoolResource() noexcept;
+
+        [[nodiscard]] const Usage& Current() const noexcept { return _session; }
+        [[nodiscard]] std::size_t PeakBytes() const noexcept { return _peakBytes; }
+        [[nodiscard]] std::uint64_t TotalHeapAllocationsAvoided() const noexcept { return _totalAvoided; }
+
+    private:
+        class CountingUpstream final : public std::pmr::memory_resource
+        {
+        public:
+            std::size_t allocations{ 0 };
+
+        private:
+            void* do_allocate(std::size_t a_bytes, std::size_t a_alignment) override;
+            void do_deallocate(void* a_ptr, std::size_t a_bytes, std::size_t a_alignment) override;
+            [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& a_other) const noexcept override { return this == &a_other; }
+        };
+
+        void* do_allocate(std::size_t a_bytes, std::size_t a_alignment) override;
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& a_other) const noexcept override { return this == &a_other; }
+
+        alignas(std::max_align_t) std::array<std::byte, kInlineBytes> _inline;
+        CountingUpstream _upstream;
+        std::pmr::monotonic_buffer_resource _buffer;
+        std::pmr::unsynchronized_pool_resource _pool;
+        std::thread::id _owner;
+        Usage _session;
+        std::size_t _peakBytes{ 0 };
+        std::uint64_t _totalAvoided{ 0 };
+        bool _active{ false };
+    };
+}
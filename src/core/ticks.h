@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    else
+#        include <x86intrin.h>
+#    endif
+#    define RFAB_HAS_RDTSC 1
+#else
+#    define RFAB_HAS_RDTSC 0
+#endif
+
+namespace RFAB::Disenchant
+{
+    [[nodiscard]] inline std::uint64_t ReadSteadyNs() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Raw timestamp counter: rdtsc where available (invariant TSC on every CPU the game runs
+    // on), steady_clock nanoseconds otherwise. Convert with TickCalibration.
+    [[nodiscard]] inline std::uint64_t ReadTicks() noexcept
+    {
+#if RFAB_HAS_RDTSC
+        return __rdtsc();
+#else
+        return ReadSteadyNs();
+#endif
+    }
+
+    // Derives the tick rate from the ticks and steady_clock (QPC on Windows) time elapsed since
+    // Start(), so no calibration loop ever blocks the game thread. Accuracy improves the longer
+    // the process has been running.
+    class TickCalibration
+    {
+    public:
+        void Start() noexcept
+        {
+            _startTicks = ReadTicks();
+            _startNs = ReadSteadyNs();
+        }
+
+        [[nodiscard]] double NsPerTick() const noexcept
+        {
+            const auto ticks = ReadTicks() - _startTicks;
+            const auto ns = ReadSteadyNs() - _startNs;
+            if (ticks == 0 || ns == 0) {
+                return 1.0;
+            }
+            return static_cast<double>(ns) / static_cast<double>(ticks);
+        }
+
+    private:
+        std::uint64_t _startTicks{ 0 };
+        std::uint64_t _startNs{ 0 };
+    };
+}
@@ -1,6 +1,26 @@
 #include "hook.h"
 
 #include "log.h"
+#include "settings.h"
+
+#include "RFAB_Disenchant/MarkAPI.h"
+#include "RFAB_Disenchant/Stats.h"
+
+#include "core/chrome_trace.h"
+#include "core/codec.h"
+#include "core/confirm_flow.h"
+#include "core/deadline.h"
+#include "core/gating.h"
+#include "core/hook_trace.h"
+#include "core/latency_histogram.h"
+#include "core/mark_location.h"
+#include "core/mark_validation.h"
+#include "core/menu_query.h"
+#include "core/message_gate.h"
+#include "core/refresh_scheduler.h"
+#include "core/row_prewarm.h"
+#include "core/session_arena.h"
+#include "core/ticks.h"
 
 #include "RE/E/EnchantConstructMenu.h"
 #include "RE/C/CraftingMenu.h"
@@ -15,18 +35,29 @@
 #include "RE/I/InputEvent.h"
 #include "RE/M/Misc.h"
 #include "RE/M/MessageBoxData.h"
+#include "RE/M/MenuOpenCloseEvent.h"
 #include "RE/M/MessageBoxMenu.h"
 #include "RE/RTTI.h"
+#include "RE/S/ScriptEventSourceHolder.h"
+#include "RE/T/TESContainerChangedEvent.h"
+#include "RE/T/TESFurniture.h"
 #include "RE/U/UI.h"
 #include "RE/U/UIMessageQueue.h"
 #include "RE/U/UserEvents.h"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstring>
+#include <functional>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <random>
+#include <span>
+#include <string>
 #include <string_view>
-#include <unordered_set>
+#include <thread>
 #include <vector>
 #include <Windows.h>
 
@@ -34,32 +65,25 @@ namespace RFAB::Disenchant
 {
     namespace
     {
-        constexpr std::uint32_t kSerializationRecordType = 'MARK';
-        constexpr std::uint32_t kSerializationVersion = 2;
-
-        enum class MarkSignature : std::uint64_t
-        {
-        };
-
-        struct MarkSignatureHash
-        {
-            [[nodiscard]] std::size_t operator()(MarkSignature a_sig) const noexcept
-            {
-                return std::hash<std::uint64_t>{}(static_cast<std::uint64_t>(a_sig));
-            }
-        };
-
-        std::mutex g_markedItemsLock;
-        std::unordered_set<std::uint64_t> g_markedItems;
-        std::unordered_set<MarkSignature, MarkSignatureHash> g_markedSignatures;
-        std::atomic<std::uint32_t> g_forceHideMessageBoxUntilMs{ 0 };
-        std::atomic<std::uint32_t> g_allowNoDataMessageBoxUntilMs{ 0 };
-        std::atomic_bool g_messageBoxShowingOurConfirm{ false };
-        std::atomic<std::uint32_t> g_suppressEnchantInputUntilMs{ 0 };
-        std::atomic<std::uint32_t> g_suppressConfirmUntilMs{ 0 };
-        std::atomic<std::uint32_t> g_nextConfirmAllowedMs{ 0 };
+        MarkStore g_markStore;
+        // Where each marked instance was last seen; serialized next to the marks.
+        MarkLocationIndex g_markLocations;
+        constexpr RE::FormID kPlayerFormID = 0x14;
+        // Set while restacking moves stripped instances around; the container events those moves
+        // send are ours and say nothing about where a marked instance went.
+        bool g_restackingStripped{ false };
+        // Bumped by every load and revert; a load validation still running for an older one is dropped.
+        std::atomic<std::uint64_t> g_markValidationTicket{ 0 };
+        std::uint64_t g_markJournalID{ 0 };
+        std::uint64_t g_markJournalBaseToken{ 0 };
+        // Open/queued state and suppression windows of our remove confirmation.
+        ConfirmFlow g_confirmFlow;
+        Deadline g_suppressConfirm;
+        // At most one queued kForceHide for MessageBoxMenu; reopened when the menu processes it.
+        PendingMessageGate g_messageBoxForceHide;
         constexpr std::uint32_t kRemoveHotkeyDIK = 0x13;
-        constexpr std::uint32_t kConfirmDebounceMs = 600;
+        // Holding Shift with the remove hotkey strips every marked item behind one confirmation.
+        constexpr std::uint32_t kBulkRemoveModifierDIKs[] = { 0x2A, 0x36 };  // left, right Shift
         constexpr auto* kRemoveSuccessSound = "UIEnchantingItemDestroy";
         constexpr auto* kRemoveSuccessNotification =
             "\xD0\x97\xD0\xB0\xD1\x87\xD0\xB0\xD1\x80\xD0\xBE\xD0\xB2\xD0\xB0\xD0\xBD\xD0\xB8\xD0\xB5 "
@@ -67,6 +91,8 @@ namespace RFAB::Disenchant
             "\xD1\x81\xD0\xBD\xD1\x8F\xD1\x82\xD0\xBE";
         constexpr auto* kRemoveConfirmText =
             "\xD0\x92\xD1\x8B \xD1\x82\xD0\xBE\xD1\x87\xD0\xBD\xD0\xBE \xD1\x85\xD0\xBE\xD1\x82\xD0\xB8\xD1\x82\xD0\xB5 \xD0\xBE\xD1\x87\xD0\xB8\xD1\x81\xD1\x82\xD0\xB8\xD1\x82\xD1\x8C \xD0\xB7\xD0\xB0\xD1\x87\xD0\xB0\xD1\x80\xD0\xBE\xD0\xB2\xD0\xB0\xD0\xBD\xD0\xB8\xD0\xB5?";
+        constexpr auto* kRemoveAllConfirmText =
+            "\xD0\xA1\xD0\xBD\xD1\x8F\xD1\x82\xD1\x8C \xD0\xB7\xD0\xB0\xD1\x87\xD0\xB0\xD1\x80\xD0\xBE\xD0\xB2\xD0\xB0\xD0\xBD\xD0\xB8\xD0\xB5 \xD1\x81\xD0\xBE \xD0\xB2\xD1\x81\xD0\xB5\xD1\x85 \xD0\xBE\xD1\x82\xD0\xBC\xD0\xB5\xD1\x87\xD0\xB5\xD0\xBD\xD0\xBD\xD1\x8B\xD1\x85 \xD0\xBF\xD1\x80\xD0\xB5\xD0\xB4\xD0\xBC\xD0\xB5\xD1\x82\xD0\xBE\xD0\xB2?";
         constexpr auto* kRemoveConfirmYes = "\xD0\x94\xD0\xB0";
         constexpr auto* kRemoveConfirmNo = "\xD0\x9D\xD0\xB5\xD1\x82";
 
@@ -74,80 +100,958 @@ namespace RFAB::Disenchant
         {
             std::optional<std::uint64_t> key;
             std::optional<MarkSignature> signature;
+            bool bulk{ false };
+        };
+
+        std::mutex g_removeConfirmLock;
+        RemoveConfirmationRequest g_removeConfirmRequest;
+
+        using ProcessUserEvent_t = bool(RE::CraftingSubMenus::EnchantConstructMenu*, RE::BSFixedString*);
+        REL::Relocation<ProcessUserEvent_t> g_processUserEventOriginal;
+
+        [[nodiscard]] std::optional<MarkSignature> GetEntryMarkSignature(RE::InventoryEntryData* a_entry);
+        [[nodiscard]] bool IsEntryMarked(
+            RE::InventoryEntryData* a_entry,
+            std::optional<std::uint64_t>* a_markedKey = nullptr,
+            std::optional<MarkSignature>* a_markedSignature = nullptr);
+        [[nodiscard]] RE::InventoryEntryData* ResolveDisenchantSelection(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+        [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry* GetHighlightedItemEntry(
+            RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+        [[nodiscard]] bool ShouldSuppressVanillaDisenchantPrompt(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+        [[nodiscard]] bool EntryHasAnyEnchantment(RE::InventoryEntryData* a_entry);
+        [[nodiscard]] RE::EnchantmentItem* GetEntryExtraEnchantment(RE::InventoryEntryData* a_entry);
+        [[nodiscard]] bool EntryHasExtraEnchantment(RE::InventoryEntryData* a_entry);
+        void ForceEnableMarkedDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+        void DisableStaleDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+        void RequestMenuRefresh(RefreshLevel a_level);
+        void DropPendingRestacks();
+        void QueueMessageBoxForceHide();
+        void AbortRemoveConfirmation();
+        [[nodiscard]] bool ShouldSuppressMessageBoxNow();
+        [[nodiscard]] bool ShouldAllowNoDataMessageBoxNow();
+        [[nodiscard]] bool ShouldSuppressEnchantInputNow();
+        [[nodiscard]] bool ShouldSuppressConfirmNow();
+        void ShowRemoveConfirmation(
+            RE::CraftingSubMenus::EnchantConstructMenu* a_menu,
+            const std::optional<std::uint64_t>& a_key,
+            const std::optional<MarkSignature>& a_signature,
+            bool a_bulk = false);
+        [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu* GetActiveEnchantConstructMenu();
+        [[nodiscard]] bool MenuHasMarkedRow(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
+
+        // One bit per entry of kBulkRemoveModifierDIKs, as last reported by the game's keyboard
+        // events. Only the input sink touches it.
+        std::uint8_t g_bulkRemoveModifiersHeld = 0;
+
+        void TrackBulkRemoveModifier(const RE::ButtonEvent& a_button)
+        {
+            if (a_button.GetDevice() != RE::INPUT_DEVICE::kKeyboard) {
+                return;
+            }
+
+            for (std::size_t i = 0; i < std::size(kBulkRemoveModifierDIKs); ++i) {
+                if (a_button.GetIDCode() != kBulkRemoveModifierDIKs[i]) {
+                    continue;
+                }
+
+                const auto bit = static_cast<std::uint8_t>(1u << i);
+                if (a_button.IsPressed()) {
+                    g_bulkRemoveModifiersHeld |= bit;
+                } else {
+                    g_bulkRemoveModifiersHeld &= static_cast<std::uint8_t>(~bit);
+                }
+            }
+        }
+
+        [[nodiscard]] bool IsBulkRemoveModifierHeld()
+        {
+            return g_bulkRemoveModifiersHeld != 0;
+        }
+
+        [[nodiscard]] bool EntryHasAnyEnchantment(RE::InventoryEntryData* a_entry)
+        {
+            if (!a_entry) {
+                return false;
+            }
+
+            return a_entry->GetEnchantment() != nullptr || GetEntryExtraEnchantment(a_entry) != nullptr;
+        }
+
+        [[nodiscard]] RE::EnchantmentItem* GetEntryExtraEnchantment(RE::InventoryEntryData* a_entry)
+        {
+            if (!a_entry || !a_entry->extraLists) {
+                return nullptr;
+            }
+
+            for (auto* extraList : *a_entry->extraLists) {
+                if (!extraList) {
+                    continue;
+                }
+
+                if (const auto* extra = extraList->GetByType<RE::ExtraEnchantment>(); extra && extra->enchantment) {
+                    return extra->enchantment;
+                }
+            }
+
+            return nullptr;
+        }
+
+        [[nodiscard]] bool EntryHasExtraEnchantment(RE::InventoryEntryData* a_entry)
+        {
+            return GetEntryExtraEnchantment(a_entry) != nullptr;
+        }
+
+        [[nodiscard]] std::uint64_t MakeMarkKey(const RE::ExtraUniqueID& a_uniqueID)
+        {
+            return RFAB::Disenchant::MakeMarkKey(a_uniqueID.baseID, a_uniqueID.uniqueID);
+        }
+
+        struct GameEntryTraits
+        {
+            using Entry = RE::InventoryEntryData;
+            using Menu = RE::CraftingSubMenus::EnchantConstructMenu;
+            using Row = RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry;
+
+            [[nodiscard]] static bool HasExtraEnchantment(Entry* a_entry) { return EntryHasExtraEnchantment(a_entry); }
+            [[nodiscard]] static bool HasAnyEnchantment(Entry* a_entry) { return EntryHasAnyEnchantment(a_entry); }
+            [[nodiscard]] static std::optional<MarkSignature> GetSignature(Entry* a_entry) { return GetEntryMarkSignature(a_entry); }
+
+            template <class F>
+            static void ForEachUniqueKey(Entry* a_entry, F&& a_visitor)
+            {
+                if (!a_entry || !a_entry->extraLists) {
+                    return;
+                }
+
+                for (auto* extraList : *a_entry->extraLists) {
+                    if (!extraList) {
+                        continue;
+                    }
+
+                    if (const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>()) {
+                        if (a_visitor(MakeMarkKey(*uniqueID))) {
+                            return;
+                        }
+                    }
+                }
+            }
+
+            [[nodiscard]] static std::size_t RowCount(Menu* a_menu) { return a_menu->listEntries.size(); }
+            [[nodiscard]] static Row* RowAt(Menu* a_menu, std::size_t a_index) { return skyrim_cast<Row*>(a_menu->listEntries[a_index].get()); }
+            [[nodiscard]] static std::size_t HighlightIndex(Menu* a_menu) { return a_menu->highlightIndex; }
+            [[nodiscard]] static Entry* SelectedData(Menu* a_menu) { return a_menu->selected.item ? a_menu->selected.item->data : nullptr; }
+            [[nodiscard]] static Entry* RowData(Row* a_row) { return a_row->data; }
+            [[nodiscard]] static bool IsRowSelected(Row* a_row) { return a_row->selected; }
+            static void SetRowEnabled(Row* a_row, bool a_enabled) { a_row->enabled = a_enabled; }
+        };
+
+        [[nodiscard]] RE::InventoryEntryData* GetInventoryEntry(const RE::TESObjectREFR::InventoryItemMap::value_type& a_item)
+        {
+            return a_item.second.second.get();
+        }
+
+        [[nodiscard]] std::uint32_t GetRunTimeMs()
+        {
+            return RE::GetDurationOfApplicationRunTime();
+        }
+
+        TraceWriter g_trace;
+        std::array<LatencyHistogram, kHookCount> g_hookHistograms;
+        TickCalibration g_hookTicks;
+        std::uint32_t g_hookStatsIntervalMs{ 0 };
+        std::atomic<std::uint32_t> g_nextHookStatsDumpMs{ 0 };
+        std::atomic_bool g_hookStatsDumpQueued{ false };
+
+        // Which hook instrumentation is live; HookScope checks all of it with a single load.
+        enum HookInstrumentation : std::uint8_t
+        {
+            kInstrumentTrace = 1 << 0,
+            kInstrumentStats = 1 << 1,
+            kInstrumentChrome = 1 << 2,
+            kInstrumentCounters = 1 << 3
+        };
+        std::atomic<std::uint8_t> g_hookInstrumentation{ 0 };
+
+        static_assert(RFAB_DISENCHANT_STATS_HOOK_COUNT == kHookCount);
+
+        // Published to other plugins by pointer; see RFAB_Disenchant/Stats.h for the read contract.
+        alignas(64) RFABDisenchantStats g_stats{
+            RFAB_DISENCHANT_STATS_VERSION,
+            sizeof(RFABDisenchantStats),
+            RFAB_DISENCHANT_STATS_HOOK_COUNT
+        };
+
+        void BumpStat(std::uint64_t& a_counter, std::uint64_t a_delta = 1) noexcept
+        {
+            std::atomic_ref<std::uint64_t>(a_counter).fetch_add(a_delta, std::memory_order_relaxed);
+        }
+
+        void StoreStat(std::uint64_t& a_counter, std::uint64_t a_value) noexcept
+        {
+            std::atomic_ref<std::uint64_t>(a_counter).store(a_value, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool IsCollectingCounters() noexcept
+        {
+            return (g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentCounters) != 0;
+        }
+
+        void PublishMarkCounts()
+        {
+            StoreStat(g_stats.markedKeys, g_markStore.KeyCount());
+            StoreStat(g_stats.markedSignatures, g_markStore.SignatureCount());
+        }
+
+        // Every inventory walk goes through here so it shows up in the published scan count.
+        [[nodiscard]] RE::TESObjectREFR::InventoryItemMap GetReferenceInventory(
+            RE::TESObjectREFR* a_ref,
+            std::function<bool(RE::TESBoundObject&)> a_filter = nullptr)
+        {
+            BumpStat(g_stats.inventoryScans);
+            return a_filter ? a_ref->GetInventory(std::move(a_filter)) : a_ref->GetInventory();
+        }
+
+        [[nodiscard]] RE::TESObjectREFR::InventoryItemMap GetPlayerInventory(RE::PlayerCharacter* a_player)
+        {
+            return GetReferenceInventory(a_player);
+        }
+
+        ChromeTraceRecorder g_chromeTrace;
+        constexpr auto* kChromeHookCategory = "hook";
+        constexpr auto* kChromeUICategory = "ui";
+        constexpr auto* kChromeMenuCategory = "menu";
+        constexpr auto* kChromeScanCategory = "scan";
+        constexpr auto* kChromeCoSaveCategory = "cosave";
+
+        [[nodiscard]] bool IsChromeTracing()
+        {
+            return (g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentChrome) != 0;
+        }
+
+        // Emits one complete event covering the enclosing scope when Chrome tracing is on.
+        class ChromeSpan
+        {
+        public:
+            ChromeSpan(const char* a_name, const char* a_category, std::uint64_t a_id = 0) :
+                _name(a_name),
+                _category(a_category),
+                _id(a_id),
+                _startNs(IsChromeTracing() ? ReadSteadyNs() : 0)
+            {}
+
+            ChromeSpan(const ChromeSpan&) = delete;
+            ChromeSpan& operator=(const ChromeSpan&) = delete;
+
+            ~ChromeSpan()
+            {
+                if (_startNs != 0) {
+                    g_chromeTrace.Complete(_name, _category, _startNs, ReadSteadyNs(), _id);
+                }
+            }
+
+        private:
+            const char* _name;
+            const char* _category;
+            std::uint64_t _id;
+            std::uint64_t _startNs;
+        };
+
+        // AddUITask with the enqueue and the run linked by a flow arrow in the trace.
+        void AddTracedUITask(SKSE::TaskInterface* a_task, const char* a_name, std::function<void()> a_fn)
+        {
+            BumpStat(g_stats.uiTasksQueued);
+            const auto id = IsChromeTracing() ? g_chromeTrace.NextId() : 0;
+            if (id != 0) {
+                g_chromeTrace.Instant(a_name, kChromeUICategory, id);
+                g_chromeTrace.FlowStart(a_name, kChromeUICategory, id);
+            }
+
+            a_task->AddUITask([a_name, id, fn = std::move(a_fn)]() {
+                if (id != 0) {
+                    g_chromeTrace.FlowEnd(a_name, kChromeUICategory, id);
+                }
+                ChromeSpan span(a_name, kChromeUICategory, id);
+                fn();
+            });
+        }
+
+        RefreshScheduler g_menuRefresh;
+
+        // Transient data for the open CraftingMenu; released in one go when it closes.
+        SessionArena g_sessionArena;
+        // Row key batch reused across refreshes; allocated from the session pool and dropped
+        // before the arena is released.
+        std::optional<MarkedRowScratch> g_markedRowScratch;
+
+        void UpdateMenuList(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        {
+            ChromeSpan span("UpdateConstructibleList", kChromeMenuCategory);
+            BumpStat(g_stats.uiRefreshes);
+            a_menu->UpdateConstructibleList();
+        }
+
+        void UpdateMenuInterface(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        {
+            ChromeSpan span("UpdateInterface", kChromeMenuCategory);
+            BumpStat(g_stats.uiRefreshes);
+            a_menu->UpdateInterface();
+        }
+
+        void DumpHookStats(std::string_view a_reason)
+        {
+            const auto nsPerTick = g_hookTicks.NsPerTick();
+            const auto toUs = [&](std::uint64_t a_ticks) { return static_cast<double>(a_ticks) * nsPerTick / 1000.0; };
+
+            SKSE::log::info("Hook latency since last dump ({}):", a_reason);
+            for (std::size_t i = 0; i < kHookCount; ++i) {
+                const auto summary = g_hookHistograms[i].Collect(true);
+                if (summary.count == 0) {
+                    continue;
+                }
+
+                SKSE::log::info(
+                    "  {:<36} calls={} p50={:.2f}us p99={:.2f}us max={:.2f}us total={:.1f}us",
+                    kHookNames[i],
+                    summary.count,
+                    toUs(summary.p50),
+                    toUs(summary.p99),
+                    toUs(summary.max),
+                    toUs(summary.total));
+            }
+
+            SKSE::log::info(
+                "  Menu refreshes: {} requested, {} flushed, {} coalesced",
+                g_menuRefresh.Requests(),
+                g_menuRefresh.Flushes(),
+                g_menuRefresh.Coalesced());
+            SKSE::log::info(
+                "  MessageBoxMenu force-hides: {} sent, {} saved",
+                std::atomic_ref<std::uint64_t>(g_stats.forceHidesSent).load(std::memory_order_relaxed),
+                std::atomic_ref<std::uint64_t>(g_stats.forceHidesSaved).load(std::memory_order_relaxed));
+            SKSE::log::info(
+                "  Session arena: peak {} bytes, {} heap allocations avoided",
+                g_sessionArena.PeakBytes(),
+                g_sessionArena.TotalHeapAllocationsAvoided());
+        }
+
+        void QueueHookStatsDump(std::uint32_t a_nowMs)
+        {
+            g_nextHookStatsDumpMs.store(a_nowMs + g_hookStatsIntervalMs, std::memory_order_relaxed);
+            if (g_hookStatsDumpQueued.exchange(true, std::memory_order_acq_rel)) {
+                return;
+            }
+
+            auto* task = SKSE::GetTaskInterface();
+            if (!task) {
+                g_hookStatsDumpQueued.store(false, std::memory_order_release);
+                return;
+            }
+
+            task->AddTask([]() {
+                g_hookStatsDumpQueued.store(false, std::memory_order_release);
+                DumpHookStats("interval");
+            });
+        }
+
+        // Wraps one hook invocation. Feeds the per-hook latency histogram and, when recording,
+        // writes a trace record with the gating input the hook saw and the decision it took.
+        // With all instrumentation off this costs one relaxed load and one branch.
+        class HookScope
+        {
+        public:
+            explicit HookScope(HookId a_hook) :
+                _flags(g_hookInstrumentation.load(std::memory_order_relaxed))
+            {
+                if (!_flags) {
+                    return;
+                }
+
+                _event.hook = a_hook;
+                if (_flags & (kInstrumentTrace | kInstrumentChrome)) {
+                    _event.timestampNs = ReadSteadyNs();
+                }
+                if (_flags & (kInstrumentStats | kInstrumentCounters)) {
+                    _startTicks = ReadTicks();
+                }
+            }
+
+            HookScope(const HookScope&) = delete;
+            HookScope& operator=(const HookScope&) = delete;
+
+            ~HookScope()
+            {
+                if (!_flags) {
+                    return;
+                }
+
+                if (_flags & (kInstrumentStats | kInstrumentCounters)) {
+                    const auto ticks = ReadTicks() - _startTicks;
+                    if (_flags & kInstrumentCounters) {
+                        auto& counters = g_stats.hooks[static_cast<std::size_t>(_event.hook)];
+                        BumpStat(counters.calls);
+                        BumpStat(counters.totalTicks, ticks);
+                    }
+
+                    if (_flags & kInstrumentStats) {
+                        g_hookHistograms[static_cast<std::size_t>(_event.hook)].Record(ticks);
+                        if (g_hookStatsIntervalMs != 0) {
+                            const auto nowMs = GetRunTimeMs();
+                            if (nowMs >= g_nextHookStatsDumpMs.load(std::memory_order_relaxed)) {
+                                QueueHookStatsDump(nowMs);
+                            }
+                        }
+                    }
+                }
+
+                if (_flags & (kInstrumentTrace | kInstrumentChrome)) {
+                    const auto endNs = ReadSteadyNs();
+                    if (_flags & kInstrumentChrome) {
+                        g_chromeTrace.Complete(GetHookName(_event.hook).data(), kChromeHookCategory, _event.timestampNs, endNs);
+                    }
+                    if (_flags & kInstrumentTrace) {
+                        const auto elapsed = endNs - _event.timestampNs;
+                        _event.durationNs = static_cast<std::uint32_t>(std::min<std::uint64_t>(elapsed, 0xFFFFFFFFu));
+                        g_trace.WriteHook(_event);
+                    }
+                }
+            }
+
+            void SetControl(const char* a_name)
+            {
+                if ((_flags & kInstrumentTrace) && a_name) {
+                    _event.controlID = g_trace.InternControl(a_name);
+                }
+            }
+
+            template <class T>
+            void SetInput(const T& a_input)
+            {
+                if (_flags & kInstrumentTrace) {
+                    _event.input = PackTraceInput(a_input);
+                }
+            }
+
+            void SetDisplayInput(bool a_suppress, bool a_allow)
+            {
+                if (_flags & kInstrumentTrace) {
+                    _event.input = PackTraceDisplayInput(a_suppress, a_allow);
+                }
+            }
+
+            void SetDecision(std::uint32_t a_decision) noexcept
+            {
+                _event.decision = a_decision;
+            }
+
+        private:
+            HookTraceEvent _event;
+            std::uint64_t _startTicks{ 0 };
+            std::uint8_t _flags;
+        };
+
+        void TraceMarkDelta(JournalOp a_op, std::uint64_t a_value)
+        {
+            if (g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentTrace) {
+                g_trace.WriteMarkDelta({ a_op, ReadSteadyNs(), a_value });
+            }
+        }
+
+        void StartHookTrace()
+        {
+            if (!Settings::GetSingleton().recordTrace) {
+                return;
+            }
+
+            const auto logsFolder = SKSE::log::log_directory();
+            if (!logsFolder) {
+                SKSE::log::error("Hook trace requested but SKSE log directory is unavailable");
+                return;
+            }
+
+            const auto path = *logsFolder / "RFAB_Disenchant.rftrace";
+            if (!g_trace.Open(path)) {
+                SKSE::log::error("Failed to open hook trace {}", path.string());
+                return;
+            }
+
+            g_hookInstrumentation.fetch_or(kInstrumentTrace, std::memory_order_release);
+            SKSE::log::info("Recording hook trace to {}", path.string());
+        }
+
+        void StartHookStats()
+        {
+            const auto& settings = Settings::GetSingleton();
+            if (!settings.hookStats) {
+                return;
+            }
+
+            g_hookStatsIntervalMs = settings.hookStatsIntervalSec * 1000;
+            g_nextHookStatsDumpMs.store(GetRunTimeMs() + g_hookStatsIntervalMs, std::memory_order_relaxed);
+            g_hookInstrumentation.fetch_or(kInstrumentStats, std::memory_order_release);
+            SKSE::log::info("Collecting hook latency stats (interval {}s)", settings.hookStatsIntervalSec);
+        }
+
+        void StartChromeTrace()
+        {
+            if (!Settings::GetSingleton().chromeTrace) {
+                return;
+            }
+
+            const auto logsFolder = SKSE::log::log_directory();
+            if (!logsFolder) {
+                SKSE::log::error("Chrome trace requested but SKSE log directory is unavailable");
+                return;
+            }
+
+            const auto path = *logsFolder / "RFAB_Disenchant.trace.json";
+            if (!g_chromeTrace.Start(path, "SkyrimSE.exe (RFAB_Disenchant)")) {
+                SKSE::log::error("Failed to open Chrome trace {}", path.string());
+                return;
+            }
+
+            g_hookInstrumentation.fetch_or(kInstrumentChrome, std::memory_order_release);
+            SKSE::log::info("Writing Chrome trace to {}", path.string());
+        }
+
+        void LogSuppressionWindows(std::string_view a_reason)
+        {
+            SKSE::log::info(
+                "Suppression windows ({}): force-hide {}ms, input {}ms, no-data {}ms, debounce {}ms "
+                "from {} prompt and {} dialog latency samples",
+                a_reason,
+                g_confirmFlow.ForceHideWindow().Current(),
+                g_confirmFlow.SuppressInputWindow().Current(),
+                g_confirmFlow.AllowNoDataWindow().Current(),
+                g_confirmFlow.ConfirmDebounceWindow().Current(),
+                g_confirmFlow.ForceHideWindow().SampleCount(),
+                g_confirmFlow.AllowNoDataWindow().SampleCount());
+        }
+
+        void ConfigureSuppressionWindows()
+        {
+            g_confirmFlow.Configure(Settings::GetSingleton().confirmWindows);
+            LogSuppressionWindows("configured");
+        }
+
+        [[nodiscard]] double ElapsedMs(std::uint64_t a_startNs)
+        {
+            return static_cast<double>(ReadSteadyNs() - a_startNs) / 1'000'000.0;
+        }
+
+        // Mark and enchantment state of the player's enchantable entries, worked out a slice per
+        // frame while the enchanting menu opens so the first Disenchant list pass only looks it up.
+        std::optional<RowPrewarmCache> g_rowPrewarm;
+        // Set by container changes touching the player, which may free entries the cache is keyed by.
+        std::atomic_bool g_rowPrewarmInvalidated{ false };
+        std::uint64_t g_craftingSessionID{ 0 };
+        constexpr std::uint64_t kRowPrewarmFrameBudgetNs = 1'000'000;
+
+        struct RowPrewarmProgress
+        {
+            // Position in the player's entry list the next step resumes from.
+            std::size_t next{ 0 };
+            std::size_t rows{ 0 };
+            std::size_t frames{ 0 };
+            std::uint64_t busyNs{ 0 };
+            bool done{ false };
+        };
+        RowPrewarmProgress g_rowPrewarmProgress;
+
+        // From the enchanting menu opening to the UI frame after the first Disenchant row pass.
+        struct FirstFrameProfile
+        {
+            bool tracking{ false };
+            bool pending{ false };
+            std::uint64_t openNs{ 0 };
+            std::uint64_t rowPassNs{ 0 };
+            std::size_t rows{ 0 };
         };
+        FirstFrameProfile g_firstFrame;
+
+        [[nodiscard]] bool IsAtEnchantingWorkbench()
+        {
+            auto* player = RE::PlayerCharacter::GetSingleton();
+            if (!player) {
+                return false;
+            }
+
+            const auto furnitureRef = player->GetOccupiedFurniture().get();
+            auto* base = furnitureRef ? furnitureRef->GetBaseObject() : nullptr;
+            auto* furniture = base ? base->As<RE::TESFurniture>() : nullptr;
+            return furniture && furniture->workBenchData.benchType.get() == RE::TESFurniture::WorkBenchData::BenchType::kEnchanting;
+        }
+
+        void RetireRowPrewarm()
+        {
+            if (g_rowPrewarm) {
+                g_rowPrewarm->Retire();
+            }
+        }
+
+        [[nodiscard]] bool IsRowPrewarmUsable()
+        {
+            if (!g_rowPrewarm || !g_rowPrewarm->Active()) {
+                return false;
+            }
+            if (g_rowPrewarmInvalidated.exchange(false)) {
+                RFAB_LOG_DEBUG("Player inventory changed; dropping pre-warmed disenchant rows");
+                RetireRowPrewarm();
+                return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] std::optional<PrewarmedRow> FindPrewarmedRow(RE::InventoryEntryData* a_entry)
+        {
+            return IsRowPrewarmUsable() ? g_rowPrewarm->Find(a_entry, g_markStore.Generation()) : std::nullopt;
+        }
+
+        void RowPrewarmStep(std::uint64_t a_session);
+
+        void QueueRowPrewarmStep(std::uint64_t a_session)
+        {
+            if (auto* task = SKSE::GetTaskInterface()) {
+                task->AddTask([a_session]() { RowPrewarmStep(a_session); });
+            }
+        }
+
+        // Walks the live entry list rather than a copy, so the keys are the entries the menu's
+        // rows point at. No node is held across frames: each step starts again from the head and
+        // skips the entries already done, so a list changed in between is never walked through a
+        // freed node. Local paths that change the list without a container event (crafting,
+        // stripping, restacking) retire the pre-warm themselves.
+        void RowPrewarmStep(std::uint64_t a_session)
+        {
+            if (a_session != g_craftingSessionID || !IsRowPrewarmUsable()) {
+                return;
+            }
+
+            ChromeSpan span("RowPrewarmStep", kChromeMenuCategory);
+            auto* player = RE::PlayerCharacter::GetSingleton();
+            auto* changes = player ? player->GetInventoryChanges() : nullptr;
+            if (!changes || !changes->entryList) {
+                RetireRowPrewarm();
+                return;
+            }
+
+            auto& progress = g_rowPrewarmProgress;
+            // A mark changed since the last step; what came before belongs to the old generation.
+            if (const auto generation = g_markStore.Generation(); generation != g_rowPrewarm->Generation()) {
+                g_rowPrewarm->Begin(generation);
+                progress.next = 0;
+                progress.rows = 0;
+            }
+
+            auto& entries = *changes->entryList;
+            auto it = entries.begin();
+            for (std::size_t skipped = 0; skipped < progress.next && it != entries.end(); ++skipped) {
+                ++it;
+            }
+
+            const auto start = ReadSteadyNs();
+            bool more = false;
+            for (; it != entries.end(); ++it, ++progress.next) {
+                if (ReadSteadyNs() - start >= kRowPrewarmFrameBudgetNs) {
+                    more = true;
+                    break;
+                }
+
+                auto* entry = *it;
+                auto* object = entry ? entry->object : nullptr;
+                if (!object || !(object->IsWeapon() || object->IsArmor())) {
+                    continue;
+                }
+
+                // IsEntryMarked only reads the store, so the generation cannot move under the walk.
+                PrewarmedRow row;
+                row.marked = IsEntryMarked(entry);
+                row.hasEnchantment = EntryHasAnyEnchantment(entry);
+                g_rowPrewarm->Put(entry, row);
+                ++progress.rows;
+            }
+
+            ++progress.frames;
+            progress.busyNs += ReadSteadyNs() - start;
+            if (more) {
+                QueueRowPrewarmStep(a_session);
+                return;
+            }
+
+            progress.done = true;
+            RFAB_LOG_DEBUG(
+                "Pre-warmed {} disenchant row(s) in {} frame(s), {:.2f} ms busy",
+                progress.rows,
+                progress.frames,
+                static_cast<double>(progress.busyNs) / 1'000'000.0);
+        }
+
+        void StartRowPrewarm()
+        {
+            g_firstFrame = {};
+            g_rowPrewarmProgress = {};
+            if (!IsAtEnchantingWorkbench()) {
+                return;
+            }
+
+            g_firstFrame.tracking = true;
+            g_firstFrame.openNs = ReadSteadyNs();
+            if (!Settings::GetSingleton().prewarmRows) {
+                return;
+            }
+
+            g_rowPrewarmInvalidated.store(false);
+            g_rowPrewarm.emplace(g_sessionArena.PoolResource());
+            g_rowPrewarm->Begin(g_markStore.Generation());
+            QueueRowPrewarmStep(g_craftingSessionID);
+        }
+
+        void CompleteFirstFrame()
+        {
+            if (!g_firstFrame.pending) {
+                return;
+            }
+
+            const auto& progress = g_rowPrewarmProgress;
+            const auto prewarm = !g_rowPrewarm ?
+                                     std::string("off") :
+                                     std::format(
+                                         "{} hit(s), {} miss(es), {} row(s) in {} frame(s){}",
+                                         g_rowPrewarm->Hits(),
+                                         g_rowPrewarm->Misses(),
+                                         progress.rows,
+                                         progress.frames,
+                                         progress.done ? "" : ", unfinished");
+            SKSE::log::info(
+                "First Disenchant frame {:.2f} ms after the enchanting menu opened; row pass {:.2f} ms over {} row(s); pre-warm {}",
+                ElapsedMs(g_firstFrame.openNs),
+                static_cast<double>(g_firstFrame.rowPassNs) / 1'000'000.0,
+                g_firstFrame.rows,
+                prewarm);
+            g_firstFrame = {};
+            // From here on rows change under the player's hands; evaluate them live.
+            RetireRowPrewarm();
+        }
+
+        // Times the Disenchant rows of the first list pass; the UI task queued by the first of
+        // them runs on the following frame and closes the measurement.
+        class FirstFrameRowScope
+        {
+        public:
+            FirstFrameRowScope() :
+                _startNs(g_firstFrame.tracking ? ReadSteadyNs() : 0)
+            {}
+
+            FirstFrameRowScope(const FirstFrameRowScope&) = delete;
+            FirstFrameRowScope& operator=(const FirstFrameRowScope&) = delete;
+
+            ~FirstFrameRowScope()
+            {
+                if (_startNs == 0 || !g_firstFrame.tracking) {
+                    return;
+                }
+
+                g_firstFrame.rowPassNs += ReadSteadyNs() - _startNs;
+                ++g_firstFrame.rows;
+                if (g_firstFrame.pending) {
+                    return;
+                }
+
+                g_firstFrame.pending = true;
+                if (auto* task = SKSE::GetTaskInterface()) {
+                    AddTracedUITask(task, "FirstDisenchantFrame", CompleteFirstFrame);
+                }
+            }
+
+        private:
+            std::uint64_t _startNs;
+        };
+
+        void BeginCraftingSession()
+        {
+            ++g_craftingSessionID;
+            g_markedRowScratch.reset();
+            g_rowPrewarm.reset();
+            g_sessionArena.Begin();
+            StartRowPrewarm();
+        }
+
+        void EndCraftingSession()
+        {
+            if (!g_sessionArena.Active()) {
+                return;
+            }
+
+            ++g_craftingSessionID;
+            g_firstFrame = {};
+            g_markedRowScratch.reset();
+            g_rowPrewarm.reset();
+            const auto usage = g_sessionArena.End();
+            StoreStat(g_stats.sessionArenaPeakBytes, g_sessionArena.PeakBytes());
+            StoreStat(g_stats.sessionArenaAllocationsAvoided, g_sessionArena.TotalHeapAllocationsAvoided());
+            RFAB_LOG_DEBUG(
+                "CraftingMenu session arena: {} bytes in {} allocations, {} heap blocks",
+                usage.bytes,
+                usage.allocations,
+                usage.upstreamAllocations);
+
+            if (g_confirmFlow.TakeSampled()) {
+                LogSuppressionWindows("CraftingMenu closed");
+            }
+        }
+
+        class MenuOpenCloseSink final : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
+        {
+        public:
+            RE::BSEventNotifyControl ProcessEvent(
+                const RE::MenuOpenCloseEvent* a_event,
+                RE::BSTEventSource<RE::MenuOpenCloseEvent>*) override
+            {
+                if (!a_event) {
+                    return RE::BSEventNotifyControl::kContinue;
+                }
+
+                if (a_event->menuName == RE::MessageBoxMenu::MENU_NAME) {
+                    if (!a_event->opening && g_confirmFlow.OnMessageBoxClosed()) {
+                        SKSE::log::warn("Remove confirmation closed without an answer; releasing it");
+                        AbortRemoveConfirmation();
+                    }
+                    // Last, so a force-hide queued above for the box that just closed is released too.
+                    g_messageBoxForceHide.End();
+                    return RE::BSEventNotifyControl::kContinue;
+                }
+
+                if (a_event->menuName != RE::CraftingMenu::MENU_NAME) {
+                    return RE::BSEventNotifyControl::kContinue;
+                }
+
+                if (a_event->opening) {
+                    BeginCraftingSession();
+                    return RE::BSEventNotifyControl::kContinue;
+                }
 
-        std::mutex g_removeConfirmLock;
-        std::atomic_bool g_removeConfirmOpen{ false };
-        std::atomic_bool g_removeConfirmQueued{ false };
-        RemoveConfirmationRequest g_removeConfirmRequest;
+                // Anything still waiting to be restacked was stripped for a list that is gone.
+                DropPendingRestacks();
+                EndCraftingSession();
+                if (g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentStats) {
+                    DumpHookStats("CraftingMenu closed");
+                }
 
-        using ProcessUserEvent_t = bool(RE::CraftingSubMenus::EnchantConstructMenu*, RE::BSFixedString*);
-        REL::Relocation<ProcessUserEvent_t> g_processUserEventOriginal;
+                return RE::BSEventNotifyControl::kContinue;
+            }
+        };
 
-        [[nodiscard]] bool IsMarked(std::uint64_t a_key);
-        [[nodiscard]] bool IsMarked(const MarkSignature& a_signature);
-        [[nodiscard]] bool IsEntryMarked(
-            RE::InventoryEntryData* a_entry,
-            std::optional<std::uint64_t>* a_markedKey = nullptr,
-            std::optional<MarkSignature>* a_markedSignature = nullptr);
-        [[nodiscard]] RE::InventoryEntryData* ResolveDisenchantSelection(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
-        [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry* GetHighlightedItemEntry(
-            RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
-        [[nodiscard]] bool ShouldSuppressVanillaDisenchantPrompt(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
-        [[nodiscard]] bool EntryHasAnyEnchantment(RE::InventoryEntryData* a_entry);
-        [[nodiscard]] RE::EnchantmentItem* GetEntryExtraEnchantment(RE::InventoryEntryData* a_entry);
-        [[nodiscard]] bool EntryHasExtraEnchantment(RE::InventoryEntryData* a_entry);
-        [[nodiscard]] std::optional<std::uint64_t> GetAnyEntryKey(RE::InventoryEntryData* a_entry);
-        [[nodiscard]] bool EntryHasKey(RE::InventoryEntryData* a_entry, std::uint64_t a_key);
-        void ForceEnableMarkedDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
-        void DisableStaleDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu);
-        void QueueDisenchantPostRemoveRefresh();
-        void ArmForceHideNextMessageBox(std::uint32_t a_durationMs);
-        void ArmAllowNoDataMessageBox(std::uint32_t a_durationMs);
-        [[nodiscard]] bool ShouldForceHideMessageBoxNow();
-        [[nodiscard]] bool ShouldAllowNoDataMessageBoxNow();
-        void ArmSuppressEnchantInput(std::uint32_t a_durationMs);
-        [[nodiscard]] bool ShouldSuppressEnchantInputNow();
-        void ArmSuppressConfirm(std::uint32_t a_durationMs);
-        [[nodiscard]] bool ShouldSuppressConfirmNow();
-        void ShowRemoveConfirmation(
-            RE::CraftingSubMenus::EnchantConstructMenu* a_menu,
-            const std::optional<std::uint64_t>& a_key,
-            const std::optional<MarkSignature>& a_signature);
-        [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu* GetActiveEnchantConstructMenu();
+        MenuOpenCloseSink g_menuOpenCloseSink;
 
-        [[nodiscard]] bool EntryHasAnyEnchantment(RE::InventoryEntryData* a_entry)
+        std::mutex g_revalidateLock;
+        std::vector<std::uint64_t> g_revalidateKeys;
+
+        // True when a_container's live inventory holds the instance with a_key. Only the entry for
+        // the key's base object is looked at.
+        [[nodiscard]] bool ContainerHoldsKey(RE::TESObjectREFR* a_container, std::uint64_t a_key)
         {
-            if (!a_entry) {
+            auto* changes = a_container ? a_container->GetInventoryChanges() : nullptr;
+            if (!changes || !changes->entryList) {
                 return false;
             }
 
-            return a_entry->GetEnchantment() != nullptr || GetEntryExtraEnchantment(a_entry) != nullptr;
+            const auto baseID = static_cast<RE::FormID>(a_key >> 16u);
+            for (auto* entry : *changes->entryList) {
+                if (entry && entry->object && entry->object->GetFormID() == baseID) {
+                    return RFAB::Disenchant::EntryHasKey<GameEntryTraits>(entry, a_key);
+                }
+            }
+            return false;
         }
 
-        [[nodiscard]] RE::EnchantmentItem* GetEntryExtraEnchantment(RE::InventoryEntryData* a_entry)
+        // Checks one moved key against the container the index now places it in; a key that is not
+        // there after all loses its entry and falls back to the scans.
+        void RevalidateMarkLocation(std::uint64_t a_key)
         {
-            if (!a_entry || !a_entry->extraLists) {
-                return nullptr;
+            const auto location = g_markLocations.Find(a_key);
+            if (!location || location->kind != MarkLocationKind::kContainer) {
+                return;
             }
 
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
-                }
+            auto* ref = RE::TESForm::LookupByID<RE::TESObjectREFR>(location->ownerFormID);
+            if ((!ref || ref->IsDeleted() || !ContainerHoldsKey(ref, a_key)) && g_markLocations.Erase(a_key)) {
+                RFAB_LOG_DEBUG("Dropped mark location of {:016X}: not found in {:08X}", a_key, location->ownerFormID);
+            }
+        }
 
-                if (const auto* extra = extraList->GetByType<RE::ExtraEnchantment>(); extra && extra->enchantment) {
-                    return extra->enchantment;
+        // Revalidation runs on the next task pass for every key that moved in between; one task is
+        // queued however many keys pile up, and a key queued twice is simply checked twice.
+        void QueueMarkLocationRevalidation(std::uint64_t a_key)
+        {
+            {
+                std::scoped_lock lk(g_revalidateLock);
+                g_revalidateKeys.push_back(a_key);
+                if (g_revalidateKeys.size() != 1) {
+                    return;
                 }
             }
 
-            return nullptr;
+            auto* task = SKSE::GetTaskInterface();
+            if (!task) {
+                std::scoped_lock lk(g_revalidateLock);
+                g_revalidateKeys.clear();
+                return;
+            }
+
+            task->AddTask([]() {
+                std::vector<std::uint64_t> keys;
+                {
+                    std::scoped_lock lk(g_revalidateLock);
+                    keys.swap(g_revalidateKeys);
+                }
+                for (const auto key : keys) {
+                    RevalidateMarkLocation(key);
+                }
+            });
         }
 
-        [[nodiscard]] bool EntryHasExtraEnchantment(RE::InventoryEntryData* a_entry)
+        class ContainerChangedSink final : public RE::BSTEventSink<RE::TESContainerChangedEvent>
         {
-            return GetEntryExtraEnchantment(a_entry) != nullptr;
-        }
+        public:
+            RE::BSEventNotifyControl ProcessEvent(
+                const RE::TESContainerChangedEvent* a_event,
+                RE::BSTEventSource<RE::TESContainerChangedEvent>*) override
+            {
+                if (a_event && (a_event->oldContainer == kPlayerFormID || a_event->newContainer == kPlayerFormID)) {
+                    g_rowPrewarmInvalidated.store(true);
+                }
+
+                // Only unique instances can carry a key, and nothing is indexed before the first mark.
+                if (!a_event || a_event->uniqueID == 0 || g_markStore.KeyCount() == 0 || g_restackingStripped) {
+                    return RE::BSEventNotifyControl::kContinue;
+                }
+
+                std::optional<MarkLocation> to;
+                if (a_event->newContainer != 0) {
+                    to = MarkLocation{ a_event->newContainer, MarkLocationKind::kContainer };
+                } else if (const auto dropped = a_event->reference.get()) {
+                    to = MarkLocation{ dropped->GetFormID(), MarkLocationKind::kWorld };
+                }
+
+                // The event names the instance by its ExtraUniqueID: base object and unique ID.
+                const auto key = RFAB::Disenchant::MakeMarkKey(a_event->baseObj, a_event->uniqueID);
+                if (!g_markLocations.Move(g_markStore, key, to)) {
+                    return RE::BSEventNotifyControl::kContinue;
+                }
+
+                RFAB_LOG_DEBUG(
+                    "Marked instance {:016X} moved {:08X} -> {:08X}{}",
+                    key,
+                    a_event->oldContainer,
+                    to ? to->ownerFormID : 0,
+                    to ? (to->kind == MarkLocationKind::kWorld ? " (dropped)" : "") : " (destroyed)");
+                if (to && to->kind == MarkLocationKind::kContainer) {
+                    QueueMarkLocationRevalidation(key);
+                }
+                return RE::BSEventNotifyControl::kContinue;
+            }
+        };
+
+        ContainerChangedSink g_containerChangedSink;
 
         class RemoveHotkeySink final : public RE::BSTEventSink<RE::InputEvent*>
         {
@@ -160,17 +1064,24 @@ namespace RFAB::Disenchant
                     return RE::BSEventNotifyControl::kContinue;
                 }
 
+                // Modifier state is tracked from every event, before anything below can bail out,
+                // so a Shift released outside the menu is never remembered as held.
+                for (auto* e = *a_events; e; e = e->next) {
+                    if (e->eventType == RE::INPUT_EVENT_TYPE::kButton) {
+                        TrackBulkRemoveModifier(*static_cast<RE::ButtonEvent*>(e));
+                    }
+                }
+
                 auto* menu = GetActiveEnchantConstructMenu();
                 if (!menu || menu->currentCategory != RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant) {
                     return RE::BSEventNotifyControl::kContinue;
                 }
 
-                {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    if (g_removeConfirmOpen.load(std::memory_order_acquire) ||
-                        g_removeConfirmQueued.load(std::memory_order_acquire)) {
-                        return RE::BSEventNotifyControl::kContinue;
-                    }
+                // Behind another message box our dialog would queue up under it, and closing that
+                // box would read as ours being dismissed.
+                auto* ui = RE::UI::GetSingleton();
+                if (g_confirmFlow.IsBusy() || (ui && ui->IsMenuOpen(RE::MessageBoxMenu::MENU_NAME))) {
+                    return RE::BSEventNotifyControl::kContinue;
                 }
 
                 for (auto* e = *a_events; e; e = e->next) {
@@ -187,6 +1098,15 @@ namespace RFAB::Disenchant
                         continue;
                     }
 
+                    if (IsBulkRemoveModifierHeld()) {
+                        if (!MenuHasMarkedRow(menu)) {
+                            return RE::BSEventNotifyControl::kContinue;
+                        }
+
+                        ShowRemoveConfirmation(menu, std::nullopt, std::nullopt, true);
+                        return RE::BSEventNotifyControl::kStop;
+                    }
+
                     auto* entry = ResolveDisenchantSelection(menu);
                     std::optional<std::uint64_t> key;
                     std::optional<MarkSignature> sig;
@@ -205,17 +1125,6 @@ namespace RFAB::Disenchant
 
         RemoveHotkeySink g_removeHotkeySink;
 
-        [[nodiscard]] std::uint64_t MakeMarkKey(const RE::ExtraUniqueID& a_uniqueID)
-        {
-            return (static_cast<std::uint64_t>(a_uniqueID.baseID) << 16u) | static_cast<std::uint64_t>(a_uniqueID.uniqueID);
-        }
-
-        [[nodiscard]] constexpr MarkSignature MakeMarkSignature(std::uint32_t a_objectFormID, std::uint32_t a_enchantmentFormID) noexcept
-        {
-            const auto raw = (static_cast<std::uint64_t>(a_objectFormID) << 32u) | static_cast<std::uint64_t>(a_enchantmentFormID);
-            return static_cast<MarkSignature>(raw);
-        }
-
         [[nodiscard]] std::optional<MarkSignature> GetEntryMarkSignature(RE::InventoryEntryData* a_entry)
         {
             if (!a_entry) {
@@ -236,67 +1145,17 @@ namespace RFAB::Disenchant
 
         [[nodiscard]] std::optional<std::uint64_t> FindMarkedKeyInEntry(RE::InventoryEntryData* a_entry)
         {
-            if (!a_entry || !a_entry->extraLists) {
-                return std::nullopt;
-            }
-
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
-                }
-
-                const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>();
-                if (!uniqueID) {
-                    continue;
-                }
-
-                const auto key = MakeMarkKey(*uniqueID);
-                if (IsMarked(key)) {
-                    return key;
-                }
-            }
-
-            return std::nullopt;
+            return RFAB::Disenchant::FindMarkedKeyInEntry<GameEntryTraits>(g_markStore, a_entry);
         }
 
         [[nodiscard]] std::optional<std::uint64_t> GetAnyEntryKey(RE::InventoryEntryData* a_entry)
         {
-            if (!a_entry || !a_entry->extraLists) {
-                return std::nullopt;
-            }
-
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
-                }
-
-                if (const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>()) {
-                    return MakeMarkKey(*uniqueID);
-                }
-            }
-
-            return std::nullopt;
+            return RFAB::Disenchant::GetAnyEntryKey<GameEntryTraits>(a_entry);
         }
 
         [[nodiscard]] bool EntryHasKey(RE::InventoryEntryData* a_entry, std::uint64_t a_key)
         {
-            if (!a_entry || !a_entry->extraLists) {
-                return false;
-            }
-
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
-                }
-
-                if (const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>()) {
-                    if (MakeMarkKey(*uniqueID) == a_key) {
-                        return true;
-                    }
-                }
-            }
-
-            return false;
+            return RFAB::Disenchant::EntryHasKey<GameEntryTraits>(a_entry, a_key);
         }
 
         [[nodiscard]] std::optional<std::uint64_t> GetSelectedEntryMarkKey(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
@@ -320,12 +1179,16 @@ namespace RFAB::Disenchant
         [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry* GetHighlightedItemEntry(
             RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
         {
-            if (!a_menu || a_menu->highlightIndex >= a_menu->listEntries.size()) {
-                return nullptr;
+            return GetHighlightedRow<GameEntryTraits>(a_menu);
+        }
+
+        [[nodiscard]] TargetState MakeTargetState(RE::InventoryEntryData* a_entry)
+        {
+            if (!a_entry) {
+                return {};
             }
 
-            return skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(
-                a_menu->listEntries[a_menu->highlightIndex].get());
+            return { true, IsEntryMarked(a_entry), EntryHasAnyEnchantment(a_entry) };
         }
 
         [[nodiscard]] bool ShouldSuppressVanillaDisenchantPrompt(
@@ -335,104 +1198,192 @@ namespace RFAB::Disenchant
                 return false;
             }
 
-            auto* resolvedEntryData = ResolveDisenchantSelection(a_menu);
-            auto* selectedItemEntry = a_menu->selected.item ? a_menu->selected.item.get() : nullptr;
             auto* highlightedItemEntry = GetHighlightedItemEntry(a_menu);
 
-            auto* selectedEntryData = (selectedItemEntry && selectedItemEntry->data) ? selectedItemEntry->data : nullptr;
-            auto* highlightedEntryData = (highlightedItemEntry && highlightedItemEntry->data) ? highlightedItemEntry->data : nullptr;
-
-            const auto selectedMarked = selectedEntryData && IsEntryMarked(selectedEntryData);
-            const auto highlightedMarked = highlightedEntryData && IsEntryMarked(highlightedEntryData);
-            const auto resolvedMarked = resolvedEntryData && IsEntryMarked(resolvedEntryData);
-            if (selectedMarked || highlightedMarked || resolvedMarked) {
-                return true;
-            }
-
-            const auto selectedHasEnchant = selectedEntryData && EntryHasAnyEnchantment(selectedEntryData);
-            const auto highlightedHasEnchant = highlightedEntryData && EntryHasAnyEnchantment(highlightedEntryData);
-            const auto resolvedHasEnchant = resolvedEntryData && EntryHasAnyEnchantment(resolvedEntryData);
+            SelectionTargets targets;
+            targets.resolved = MakeTargetState(ResolveDisenchantSelection(a_menu));
+            targets.selected = MakeTargetState(GameEntryTraits::SelectedData(a_menu));
+            targets.highlighted = MakeTargetState(highlightedItemEntry ? highlightedItemEntry->data : nullptr);
+            return RFAB::Disenchant::ShouldSuppressVanillaDisenchantPrompt(targets);
+        }
 
-            const auto hasVisibleTarget = (highlightedEntryData != nullptr) || (selectedEntryData != nullptr) || (resolvedEntryData != nullptr);
-            const auto activeHasEnchant =
-                highlightedEntryData ? highlightedHasEnchant :
-                (selectedEntryData ? selectedHasEnchant : resolvedHasEnchant);
+        [[nodiscard]] RE::InventoryEntryData* ResolveDisenchantSelection(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        {
+            return RFAB::Disenchant::ResolveDisenchantSelection<GameEntryTraits>(a_menu);
+        }
 
-            if (hasVisibleTarget && !activeHasEnchant) {
-                return true;
+        [[nodiscard]] std::uint64_t GenerateJournalToken()
+        {
+            static std::mt19937_64 generator{ (static_cast<std::uint64_t>(std::random_device{}()) << 32u) ^ std::random_device{}() };
+            std::uint64_t token = 0;
+            while (token == 0) {
+                token = generator();
             }
+            return token;
+        }
 
-            return false;
+        [[nodiscard]] std::filesystem::path GetMarkJournalFolder()
+        {
+            return Settings::GetPluginFolder() / "Journal";
         }
 
-        [[nodiscard]] RE::InventoryEntryData* ResolveDisenchantSelection(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        [[nodiscard]] std::filesystem::path GetMarkJournalPath(std::uint64_t a_journalID)
         {
-            if (!a_menu) {
-                return nullptr;
-            }
+            return GetMarkJournalFolder() / std::format("{:016X}{}", a_journalID, MarkJournal::kExtension);
+        }
 
-            if (a_menu->selected.item && a_menu->selected.item->data) {
-                return a_menu->selected.item->data;
+        // A journal compacted into its save and never written again holds nothing; one is left
+        // behind by every character ever played. Runs before any journal is attached.
+        void RemoveEmptyMarkJournals()
+        {
+            if (const auto removed = MarkJournal::RemoveEmpty(GetMarkJournalFolder()); removed != 0) {
+                SKSE::log::info("Removed {} empty mark journal(s)", removed);
             }
+        }
 
-            if (a_menu->highlightIndex < a_menu->listEntries.size()) {
-                auto* highlightedEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(a_menu->listEntries[a_menu->highlightIndex].get());
-                if (highlightedEntry && highlightedEntry->data) {
-                    return highlightedEntry->data;
-                }
+        void EnsureMarkJournalAttached()
+        {
+            if (!Settings::GetSingleton().journalEnabled || g_markStore.HasJournal() || g_markStore.JournalFailed()) {
+                return;
             }
 
-            for (auto& listEntry : a_menu->listEntries) {
-                auto* itemEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(listEntry.get());
-                if (itemEntry && itemEntry->selected && itemEntry->data) {
-                    return itemEntry->data;
-                }
+            if (g_markJournalID == 0) {
+                g_markJournalID = GenerateJournalToken();
             }
 
-            for (auto& listEntry : a_menu->listEntries) {
-                auto* itemEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(listEntry.get());
-                if (itemEntry && itemEntry->data) {
-                    return itemEntry->data;
-                }
+            const auto path = GetMarkJournalPath(g_markJournalID);
+            if (!g_markStore.AttachJournal(path, g_markJournalBaseToken)) {
+                SKSE::log::error("Failed to open mark journal {}", path.string());
             }
-
-            return nullptr;
         }
 
+        // Keys are only ever marked from the player's own inventory.
         void MarkItem(std::uint64_t a_key)
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedItems.insert(a_key);
+            EnsureMarkJournalAttached();
+            g_markLocations.Set(a_key, { kPlayerFormID, MarkLocationKind::kContainer });
+            if (g_markStore.Mark(a_key)) {
+                RFAB_LOG_DEBUG("Marked instance {:016X}", a_key);
+                TraceMarkDelta(JournalOp::kMarkKey, a_key);
+                PublishMarkCounts();
+            }
         }
 
         void MarkItem(const MarkSignature& a_signature)
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedSignatures.insert(a_signature);
+            EnsureMarkJournalAttached();
+            if (g_markStore.Mark(a_signature)) {
+                RFAB_LOG_DEBUG(
+                    "Marked signature {:08X}:{:08X}",
+                    GetSignatureObjectFormID(a_signature),
+                    GetSignatureEnchantmentFormID(a_signature));
+                TraceMarkDelta(JournalOp::kMarkSignature, static_cast<std::uint64_t>(a_signature));
+                PublishMarkCounts();
+            }
+        }
+
+        // Records the deltas a batch is about to make; called before the store applies it so the
+        // marks already in the requested state can be left out.
+        void TraceMarkBatch(bool a_marking, std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures)
+        {
+            if (!(g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentTrace)) {
+                return;
+            }
+
+            const auto keyOp = a_marking ? JournalOp::kMarkKey : JournalOp::kUnmarkKey;
+            const auto signatureOp = a_marking ? JournalOp::kMarkSignature : JournalOp::kUnmarkSignature;
+            for (const auto key : a_keys) {
+                if (g_markStore.IsMarked(key) != a_marking) {
+                    TraceMarkDelta(keyOp, key);
+                }
+            }
+            for (const auto signature : a_signatures) {
+                if (g_markStore.IsMarked(signature) != a_marking) {
+                    TraceMarkDelta(signatureOp, static_cast<std::uint64_t>(signature));
+                }
+            }
         }
 
-        void UnmarkItem(std::uint64_t a_key)
+        // Batch counterpart of MarkItem for callers that change several marks at once, and the one
+        // way marks are removed: one store publish per call instead of one per mark.
+        void MarkItems(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures = {})
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedItems.erase(a_key);
+            EnsureMarkJournalAttached();
+            for (const auto key : a_keys) {
+                g_markLocations.Set(key, { kPlayerFormID, MarkLocationKind::kContainer });
+            }
+            TraceMarkBatch(true, a_keys, a_signatures);
+            if (const auto added = g_markStore.Mark(a_keys, a_signatures); added != 0) {
+                RFAB_LOG_DEBUG("Marked {} instance(s)/signature(s) in one batch", added);
+                PublishMarkCounts();
+            }
         }
 
-        void UnmarkItem(const MarkSignature& a_signature)
+        void UnmarkItems(std::span<const std::uint64_t> a_keys, std::span<const MarkSignature> a_signatures = {})
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedSignatures.erase(a_signature);
+            EnsureMarkJournalAttached();
+            for (const auto key : a_keys) {
+                g_markLocations.Erase(key);
+            }
+            TraceMarkBatch(false, a_keys, a_signatures);
+            if (const auto removed = g_markStore.Unmark(a_keys, a_signatures); removed != 0) {
+                RFAB_LOG_DEBUG("Unmarked {} instance(s)/signature(s) in one batch", removed);
+                PublishMarkCounts();
+            }
         }
 
         [[nodiscard]] bool IsMarked(std::uint64_t a_key)
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            return g_markedItems.contains(a_key);
+            return g_markStore.IsMarked(a_key);
         }
 
         [[nodiscard]] bool IsMarked(const MarkSignature& a_signature)
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            return g_markedSignatures.contains(a_signature);
+            return g_markStore.IsMarked(a_signature);
+        }
+
+        // Gives every instance in a_container whose object/enchantment pair is in a_signatures
+        // (ascending) an ExtraUniqueID from the container's own allocator
+        // (InventoryChanges::SetUniqueID) and returns the keys of all of them. a_matched, if given,
+        // receives how many instances matched, keyed or not. Walks the live InventoryChanges once,
+        // not a GetInventory copy.
+        [[nodiscard]] std::pmr::vector<std::uint64_t> AssignUniqueIDs(
+            RE::TESObjectREFR* a_container,
+            std::span<const MarkSignature> a_signatures,
+            std::size_t* a_matched = nullptr)
+        {
+            std::pmr::vector<std::uint64_t> keys(g_sessionArena.Resource());
+            std::size_t matched = 0;
+            auto* changes = a_container ? a_container->GetInventoryChanges() : nullptr;
+            if (changes && changes->entryList && !a_signatures.empty()) {
+                for (auto* entry : *changes->entryList) {
+                    if (!entry || !entry->object || !entry->extraLists) {
+                        continue;
+                    }
+
+                    const auto objectFormID = entry->object->GetFormID();
+                    for (auto* extraList : *entry->extraLists) {
+                        const auto* extraEnchant = extraList ? extraList->GetByType<RE::ExtraEnchantment>() : nullptr;
+                        if (!extraEnchant || !extraEnchant->enchantment ||
+                            !std::ranges::binary_search(a_signatures, MakeMarkSignature(objectFormID, extraEnchant->enchantment->GetFormID()))) {
+                            continue;
+                        }
+
+                        ++matched;
+                        if (!extraList->HasType(RE::ExtraDataType::kUniqueID)) {
+                            changes->SetUniqueID(extraList, nullptr, entry->object);
+                        }
+                        if (const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>()) {
+                            keys.push_back(MakeMarkKey(*uniqueID));
+                        }
+                    }
+                }
+            }
+
+            if (a_matched) {
+                *a_matched = matched;
+            }
+            return keys;
         }
 
         [[nodiscard]] bool IsEntryMarked(
@@ -440,292 +1391,362 @@ namespace RFAB::Disenchant
             std::optional<std::uint64_t>* a_markedKey,
             std::optional<MarkSignature>* a_markedSignature)
         {
+            std::optional<std::uint64_t> key;
+            std::optional<MarkSignature> signature;
+            const auto marked = RFAB::Disenchant::IsEntryMarked<GameEntryTraits>(g_markStore, a_entry, &key, &signature);
             if (a_markedKey) {
-                *a_markedKey = std::nullopt;
+                *a_markedKey = key;
             }
-
             if (a_markedSignature) {
-                *a_markedSignature = std::nullopt;
+                *a_markedSignature = signature;
             }
-
-            if (!a_entry) {
-                return false;
+            if (IsCollectingCounters()) {
+                BumpStat(g_stats.markLookups);
+                if (marked) {
+                    BumpStat(g_stats.markLookupHits);
+                }
             }
+            return marked;
+        }
 
-            const auto key = FindMarkedKeyInEntry(a_entry);
-            if (key) {
-                if (a_markedKey) {
-                    *a_markedKey = key;
-                }
-                return true;
+        [[nodiscard]] std::size_t CountExtraData(RE::ExtraDataList* a_extraList)
+        {
+            std::size_t count = 0;
+            for (auto& extra : *a_extraList) {
+                (void)extra;
+                ++count;
             }
+            return count;
+        }
 
-            const auto signature = GetEntryMarkSignature(a_entry);
-            if (signature && IsMarked(*signature)) {
-                if (a_markedKey) {
-                    *a_markedKey = GetAnyEntryKey(a_entry);
-                }
-                if (a_markedSignature) {
-                    *a_markedSignature = signature;
-                }
-                return true;
+        // Unlinks and frees the ExtraEnchantment and ExtraCharge nodes of one list, so later
+        // GetByType walks skip them, the save no longer carries them and the instance can stack
+        // with plain copies again. Returns true when anything was removed.
+        [[nodiscard]] bool RemoveEnchantmentExtras(RE::ExtraDataList* a_extraList)
+        {
+            if (!a_extraList) {
+                return false;
             }
 
-            if (EntryHasExtraEnchantment(a_entry)) {
-                if (a_markedKey) {
-                    *a_markedKey = GetAnyEntryKey(a_entry);
-                }
-                if (a_markedSignature) {
-                    *a_markedSignature = GetEntryMarkSignature(a_entry);
-                }
-                return true;
+            const auto lengthBefore = CountExtraData(a_extraList);
+            const auto removedEnchantment = a_extraList->RemoveByType(RE::ExtraDataType::kEnchantment);
+            const auto removedCharge = a_extraList->RemoveByType(RE::ExtraDataType::kCharge);
+            if (!removedEnchantment && !removedCharge) {
+                return false;
             }
 
-            return false;
+            RFAB_LOG_DEBUG(
+                "Removed enchantment extras (enchantment {}, charge {}); extra list length {} -> {}",
+                removedEnchantment,
+                removedCharge,
+                lengthBefore,
+                CountExtraData(a_extraList));
+            return true;
         }
 
-        [[nodiscard]] bool RemoveEnchantmentFromEntry(RE::InventoryEntryData* a_entry)
+        // Strips the extra lists of a_entry that a_match accepts, stopping after the first when
+        // a_firstOnly. Returns true when anything was removed; marking the owner's inventory as
+        // changed is left to the caller. The keys of lists that lost their enchantment are appended
+        // to a_strippedKeys; a list without a unique ID cannot be found again later and is left as is.
+        template <class F>
+        [[nodiscard]] bool StripMatchingLists(
+            RE::InventoryEntryData* a_entry,
+            F&& a_match,
+            bool a_firstOnly,
+            std::pmr::vector<std::uint64_t>* a_strippedKeys)
         {
             if (!a_entry || !a_entry->extraLists) {
                 return false;
             }
 
-            auto clearExtraData = [](RE::ExtraDataList* a_extraList, bool* a_hadData) -> bool {
-                if (a_hadData) {
-                    *a_hadData = false;
-                }
-                if (!a_extraList) {
-                    return false;
+            bool removed = false;
+            for (auto* extraList : *a_entry->extraLists) {
+                if (!extraList || !a_match(*extraList)) {
+                    continue;
                 }
 
-                bool changed = false;
-
-                if (auto* extraEnchant = a_extraList->GetByType<RE::ExtraEnchantment>()) {
-                    if (a_hadData) {
-                        *a_hadData = true;
+                if (RemoveEnchantmentExtras(extraList)) {
+                    removed = true;
+                    const auto* uniqueID = a_strippedKeys ? extraList->GetByType<RE::ExtraUniqueID>() : nullptr;
+                    if (uniqueID) {
+                        a_strippedKeys->push_back(MakeMarkKey(*uniqueID));
                     }
-                    if (extraEnchant->enchantment != nullptr || extraEnchant->charge != 0 || extraEnchant->removeOnUnequip) {
-                        changed = true;
-                    }
-                    extraEnchant->enchantment = nullptr;
-                    extraEnchant->charge = 0;
-                    extraEnchant->removeOnUnequip = false;
                 }
-
-                if (auto* extraCharge = a_extraList->GetByType<RE::ExtraCharge>()) {
-                    if (a_hadData) {
-                        *a_hadData = true;
-                    }
-                    if (extraCharge->charge != 0.0F) {
-                        changed = true;
-                    }
-                    extraCharge->charge = 0.0F;
+                if (a_firstOnly) {
+                    break;
                 }
+            }
 
-                return changed;
-            };
+            return removed;
+        }
+
+        // Strips the instance with a_key.
+        [[nodiscard]] bool StripEntryEnchantment(
+            RE::InventoryEntryData* a_entry,
+            std::uint64_t a_key,
+            std::pmr::vector<std::uint64_t>* a_strippedKeys = nullptr)
+        {
+            return StripMatchingLists(
+                a_entry,
+                [&](RE::ExtraDataList& a_extraList) {
+                    const auto* uniqueID = a_extraList.GetByType<RE::ExtraUniqueID>();
+                    return uniqueID && MakeMarkKey(*uniqueID) == a_key;
+                },
+                true,
+                a_strippedKeys);
+        }
+
+        // Strips every instance of the entry that carries a_signature's enchantment; lists enchanted
+        // with anything else, and entries of another object, are left alone.
+        [[nodiscard]] bool StripEntryEnchantment(
+            RE::InventoryEntryData* a_entry,
+            MarkSignature a_signature,
+            std::pmr::vector<std::uint64_t>* a_strippedKeys = nullptr)
+        {
+            if (!a_entry || !a_entry->object || a_entry->object->GetFormID() != GetSignatureObjectFormID(a_signature)) {
+                return false;
+            }
 
-            bool changedAny = false;
-            bool hadAnyEnchantData = false;
+            const auto enchantmentFormID = GetSignatureEnchantmentFormID(a_signature);
+            return StripMatchingLists(
+                a_entry,
+                [&](RE::ExtraDataList& a_extraList) {
+                    const auto* extraEnchant = a_extraList.GetByType<RE::ExtraEnchantment>();
+                    return extraEnchant && extraEnchant->enchantment && extraEnchant->enchantment->GetFormID() == enchantmentFormID;
+                },
+                false,
+                a_strippedKeys);
+        }
 
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
+        void FlagInventoryChanged(RE::TESObjectREFR* a_owner)
+        {
+            if (a_owner) {
+                if (auto* invChanges = a_owner->GetInventoryChanges()) {
+                    invChanges->changed = true;
+                }
+                // Stripping changes row state without a container event.
+                if (a_owner->GetFormID() == kPlayerFormID) {
+                    RetireRowPrewarm();
                 }
-
-                bool hadListData = false;
-                changedAny = clearExtraData(extraList, &hadListData) || changedAny;
-                hadAnyEnchantData = hadAnyEnchantData || hadListData;
             }
+        }
 
-            if (changedAny) {
-                auto* player = RE::PlayerCharacter::GetSingleton();
-                if (player) {
-                    if (auto* invChanges = player->GetInventoryChanges()) {
-                        invChanges->changed = true;
-                    }
+        // True when nothing but the unique ID and count sets the instance apart from the plain stack.
+        [[nodiscard]] bool IsPlainInstance(RE::ExtraDataList* a_extraList)
+        {
+            for (auto& extra : *a_extraList) {
+                switch (extra.GetType()) {
+                case RE::ExtraDataType::kUniqueID:
+                case RE::ExtraDataType::kCount:
+                    break;
+                default:
+                    return false;
                 }
             }
-
-            return changedAny || hadAnyEnchantData;
+            return true;
         }
 
-        [[nodiscard]] bool ItemHasExtraEnchantment(std::uint64_t a_key)
+        // Folds stripped instances that are now indistinguishable from the base item back into the
+        // plain stack. The instances are looked up by key in a_container's live InventoryChanges
+        // here, so one that was dropped, sold or merged since the strip is simply not found. The
+        // merge goes through the container (remove the instance, add plain copies) rather than
+        // unlinking lists by hand. Returns the number of instances merged.
+        std::size_t RestackStrippedInstances(RE::TESObjectREFR* a_container, std::span<const std::uint64_t> a_keys)
         {
-            auto* player = RE::PlayerCharacter::GetSingleton();
-            if (!player) {
-                return false;
+            auto* changes = a_container && !a_keys.empty() ? a_container->GetInventoryChanges() : nullptr;
+            if (!changes || !changes->entryList) {
+                return 0;
             }
 
-            const auto inventory = player->GetInventory();
-            for (const auto& [obj, invPair] : inventory) {
-                (void)obj;
-                const auto& [count, entry] = invPair;
-                (void)count;
-                if (!entry) {
-                    continue;
-                }
+            std::pmr::vector<std::uint64_t> sorted(a_keys.begin(), a_keys.end(), g_sessionArena.Resource());
+            std::ranges::sort(sorted);
 
-                if (!EntryHasKey(entry.get(), a_key) || !entry->extraLists) {
+            struct PlainInstance
+            {
+                RE::TESBoundObject* object;
+                RE::ExtraDataList* extraList;
+                std::uint64_t key;
+            };
+            std::pmr::vector<PlainInstance> plain(g_sessionArena.Resource());
+            for (auto* entry : *changes->entryList) {
+                if (!entry || !entry->object || !entry->extraLists) {
                     continue;
                 }
 
                 for (auto* extraList : *entry->extraLists) {
-                    if (!extraList) {
+                    const auto* uniqueID = extraList ? extraList->GetByType<RE::ExtraUniqueID>() : nullptr;
+                    if (!uniqueID) {
                         continue;
                     }
-                    const auto* extraEnchant = extraList->GetByType<RE::ExtraEnchantment>();
-                    if (extraEnchant && extraEnchant->enchantment) {
-                        return true;
+
+                    const auto key = MakeMarkKey(*uniqueID);
+                    if (std::ranges::binary_search(sorted, key) && IsPlainInstance(extraList)) {
+                        plain.push_back({ entry->object, extraList, key });
                     }
                 }
             }
 
-            return false;
+            std::pmr::vector<std::uint64_t> unmarked(g_sessionArena.Resource());
+            unmarked.reserve(plain.size());
+            for (const auto& instance : plain) {
+                unmarked.push_back(instance.key);
+            }
+            UnmarkItems(unmarked);
+
+            // The merge frees entries the pre-warm may be keyed by.
+            if (!plain.empty() && a_container->GetFormID() == kPlayerFormID) {
+                RetireRowPrewarm();
+            }
+            g_restackingStripped = true;
+            for (const auto& [object, extraList, key] : plain) {
+                const auto count = extraList->GetCount();
+                // extraList belongs to the container from here on and is freed by RemoveItem.
+                a_container->RemoveItem(object, count, RE::ITEM_REMOVE_REASON::kRemove, extraList, nullptr);
+                a_container->AddObjectToContainer(object, nullptr, count, nullptr);
+            }
+            g_restackingStripped = false;
+
+            const auto merged = plain.size();
+            if (merged != 0) {
+                SKSE::log::info("Restacked {} stripped instance(s) into their base stack", merged);
+            }
+            return merged;
         }
 
-        [[nodiscard]] bool ItemHasExtraEnchantment(const MarkSignature& a_signature)
+        struct PendingRestack
         {
-            auto* player = RE::PlayerCharacter::GetSingleton();
-            if (!player) {
-                return false;
+            RE::ObjectRefHandle container;
+            std::vector<std::uint64_t> keys;
+        };
+
+        // Stripped instances waiting for the next menu refresh. The rows of the open list still
+        // point at their extra lists, which the merge frees, so the restack runs in the refresh
+        // task right before the list is rebuilt rather than where the strip happened. Only keys
+        // are kept across frames; the lists are resolved again when the restack runs.
+        std::mutex g_pendingRestackLock;
+        std::vector<PendingRestack> g_pendingRestacks;
+
+        void QueueRestack(RE::TESObjectREFR* a_container, std::span<const std::uint64_t> a_strippedKeys)
+        {
+            if (!a_container || a_strippedKeys.empty() || !Settings::GetSingleton().restackStripped) {
+                return;
             }
 
-            const auto inventory = player->GetInventory();
-            for (const auto& [obj, invPair] : inventory) {
-                (void)obj;
-                const auto& [count, entry] = invPair;
-                (void)count;
-                if (!entry) {
-                    continue;
+            {
+                std::scoped_lock lk(g_pendingRestackLock);
+                g_pendingRestacks.push_back({ a_container->GetHandle(), { a_strippedKeys.begin(), a_strippedKeys.end() } });
+            }
+            RequestMenuRefresh(RefreshLevel::kList);
+        }
+
+        void RestackPendingInstances()
+        {
+            std::vector<PendingRestack> pending;
+            {
+                std::scoped_lock lk(g_pendingRestackLock);
+                pending.swap(g_pendingRestacks);
+            }
+
+            for (const auto& [handle, keys] : pending) {
+                if (const auto container = handle.get()) {
+                    RestackStrippedInstances(container.get(), keys);
                 }
+            }
+        }
+
+        void DropPendingRestacks()
+        {
+            std::scoped_lock lk(g_pendingRestackLock);
+            g_pendingRestacks.clear();
+        }
+
+        // True while a_container still holds an instance of the signature's object carrying the
+        // signature's enchantment. Walks the live InventoryChanges, not a GetInventory copy.
+        [[nodiscard]] bool ContainerHoldsSignature(RE::TESObjectREFR* a_container, MarkSignature a_signature)
+        {
+            auto* changes = a_container ? a_container->GetInventoryChanges() : nullptr;
+            if (!changes || !changes->entryList) {
+                return false;
+            }
 
-                const auto signature = GetEntryMarkSignature(entry.get());
-                if (!signature || *signature != a_signature) {
+            const auto objectFormID = GetSignatureObjectFormID(a_signature);
+            const auto enchantmentFormID = GetSignatureEnchantmentFormID(a_signature);
+            for (auto* entry : *changes->entryList) {
+                if (!entry || !entry->object || entry->object->GetFormID() != objectFormID) {
                     continue;
                 }
 
-                if (entry->GetEnchantment()) {
-                    return true;
+                // An object enchanted by its base form carries the enchantment on every copy.
+                const auto* enchantable = entry->object->As<RE::TESEnchantableForm>();
+                if (enchantable && enchantable->formEnchanting && enchantable->formEnchanting->GetFormID() == enchantmentFormID) {
+                    return entry->countDelta > 0;
                 }
-
                 if (!entry->extraLists) {
                     continue;
                 }
 
                 for (auto* extraList : *entry->extraLists) {
-                    if (!extraList) {
-                        continue;
-                    }
-                    const auto* extraEnchant = extraList->GetByType<RE::ExtraEnchantment>();
-                    if (extraEnchant && extraEnchant->enchantment) {
+                    const auto* extraEnchant = extraList ? extraList->GetByType<RE::ExtraEnchantment>() : nullptr;
+                    if (extraEnchant && extraEnchant->enchantment && extraEnchant->enchantment->GetFormID() == enchantmentFormID) {
                         return true;
                     }
                 }
             }
-
             return false;
         }
 
-        [[nodiscard]] bool ItemExistsInPlayerInventory(std::uint64_t a_key)
+        [[nodiscard]] bool RemoveEnchantmentFromSignature(RE::InventoryEntryData* a_entry, MarkSignature a_signature)
         {
-            auto* player = RE::PlayerCharacter::GetSingleton();
-            if (!player) {
-                return false;
-            }
-
-            const auto inventory = player->GetInventory();
-            for (const auto& [obj, invPair] : inventory) {
-                (void)obj;
-                const auto& [count, entry] = invPair;
-                (void)count;
-                if (!entry) {
-                    continue;
-                }
-
-                if (EntryHasKey(entry.get(), a_key)) {
-                    return true;
-                }
+            std::pmr::vector<std::uint64_t> stripped(g_sessionArena.Resource());
+            const auto removed = StripEntryEnchantment(a_entry, a_signature, &stripped);
+            if (removed) {
+                auto* player = RE::PlayerCharacter::GetSingleton();
+                FlagInventoryChanged(player);
+                QueueRestack(player, stripped);
             }
-
-            return false;
+            return removed;
         }
 
-        [[nodiscard]] bool ItemExistsInPlayerInventory(const MarkSignature& a_signature)
+        [[nodiscard]] bool ItemHasExtraEnchantment(std::uint64_t a_key)
         {
+            ChromeSpan span("ItemHasExtraEnchantment(key)", kChromeScanCategory);
             auto* player = RE::PlayerCharacter::GetSingleton();
             if (!player) {
                 return false;
             }
 
-            const auto inventory = player->GetInventory();
-            for (const auto& [obj, invPair] : inventory) {
-                (void)obj;
-                const auto& [count, entry] = invPair;
-                (void)count;
-                if (!entry) {
-                    continue;
-                }
-
-                const auto signature = GetEntryMarkSignature(entry.get());
-                if (signature && *signature == a_signature) {
-                    return true;
-                }
-            }
-
-            return false;
+            const auto inventory = GetPlayerInventory(player);
+            auto* entry = FindEntryByKey<GameEntryTraits>(inventory, a_key, GetInventoryEntry);
+            return entry && EntryHasExtraEnchantment(entry);
         }
 
-        [[nodiscard]] bool RemoveEnchantmentFromMarkedInstance(RE::InventoryEntryData* a_entry, std::uint64_t a_key)
+        [[nodiscard]] bool ItemExistsInPlayerInventory(std::uint64_t a_key)
         {
-            if (!a_entry || !a_entry->extraLists) {
+            // An instance the index has seen leave the player is not there; anything else, including
+            // keys the index has no entry for, is confirmed with a walk.
+            if (const auto location = g_markLocations.Find(a_key); location && location->ownerFormID != kPlayerFormID) {
                 return false;
             }
 
-            for (auto* extraList : *a_entry->extraLists) {
-                if (!extraList) {
-                    continue;
-                }
-
-                const auto* uniqueID = extraList->GetByType<RE::ExtraUniqueID>();
-                if (!uniqueID || MakeMarkKey(*uniqueID) != a_key) {
-                    continue;
-                }
-
-                bool hadEnchantData = false;
-                bool changed = false;
-
-                if (auto* extraEnchant = extraList->GetByType<RE::ExtraEnchantment>()) {
-                    hadEnchantData = true;
-                    if (extraEnchant->enchantment != nullptr || extraEnchant->charge != 0 || extraEnchant->removeOnUnequip) {
-                        changed = true;
-                    }
-                    extraEnchant->enchantment = nullptr;
-                    extraEnchant->charge = 0;
-                    extraEnchant->removeOnUnequip = false;
-                }
-
-                if (auto* extraCharge = extraList->GetByType<RE::ExtraCharge>()) {
-                    hadEnchantData = true;
-                    if (extraCharge->charge != 0.0F) {
-                        changed = true;
-                    }
-                    extraCharge->charge = 0.0F;
-                }
+            ChromeSpan span("ItemExistsInPlayerInventory(key)", kChromeScanCategory);
+            auto* player = RE::PlayerCharacter::GetSingleton();
+            if (!player) {
+                return false;
+            }
 
-                if (changed) {
-                    auto* player = RE::PlayerCharacter::GetSingleton();
-                    if (player) {
-                        if (auto* invChanges = player->GetInventoryChanges()) {
-                            invChanges->changed = true;
-                        }
-                    }
-                }
+            return FindEntryByKey<GameEntryTraits>(GetPlayerInventory(player), a_key, GetInventoryEntry) != nullptr;
+        }
 
-                return changed || hadEnchantData;
+        [[nodiscard]] bool RemoveEnchantmentFromMarkedInstance(RE::InventoryEntryData* a_entry, std::uint64_t a_key)
+        {
+            std::pmr::vector<std::uint64_t> stripped(g_sessionArena.Resource());
+            const auto removed = StripEntryEnchantment(a_entry, a_key, &stripped);
+            if (removed) {
+                auto* player = RE::PlayerCharacter::GetSingleton();
+                FlagInventoryChanged(player);
+                QueueRestack(player, stripped);
             }
-
-            return false;
+            return removed;
         }
 
         [[nodiscard]] RE::InventoryEntryData* FindMarkedEntryInMenu(
@@ -767,41 +1788,6 @@ namespace RFAB::Disenchant
             return ResolveDisenchantSelection(a_menu);
         }
 
-        [[nodiscard]] RE::InventoryEntryData* FindMarkedEntryInPlayerInventory(
-            const std::optional<std::uint64_t>& a_key,
-            const std::optional<MarkSignature>& a_signature)
-        {
-            auto* player = RE::PlayerCharacter::GetSingleton();
-            if (!player) {
-                return nullptr;
-            }
-
-            const auto inventory = player->GetInventory();
-            for (const auto& [obj, invPair] : inventory) {
-                (void)obj;
-                const auto& [count, entry] = invPair;
-                (void)count;
-                if (!entry) {
-                    continue;
-                }
-
-                if (a_key) {
-                    if (EntryHasKey(entry.get(), *a_key)) {
-                        return entry.get();
-                    }
-                }
-
-                if (a_signature) {
-                    const auto signature = GetEntryMarkSignature(entry.get());
-                    if (signature && *signature == *a_signature) {
-                        return entry.get();
-                    }
-                }
-            }
-
-            return nullptr;
-        }
-
         [[nodiscard]] RE::CraftingSubMenus::EnchantConstructMenu* GetActiveEnchantConstructMenu()
         {
             auto* ui = RE::UI::GetSingleton();
@@ -823,6 +1809,7 @@ namespace RFAB::Disenchant
             const std::optional<std::uint64_t>& a_preferredKey,
             const std::optional<MarkSignature>& a_preferredSignature)
         {
+            ChromeSpan span("RemoveMarkedItem", kChromeMenuCategory);
             auto key = a_preferredKey;
             auto signature = a_preferredSignature;
             auto* entry = FindMarkedEntryInMenu(a_menu, key, signature);
@@ -836,40 +1823,129 @@ namespace RFAB::Disenchant
                 }
             }
 
-            bool removed = false;
-            if (key) {
-                removed = RemoveEnchantmentFromMarkedInstance(entry, *key);
-            } else {
-                key = GetAnyEntryKey(entry);
-                if (key) {
-                    removed = RemoveEnchantmentFromMarkedInstance(entry, *key);
-                }
-            }
-
+            // Only ever the marked instance, or the instances carrying the signature's enchantment.
+            auto removed = key && RemoveEnchantmentFromMarkedInstance(entry, *key);
             if (!removed && signature) {
-                removed = RemoveEnchantmentFromEntry(entry);
+                removed = RemoveEnchantmentFromSignature(entry, *signature);
             }
 
             if (!removed) {
+                RFAB_LOG_DEBUG("RemoveMarkedItem: nothing removed");
                 return false;
             }
 
+            // A signature mark goes with the last carried instance of its pair.
+            std::pmr::vector<std::uint64_t> unmarkKeys(g_sessionArena.Resource());
+            std::pmr::vector<MarkSignature> unmarkSignatures(g_sessionArena.Resource());
             if (key) {
-                UnmarkItem(*key);
+                unmarkKeys.push_back(*key);
             }
-            if (signature) {
-                UnmarkItem(*signature);
+            if (signature && IsMarked(*signature) && !ContainerHoldsSignature(RE::PlayerCharacter::GetSingleton(), *signature)) {
+                unmarkSignatures.push_back(*signature);
             }
+            UnmarkItems(unmarkKeys, unmarkSignatures);
 
             if (a_menu) {
-                a_menu->UpdateConstructibleList();
-                a_menu->UpdateInterface();
-                DisableStaleDisenchantRows(a_menu);
-                QueueDisenchantPostRemoveRefresh();
+                RequestMenuRefresh(RefreshLevel::kReload);
             }
             return true;
         }
 
+        // Walks a_container's inventory once and calls a_visitor(object, entry, key, signature) for
+        // every entry IsEntryMarked accepts.
+        template <class F>
+        void ForEachMarkedInventoryEntry(RE::TESObjectREFR* a_container, std::function<bool(RE::TESBoundObject&)> a_filter, F&& a_visitor)
+        {
+            if (!a_container) {
+                return;
+            }
+
+            ChromeSpan span("ForEachMarkedInventoryEntry", kChromeScanCategory);
+            const auto inventory = GetReferenceInventory(a_container, std::move(a_filter));
+            for (const auto& [object, invPair] : inventory) {
+                const auto& [count, entry] = invPair;
+                if (!object || count <= 0 || !entry) {
+                    continue;
+                }
+
+                std::optional<std::uint64_t> key;
+                std::optional<MarkSignature> signature;
+                if (IsEntryMarked(entry.get(), &key, &signature)) {
+                    a_visitor(object, entry.get(), key, signature);
+                }
+            }
+        }
+
+        // Bulk counterpart of RemoveMarkedItem: one inventory pass, one InventoryChanges update and
+        // one menu refresh no matter how many items are stripped. Returns the number stripped.
+        std::size_t StripAllMarkedEnchantments(
+            RE::TESObjectREFR* a_container,
+            RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        {
+            ChromeSpan span("StripAllMarkedEnchantments", kChromeMenuCategory);
+            std::size_t removed = 0;
+            std::pmr::vector<std::uint64_t> stripped(g_sessionArena.Resource());
+            std::pmr::vector<std::uint64_t> unmarkKeys(g_sessionArena.Resource());
+            std::pmr::vector<MarkSignature> strippedSignatures(g_sessionArena.Resource());
+            ForEachMarkedInventoryEntry(a_container, nullptr, [&](auto*, RE::InventoryEntryData* a_entry, const auto&, const auto& a_signature) {
+                // Every marked instance of the entry; an entry marked some other way only gives up
+                // the instances carrying its signature's enchantment, as in RemoveMarkedItem.
+                bool removedAny = false;
+                GameEntryTraits::ForEachUniqueKey(a_entry, [&](std::uint64_t a_instanceKey) {
+                    if (IsMarked(a_instanceKey) && StripEntryEnchantment(a_entry, a_instanceKey, &stripped)) {
+                        unmarkKeys.push_back(a_instanceKey);
+                        removedAny = true;
+                    }
+                    return false;
+                });
+
+                if (!removedAny) {
+                    removedAny = a_signature && StripEntryEnchantment(a_entry, *a_signature, &stripped);
+                    if (!removedAny) {
+                        return;
+                    }
+                }
+
+                if (a_signature && IsMarked(*a_signature)) {
+                    strippedSignatures.push_back(*a_signature);
+                }
+                ++removed;
+            });
+
+            if (removed == 0) {
+                RFAB_LOG_DEBUG("StripAllMarkedEnchantments: nothing removed");
+                return 0;
+            }
+
+            // Judged after the whole pass, so a pair spread over several entries is only let go
+            // once none of them holds it any more.
+            std::erase_if(strippedSignatures, [&](MarkSignature a_signature) { return ContainerHoldsSignature(a_container, a_signature); });
+            UnmarkItems(unmarkKeys, strippedSignatures);
+            FlagInventoryChanged(a_container);
+            QueueRestack(a_container, stripped);
+
+            SKSE::log::info("Stripped {} marked enchantment(s) in one pass", removed);
+            if (a_menu) {
+                RequestMenuRefresh(RefreshLevel::kReload);
+            }
+            return removed;
+        }
+
+        [[nodiscard]] bool MenuHasMarkedRow(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
+        {
+            if (!a_menu) {
+                return false;
+            }
+
+            for (auto& listEntry : a_menu->listEntries) {
+                auto* itemEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(listEntry.get());
+                if (itemEntry && itemEntry->data && IsEntryMarked(itemEntry->data)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         class RemoveConfirmCallback final : public RE::IMessageBoxCallback
         {
         public:
@@ -880,29 +1956,27 @@ namespace RFAB::Disenchant
 
             void Run(Message a_msg) override
             {
+                HookScope scope(HookId::kRemoveConfirmRun);
+                scope.SetDecision(a_msg == Message::kUnk0 ? 1u : 0u);
+
                 RemoveConfirmationRequest request;
                 {
                     std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmOpen.store(false, std::memory_order_release);
                     request = g_removeConfirmRequest;
                     g_removeConfirmRequest = {};
                 }
 
-                g_messageBoxShowingOurConfirm.store(false, std::memory_order_release);
-
-                g_allowNoDataMessageBoxUntilMs.store(0, std::memory_order_release);
-                if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
-                    queue->AddMessage(RE::MessageBoxMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
-                }
-                ArmForceHideNextMessageBox(3000);
-                ArmSuppressEnchantInput(1500);
+                g_confirmFlow.OnClosed(GetRunTimeMs());
+                QueueMessageBoxForceHide();
 
-                if (a_msg != Message::kUnk0 || (!request.key && !request.signature)) {
+                if (a_msg != Message::kUnk0 || (!request.bulk && !request.key && !request.signature)) {
                     return;
                 }
 
                 auto* menu = GetActiveEnchantConstructMenu();
-                const auto removed = RemoveMarkedItem(menu, request.key, request.signature);
+                const auto removed = request.bulk ?
+                                         StripAllMarkedEnchantments(RE::PlayerCharacter::GetSingleton(), menu) != 0 :
+                                         RemoveMarkedItem(menu, request.key, request.signature);
                 if (removed) {
                     RE::PlaySound(kRemoveSuccessSound);
                     RE::DebugNotification(kRemoveSuccessNotification);
@@ -910,88 +1984,79 @@ namespace RFAB::Disenchant
             }
         };
 
+        void AbortRemoveConfirmation()
+        {
+            bool hide = false;
+            {
+                std::scoped_lock lk(g_removeConfirmLock);
+                hide = g_confirmFlow.Abort();
+                g_removeConfirmRequest = {};
+            }
+            if (hide) {
+                QueueMessageBoxForceHide();
+            }
+        }
+
         void ShowRemoveConfirmation(
             RE::CraftingSubMenus::EnchantConstructMenu* a_menu,
             const std::optional<std::uint64_t>& a_key,
-            const std::optional<MarkSignature>& a_signature)
+            const std::optional<MarkSignature>& a_signature,
+            bool a_bulk)
         {
-            if (!a_menu || (!a_key && !a_signature)) {
+            if (!a_menu || (!a_bulk && !a_key && !a_signature)) {
                 return;
             }
 
             {
                 std::scoped_lock lk(g_removeConfirmLock);
-                if (g_removeConfirmOpen.load(std::memory_order_acquire) ||
-                    g_removeConfirmQueued.load(std::memory_order_acquire)) {
-                    return;
-                }
-
-                const auto now = RE::GetDurationOfApplicationRunTime();
-                const auto allowAt = g_nextConfirmAllowedMs.load(std::memory_order_acquire);
-                if (allowAt != 0 && now < allowAt) {
+                if (!g_confirmFlow.TryBegin(GetRunTimeMs())) {
                     return;
                 }
 
-                g_removeConfirmOpen.store(true, std::memory_order_release);
-                g_removeConfirmQueued.store(true, std::memory_order_release);
-                g_removeConfirmRequest = { a_key, a_signature };
-                g_nextConfirmAllowedMs.store(now + kConfirmDebounceMs, std::memory_order_release);
+                g_removeConfirmRequest = { a_key, a_signature, a_bulk };
             }
 
             auto* task = SKSE::GetTaskInterface();
             if (!task) {
-                std::scoped_lock lk(g_removeConfirmLock);
-                g_removeConfirmOpen.store(false, std::memory_order_release);
-                g_removeConfirmQueued.store(false, std::memory_order_release);
-                g_removeConfirmRequest = {};
+                AbortRemoveConfirmation();
                 return;
             }
 
-            task->AddUITask([]() {
+            AddTracedUITask(task, "ShowRemoveConfirmation", []() {
                 bool shouldShow = false;
+                bool bulk = false;
                 {
                     std::scoped_lock lk(g_removeConfirmLock);
-                    shouldShow = g_removeConfirmOpen.load(std::memory_order_acquire) &&
-                                 (g_removeConfirmRequest.key.has_value() || g_removeConfirmRequest.signature.has_value());
+                    bulk = g_removeConfirmRequest.bulk;
+                    shouldShow = g_confirmFlow.IsOpen() &&
+                                 (bulk || g_removeConfirmRequest.key.has_value() || g_removeConfirmRequest.signature.has_value());
                 }
 
                 if (!shouldShow) {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmOpen.store(false, std::memory_order_release);
-                    g_removeConfirmQueued.store(false, std::memory_order_release);
-                    g_removeConfirmRequest = {};
+                    AbortRemoveConfirmation();
                     return;
                 }
 
                 auto* strings = RE::InterfaceStrings::GetSingleton();
                 auto* factory = RE::MessageDataFactoryManager::GetSingleton();
                 if (!strings || !factory) {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmOpen.store(false, std::memory_order_release);
-                    g_removeConfirmQueued.store(false, std::memory_order_release);
-                    g_removeConfirmRequest = {};
+                    AbortRemoveConfirmation();
                     return;
                 }
 
                 const auto* creator = factory->GetCreator<RE::MessageBoxData>(strings->messageBoxData);
                 if (!creator) {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmOpen.store(false, std::memory_order_release);
-                    g_removeConfirmQueued.store(false, std::memory_order_release);
-                    g_removeConfirmRequest = {};
+                    AbortRemoveConfirmation();
                     return;
                 }
 
                 auto* data = creator->Create();
                 if (!data) {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmOpen.store(false, std::memory_order_release);
-                    g_removeConfirmQueued.store(false, std::memory_order_release);
-                    g_removeConfirmRequest = {};
+                    AbortRemoveConfirmation();
                     return;
                 }
 
-                data->bodyText = kRemoveConfirmText;
+                data->bodyText = bulk ? kRemoveAllConfirmText : kRemoveConfirmText;
                 data->buttonText.clear();
                 data->buttonText.push_back(kRemoveConfirmYes);
                 data->buttonText.push_back(kRemoveConfirmNo);
@@ -1004,14 +2069,8 @@ namespace RFAB::Disenchant
                 data->verticalButtons = false;
                 data->isCancellable = true;
 
-                ArmAllowNoDataMessageBox(250);
-                g_messageBoxShowingOurConfirm.store(true, std::memory_order_release);
+                g_confirmFlow.OnQueued(GetRunTimeMs());
                 data->QueueMessage();
-
-                {
-                    std::scoped_lock lk(g_removeConfirmLock);
-                    g_removeConfirmQueued.store(false, std::memory_order_release);
-                }
             });
         }
 
@@ -1027,150 +2086,149 @@ namespace RFAB::Disenchant
                 return true;
             }
 
-            const std::string_view controlName = a_control->data();
-            return controlName == "Accept" || controlName == "accept" || controlName == "Click" ||
-                   controlName == "click" || controlName == "YButton" || controlName == "yButton" ||
-                   controlName == "Activate" || controlName == "activate" || controlName == "Equip" ||
-                   controlName == "equip";
+            return IsLearnControlName(a_control->data());
         }
 
-        void QueueDisenchantPostRemoveRefresh()
+        void FlushMenuRefresh()
         {
-            auto* task = SKSE::GetTaskInterface();
-            if (!task) {
-                SKSE::log::error("QueueDisenchantPostRemoveRefresh: task interface is null");
+            const auto level = g_menuRefresh.Take();
+            StoreStat(g_stats.uiRefreshesCoalesced, g_menuRefresh.Coalesced());
+            if (level == RefreshLevel::kNone) {
                 return;
             }
 
-            task->AddUITask([]() {
+            if (level >= RefreshLevel::kReload) {
                 if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
                     queue->AddMessage(RE::CraftingMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kHide, nullptr);
                     queue->AddMessage(RE::CraftingMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kShow, nullptr);
                     queue->AddMessage(RE::CraftingMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kUpdate, nullptr);
                 }
+            }
 
-                auto* menu = GetActiveEnchantConstructMenu();
-                if (!menu) {
-                    return;
-                }
+            auto* menu = GetActiveEnchantConstructMenu();
+            // Ahead of the list rebuild, while nothing else runs against the rows it frees.
+            if (!menu || level >= RefreshLevel::kList) {
+                RestackPendingInstances();
+            }
+            if (!menu) {
+                return;
+            }
 
-                menu->UpdateConstructibleList();
+            if (level >= RefreshLevel::kList) {
+                RetireRowPrewarm();
+                UpdateMenuList(menu);
+            }
+            if (level >= RefreshLevel::kRows) {
                 DisableStaleDisenchantRows(menu);
                 ForceEnableMarkedDisenchantRows(menu);
-                menu->UpdateInterface();
-            });
-        }
-
-        void ArmForceHideNextMessageBox(std::uint32_t a_durationMs)
-        {
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            const auto until = now + a_durationMs;
-            g_forceHideMessageBoxUntilMs.store(until, std::memory_order_release);
-        }
-
-        void ArmAllowNoDataMessageBox(std::uint32_t a_durationMs)
-        {
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            g_allowNoDataMessageBoxUntilMs.store(now + a_durationMs, std::memory_order_release);
+            }
+            UpdateMenuInterface(menu);
         }
 
-        [[nodiscard]] bool ShouldForceHideMessageBoxNow()
+        // Every menu refresh goes through here. Requests made before the flush task runs collapse
+        // into a single flush at the strongest level asked for, on the next UI frame.
+        void RequestMenuRefresh(RefreshLevel a_level)
         {
-            const auto until = g_forceHideMessageBoxUntilMs.load(std::memory_order_acquire);
-            if (until == 0) {
-                return false;
+            if (!g_menuRefresh.Request(a_level)) {
+                return;
             }
 
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            if (now > until) {
-                g_forceHideMessageBoxUntilMs.store(0, std::memory_order_release);
-                return false;
+            auto* task = SKSE::GetTaskInterface();
+            if (!task) {
+                SKSE::log::error("RequestMenuRefresh: task interface is null");
+                (void)g_menuRefresh.Take();
+                return;
             }
 
-            return true;
+            AddTracedUITask(task, "MenuRefreshFlush", FlushMenuRefresh);
         }
 
-        [[nodiscard]] bool ShouldAllowNoDataMessageBoxNow()
+        // Suppressing hooks can fire several times per frame while a force-hide window is armed;
+        // one queued kForceHide at a time is enough. The owning menu's ProcessMessage hook ends
+        // the gate when the message reaches it; the menu opening or closing ends it too, since
+        // the queue drops messages for a menu that is not open.
+        void QueueForceHide(PendingMessageGate& a_gate, std::string_view a_menuName)
         {
-            const auto until = g_allowNoDataMessageBoxUntilMs.load(std::memory_order_acquire);
-            if (until == 0) {
-                return false;
+            if (!a_gate.TryBegin()) {
+                StoreStat(g_stats.forceHidesSaved, a_gate.Saved());
+                return;
             }
 
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            if (now > until) {
-                g_allowNoDataMessageBoxUntilMs.store(0, std::memory_order_release);
-                return false;
+            StoreStat(g_stats.forceHidesSent, a_gate.Sent());
+            auto* queue = RE::UIMessageQueue::GetSingleton();
+            if (!queue) {
+                a_gate.End();
+                return;
             }
 
-            return true;
+            queue->AddMessage(a_menuName, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
         }
 
-        void ArmSuppressEnchantInput(std::uint32_t a_durationMs)
+        void QueueMessageBoxForceHide()
         {
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            g_suppressEnchantInputUntilMs.store(now + a_durationMs, std::memory_order_release);
+            QueueForceHide(g_messageBoxForceHide, RE::MessageBoxMenu::MENU_NAME);
         }
 
-        [[nodiscard]] bool ShouldSuppressEnchantInputNow()
+        // Our confirmation reached PostCreate: one queue-to-display sample.
+        void NoteMessageBoxCreated()
         {
-            const auto until = g_suppressEnchantInputUntilMs.load(std::memory_order_acquire);
-            if (until == 0) {
-                return false;
+            if (const auto latency = g_confirmFlow.OnMessageBoxCreated(GetRunTimeMs())) {
+                RFAB_LOG_DEBUG(
+                    "Confirmation shown {}ms after queueing; no-data window {}ms, debounce {}ms",
+                    *latency,
+                    g_confirmFlow.AllowNoDataWindow().Current(),
+                    g_confirmFlow.ConfirmDebounceWindow().Current());
             }
+        }
 
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            if (now > until) {
-                g_suppressEnchantInputUntilMs.store(0, std::memory_order_release);
-                return false;
+        // The first message box suppressed after our confirmation closed is one Run-to-hide sample.
+        void NoteMessageBoxSuppressed()
+        {
+            if (const auto latency = g_confirmFlow.OnMessageBoxSuppressed(GetRunTimeMs())) {
+                RFAB_LOG_DEBUG(
+                    "Vanilla prompt hidden {}ms after confirmation; force-hide window {}ms, input {}ms",
+                    *latency,
+                    g_confirmFlow.ForceHideWindow().Current(),
+                    g_confirmFlow.SuppressInputWindow().Current());
             }
-
-            return true;
         }
 
-        void ArmSuppressConfirm(std::uint32_t a_durationMs)
+        [[nodiscard]] bool ShouldSuppressMessageBoxNow()
         {
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            g_suppressConfirmUntilMs.store(now + a_durationMs, std::memory_order_release);
-            g_nextConfirmAllowedMs.store(now + a_durationMs, std::memory_order_release);
+            return g_confirmFlow.ShouldSuppressMessageBox(GetRunTimeMs());
         }
 
-        [[nodiscard]] bool ShouldSuppressConfirmNow()
+        [[nodiscard]] bool ShouldAllowNoDataMessageBoxNow()
         {
-            const auto until = g_suppressConfirmUntilMs.load(std::memory_order_acquire);
-            if (until == 0) {
-                return false;
-            }
+            return g_confirmFlow.ShouldAllowNoData(GetRunTimeMs());
+        }
 
-            const auto now = RE::GetDurationOfApplicationRunTime();
-            if (now > until) {
-                g_suppressConfirmUntilMs.store(0, std::memory_order_release);
-                return false;
-            }
+        [[nodiscard]] bool ShouldSuppressEnchantInputNow()
+        {
+            return g_confirmFlow.ShouldSuppressInput(GetRunTimeMs());
+        }
 
-            return true;
+        [[nodiscard]] bool ShouldSuppressConfirmNow()
+        {
+            return g_suppressConfirm.GetUntil() != 0 && g_suppressConfirm.IsActive(GetRunTimeMs());
         }
 
         void ForceEnableMarkedDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
         {
+            ChromeSpan span("ForceEnableMarkedDisenchantRows", kChromeMenuCategory);
             if (!a_menu || a_menu->currentCategory != RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant) {
                 return;
             }
 
-            for (auto& listEntry : a_menu->listEntries) {
-                auto* itemEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(listEntry.get());
-                if (!itemEntry || !itemEntry->data) {
-                    continue;
-                }
-
-                if (IsEntryMarked(itemEntry->data)) {
-                    itemEntry->enabled = true;
-                }
+            if (!g_markedRowScratch) {
+                g_markedRowScratch.emplace(g_sessionArena.PoolResource());
             }
+            ForceEnableMarkedRows<GameEntryTraits>(g_markStore, a_menu, *g_markedRowScratch);
         }
 
         void DisableStaleDisenchantRows(RE::CraftingSubMenus::EnchantConstructMenu* a_menu)
         {
+            ChromeSpan span("DisableStaleDisenchantRows", kChromeMenuCategory);
             if (!a_menu || a_menu->currentCategory != RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant) {
                 return;
             }
@@ -1203,6 +2261,7 @@ namespace RFAB::Disenchant
 
             std::uint32_t selectedIndex = 0;
             bool found = false;
+            bool changed = false;
             for (std::uint32_t i = 0; i < a_menu->listEntries.size(); ++i) {
                 auto* itemEntry = skyrim_cast<RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry*>(a_menu->listEntries[i].get());
                 if (!itemEntry) {
@@ -1210,6 +2269,7 @@ namespace RFAB::Disenchant
                 }
 
                 const auto isTarget = itemEntry == a_target;
+                changed = changed || itemEntry->selected != isTarget;
                 itemEntry->selected = isTarget;
                 if (isTarget) {
                     selectedIndex = i;
@@ -1218,9 +2278,13 @@ namespace RFAB::Disenchant
             }
 
             if (found) {
+                changed = changed || a_menu->highlightIndex != selectedIndex;
                 a_menu->highlightIndex = selectedIndex;
 
-                a_menu->UpdateInterface();
+                // Clicking the row that is already selected and highlighted redraws nothing.
+                if (changed) {
+                    RequestMenuRefresh(RefreshLevel::kInterface);
+                }
             }
         }
 
@@ -1230,13 +2294,31 @@ namespace RFAB::Disenchant
                 RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry* a_this,
                 RE::GFxValue* a_dataContainer)
             {
+                HookScope scope(HookId::kItemSetData);
+
                 using FilterFlag = RE::CraftingSubMenus::EnchantConstructMenu::FilterFlag;
-                const auto inDisenchantList =
+                RowInput input;
+                input.inDisenchantList =
                     a_this && a_this->filterFlag.any(FilterFlag::DisenchantWeapon, FilterFlag::DisenchantArmor);
-                const auto isMarked = inDisenchantList && a_this && a_this->data && IsEntryMarked(a_this->data);
-                const auto isStaleDisenchantRow =
-                    inDisenchantList && a_this && a_this->data && !EntryHasAnyEnchantment(a_this->data);
+                input.hasData = a_this && a_this->data;
+                std::optional<FirstFrameRowScope> firstFrameRow;
+                if (input.inDisenchantList && input.hasData) {
+                    firstFrameRow.emplace();
+                    if (const auto warm = FindPrewarmedRow(a_this->data)) {
+                        input.marked = warm->marked;
+                        input.hasEnchantment = warm->hasEnchantment;
+                    } else {
+                        input.marked = IsEntryMarked(a_this->data);
+                        input.hasEnchantment = EntryHasAnyEnchantment(a_this->data);
+                    }
+                }
 
+                const auto decoration = DecideRowDecoration(input);
+                scope.SetInput(input);
+                scope.SetDecision(static_cast<std::uint32_t>(decoration));
+
+                const auto isMarked = decoration == RowDecoration::kForceEnabled;
+                const auto isStaleDisenchantRow = decoration == RowDecoration::kForceDisabled;
                 if (isMarked) {
                     a_this->enabled = true;
                 } else if (isStaleDisenchantRow) {
@@ -1272,27 +2354,31 @@ namespace RFAB::Disenchant
         {
             static void Activate_Thunk(RE::CraftingSubMenus::EnchantConstructMenu::ItemChangeEntry* a_this)
             {
+                HookScope scope(HookId::kItemActivate);
                 auto* menu = GetActiveEnchantConstructMenu();
-                const auto inDisenchant =
-                    menu && menu->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant;
 
-                if (inDisenchant && ShouldSuppressEnchantInputNow()) {
-                    return;
-                }
-                const auto hasEnchant = a_this && a_this->data && EntryHasAnyEnchantment(a_this->data);
-                std::optional<std::uint64_t> markedKey;
-                std::optional<MarkSignature> markedSignature;
-                const auto isMarked =
-                    inDisenchant && a_this && a_this->data && IsEntryMarked(a_this->data, &markedKey, &markedSignature);
-
-                if (inDisenchant && !hasEnchant) {
+                ActivateInput input;
+                input.inDisenchant =
+                    menu && menu->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant;
+                input.suppressInput = input.inDisenchant && ShouldSuppressEnchantInputNow();
+                if (input.inDisenchant && !input.suppressInput && a_this && a_this->data) {
+                    input.hasEnchantment = EntryHasAnyEnchantment(a_this->data);
+                    input.marked = input.hasEnchantment && IsEntryMarked(a_this->data);
+                }
+
+                const auto decision = DecideActivate(input);
+                scope.SetInput(input);
+                scope.SetDecision(static_cast<std::uint32_t>(decision));
+                RFAB_LOG_TRACE("ItemChangeEntry::Activate: marked={} decision={}", input.marked, static_cast<int>(decision));
+                switch (decision) {
+                case ActivateDecision::kIgnore:
                     return;
-                }
-
-                if (inDisenchant && isMarked) {
+                case ActivateDecision::kSelectMarked:
                     SelectDisenchantEntryWithoutAction(menu, a_this);
                     ForceEnableMarkedDisenchantRows(menu);
                     return;
+                case ActivateDecision::kPassThrough:
+                    break;
                 }
 
                 Activate_Original(a_this);
@@ -1311,7 +2397,11 @@ namespace RFAB::Disenchant
         {
             static RE::UI_MESSAGE_RESULTS ProcessMessage_Thunk(RE::MessageBoxMenu* a_this, RE::UIMessage& a_message)
             {
+                HookScope scope(HookId::kMessageBoxProcessMessage);
                 const auto type = a_message.type.get();
+                if (type == RE::UI_MESSAGE_TYPE::kForceHide) {
+                    g_messageBoxForceHide.End();
+                }
                 const auto showLike =
                     type == RE::UI_MESSAGE_TYPE::kShow ||
                     type == RE::UI_MESSAGE_TYPE::kReshow ||
@@ -1331,45 +2421,35 @@ namespace RFAB::Disenchant
                     allowThis =
                         (callbackVTable != 0 && callbackVTable == kRemoveConfirmCallbackVTable) ||
                         (body && std::strcmp(body, kRemoveConfirmText) == 0);
-                    if (allowThis) {
-                        g_allowNoDataMessageBoxUntilMs.store(0, std::memory_order_release);
-                        g_messageBoxShowingOurConfirm.store(true, std::memory_order_release);
-                    } else {
-                        g_messageBoxShowingOurConfirm.store(false, std::memory_order_release);
-                    }
                 }
 
+                MessageBoxInput input;
+                input.showLike = showLike;
+                input.hasData = a_message.data != nullptr;
+                input.isOurConfirm = allowThis;
                 if (showLike && !allowThis) {
-                    bool suppressNow =
-                        g_removeConfirmOpen.load(std::memory_order_acquire) ||
-                        g_removeConfirmQueued.load(std::memory_order_acquire) ||
-                        ShouldForceHideMessageBoxNow();
-                    if (!suppressNow) {
+                    input.suppress = ShouldSuppressMessageBoxNow();
+                    if (!input.suppress) {
                         auto* menu = GetActiveEnchantConstructMenu();
-                        suppressNow = menu && menu->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant &&
-                                      ShouldSuppressVanillaDisenchantPrompt(menu);
+                        input.suppress = menu && menu->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant &&
+                                         ShouldSuppressVanillaDisenchantPrompt(menu);
                     }
+                    input.allowNoData = !input.hasData && ShouldAllowNoDataMessageBoxNow();
+                }
 
-                    if (!a_message.data) {
-                        if (ShouldAllowNoDataMessageBoxNow()) {
-                            return ProcessMessage_Original(a_this, a_message);
-                        }
-                        if (suppressNow) {
-                            if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
-                                queue->AddMessage(RE::MessageBoxMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
-                            }
-                            return RE::UI_MESSAGE_RESULTS::kIgnore;
-                        }
-                        return ProcessMessage_Original(a_this, a_message);
+                const auto forceHide = ShouldForceHideMessageBoxMessage(input);
+                scope.SetInput(input);
+                scope.SetDecision(forceHide ? 1u : 0u);
+                if (forceHide) {
+                    NoteMessageBoxSuppressed();
+                    if (!g_confirmFlow.IsOpen()) {
+                        QueueMessageBoxForceHide();
                     }
+                    return RE::UI_MESSAGE_RESULTS::kIgnore;
+                }
 
-                    if (suppressNow) {
-                        if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
-                            queue->AddMessage(RE::MessageBoxMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
-                        }
-                        g_messageBoxShowingOurConfirm.store(false, std::memory_order_release);
-                        return RE::UI_MESSAGE_RESULTS::kIgnore;
-                    }
+                if (showLike && input.hasData) {
+                    g_confirmFlow.OnMessageBoxData(allowThis);
                 }
 
                 return ProcessMessage_Original(a_this, a_message);
@@ -1388,18 +2468,15 @@ namespace RFAB::Disenchant
         {
             static void PreDisplay_Thunk(RE::MessageBoxMenu* a_this)
             {
-                const bool suppressNow =
-                    (g_removeConfirmOpen.load(std::memory_order_acquire) ||
-                     g_removeConfirmQueued.load(std::memory_order_acquire) ||
-                     ShouldForceHideMessageBoxNow());
-
-                const bool allowNow =
-                    g_messageBoxShowingOurConfirm.load(std::memory_order_acquire) ||
-                    ShouldAllowNoDataMessageBoxNow();
-                if (suppressNow && !allowNow) {
-                    if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
-                        queue->AddMessage(RE::MessageBoxMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
-                    }
+                HookScope scope(HookId::kMessageBoxPreDisplay);
+                const bool suppressNow = ShouldSuppressMessageBoxNow();
+                const bool allowNow = g_confirmFlow.IsShowingOurs() || ShouldAllowNoDataMessageBoxNow();
+                const auto forceHide = ShouldForceHideMessageBoxDisplay(suppressNow, allowNow);
+                scope.SetDisplayInput(suppressNow, allowNow);
+                scope.SetDecision(forceHide ? 1u : 0u);
+                if (forceHide) {
+                    NoteMessageBoxSuppressed();
+                    QueueMessageBoxForceHide();
                     return;
                 }
 
@@ -1419,21 +2496,19 @@ namespace RFAB::Disenchant
         {
             static void PostCreate_Thunk(RE::MessageBoxMenu* a_this)
             {
-                const bool suppressNow =
-                    (g_removeConfirmOpen.load(std::memory_order_acquire) ||
-                     g_removeConfirmQueued.load(std::memory_order_acquire) ||
-                     ShouldForceHideMessageBoxNow());
-
-                const bool allowNow =
-                    g_messageBoxShowingOurConfirm.load(std::memory_order_acquire) ||
-                    ShouldAllowNoDataMessageBoxNow();
-                if (suppressNow && !allowNow) {
-                    if (auto* queue = RE::UIMessageQueue::GetSingleton()) {
-                        queue->AddMessage(RE::MessageBoxMenu::MENU_NAME, RE::UI_MESSAGE_TYPE::kForceHide, nullptr);
-                    }
+                HookScope scope(HookId::kMessageBoxPostCreate);
+                const bool suppressNow = ShouldSuppressMessageBoxNow();
+                const bool allowNow = g_confirmFlow.IsShowingOurs() || ShouldAllowNoDataMessageBoxNow();
+                const auto forceHide = ShouldForceHideMessageBoxDisplay(suppressNow, allowNow);
+                scope.SetDisplayInput(suppressNow, allowNow);
+                scope.SetDecision(forceHide ? 1u : 0u);
+                if (forceHide) {
+                    NoteMessageBoxSuppressed();
+                    QueueMessageBoxForceHide();
                     return;
                 }
 
+                NoteMessageBoxCreated();
                 PostCreate_Original(a_this);
             }
 
@@ -1450,86 +2525,70 @@ namespace RFAB::Disenchant
         {
             static bool ProcessUserEvent_Thunk(RE::CraftingSubMenus::EnchantConstructMenu* a_this, RE::BSFixedString* a_control)
             {
+                HookScope scope(HookId::kProcessUserEvent);
                 const auto* controlName = (a_control && a_control->data()) ? a_control->data() : nullptr;
-                const auto inDisenchantCategory =
-                    a_this && a_this->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant;
-                const auto isLearn = IsLearnControl(a_control);
-                const auto physicalLMBPressed = (::GetAsyncKeyState(VK_LBUTTON) & 0x8000) != 0;
+                scope.SetControl(controlName);
 
-                if (inDisenchantCategory && ShouldSuppressEnchantInputNow() && isLearn) {
-                    return true;
+                UserEventInput input;
+                input.inDisenchant =
+                    a_this && a_this->currentCategory == RE::CraftingSubMenus::EnchantConstructMenu::Category::Disenchant;
+                input.isLearn = IsLearnControl(a_control);
+                input.suppressInput = input.inDisenchant && ShouldSuppressEnchantInputNow();
+                if (!input.inDisenchant || (input.suppressInput && input.isLearn)) {
+                    const auto decision = DecideUserEvent(input);
+                    scope.SetInput(input);
+                    scope.SetDecision(PackTraceDecision(decision));
+                    return decision.consume || g_processUserEventOriginal(a_this, a_control);
                 }
 
-                auto* selectionEntry = inDisenchantCategory ? ResolveDisenchantSelection(a_this) : nullptr;
-
-                auto* selectedItemEntry = (a_this && a_this->selected.item) ? a_this->selected.item.get() : nullptr;
+                auto* selectionEntry = ResolveDisenchantSelection(a_this);
                 auto* highlightedItemEntry = GetHighlightedItemEntry(a_this);
-                RE::InventoryEntryData* selectedEntryData = (selectedItemEntry && selectedItemEntry->data) ? selectedItemEntry->data : nullptr;
-                RE::InventoryEntryData* highlightedEntryData =
-                    (highlightedItemEntry && highlightedItemEntry->data) ? highlightedItemEntry->data : nullptr;
+                auto* selectedEntryData = GameEntryTraits::SelectedData(a_this);
+                auto* highlightedEntryData = highlightedItemEntry ? highlightedItemEntry->data : nullptr;
 
                 std::optional<std::uint64_t> actionMarkedKey;
                 std::optional<MarkSignature> actionMarkedSignature;
-                if (inDisenchantCategory) {
-                    if (highlightedEntryData && IsEntryMarked(highlightedEntryData, &actionMarkedKey, &actionMarkedSignature)) {} 
-                    else if (selectedEntryData && IsEntryMarked(selectedEntryData, &actionMarkedKey, &actionMarkedSignature)) {} 
-                    else if (selectionEntry) {
-                        (void)IsEntryMarked(selectionEntry, &actionMarkedKey, &actionMarkedSignature);
+                auto markTarget = [&](RE::InventoryEntryData* a_entry, TargetState& a_state) {
+                    a_state.present = a_entry != nullptr;
+                    a_state.hasEnchantment = a_entry && EntryHasAnyEnchantment(a_entry);
+                    if (a_entry && !input.targets.AnyMarked()) {
+                        (void)IsEntryMarked(a_entry, &actionMarkedKey, &actionMarkedSignature);
+                        a_state.marked = actionMarkedKey || actionMarkedSignature;
                     }
-                }
-
-                if (inDisenchantCategory && (actionMarkedKey || actionMarkedSignature)) {
+                };
+                markTarget(highlightedEntryData, input.targets.highlighted);
+                markTarget(selectedEntryData, input.targets.selected);
+                markTarget(selectionEntry, input.targets.resolved);
+
+                input.highlightedRow = highlightedItemEntry != nullptr;
+                input.isMouseSelect = controlName && IsMouseSelectControlName(controlName);
+                input.physicalLMB = (::GetAsyncKeyState(VK_LBUTTON) & 0x8000) != 0;
+                input.suppressConfirm = input.targets.AnyMarked() && ShouldSuppressConfirmNow();
+
+                const auto decision = DecideUserEvent(input);
+                scope.SetInput(input);
+                scope.SetDecision(PackTraceDecision(decision));
+                RFAB_LOG_TRACE(
+                    "ProcessUserEvent '{}': marked={} forceEnable={} select={} confirm={} consume={}",
+                    controlName ? controlName : "",
+                    input.targets.AnyMarked(),
+                    decision.forceEnableMarkedRows,
+                    decision.selectHighlighted,
+                    decision.showConfirm,
+                    decision.consume);
+                if (decision.forceEnableMarkedRows) {
                     ForceEnableMarkedDisenchantRows(a_this);
                 }
-
-                if (inDisenchantCategory && (actionMarkedKey || actionMarkedSignature)) {
-                    if (isLearn) {
-                        return true;
-                    }
+                if (decision.selectHighlighted) {
+                    SelectDisenchantEntryWithoutAction(a_this, highlightedItemEntry);
                 }
-
-                if (inDisenchantCategory && (actionMarkedKey || actionMarkedSignature)) {
-                    const auto mouseSelectLikeControl =
-                        (controlName && (_stricmp(controlName, "RightEquip") == 0 || _stricmp(controlName, "LeftEquip") == 0));
-                    if (physicalLMBPressed || mouseSelectLikeControl) {
-                        if (highlightedItemEntry && highlightedItemEntry->data &&
-                            !EntryHasAnyEnchantment(highlightedItemEntry->data)) {
-                            return true;
-                        }
-                        if (highlightedItemEntry) {
-                            SelectDisenchantEntryWithoutAction(a_this, highlightedItemEntry);
-                        }
-                        if (!ShouldSuppressConfirmNow()) {
-                            ShowRemoveConfirmation(a_this, actionMarkedKey, actionMarkedSignature);
-                        }
-                        return true;
-                    }
+                if (decision.showConfirm) {
+                    ShowRemoveConfirmation(a_this, actionMarkedKey, actionMarkedSignature);
                 }
-
-                if (inDisenchantCategory && controlName &&
-                    (_stricmp(controlName, "RightEquip") == 0 || _stricmp(controlName, "LeftEquip") == 0)) {
-                    if (highlightedItemEntry && highlightedItemEntry->data &&
-                        !EntryHasAnyEnchantment(highlightedItemEntry->data)) {
-                        return true;
-                    }
-                    if (highlightedItemEntry) {
-                        SelectDisenchantEntryWithoutAction(a_this, highlightedItemEntry);
-                    }
+                if (decision.consume) {
                     return true;
                 }
 
-                if (inDisenchantCategory && isLearn && !(actionMarkedKey || actionMarkedSignature)) {
-                    const auto hasVisibleTarget =
-                        (highlightedEntryData != nullptr) || (selectedEntryData != nullptr) || (selectionEntry != nullptr);
-                    const auto activeTargetHasEnchantment =
-                        highlightedEntryData ? EntryHasAnyEnchantment(highlightedEntryData) :
-                        (selectedEntryData ? EntryHasAnyEnchantment(selectedEntryData) :
-                                             (selectionEntry && EntryHasAnyEnchantment(selectionEntry)));
-                    if (hasVisibleTarget && !activeTargetHasEnchantment) {
-                        return true;
-                    }
-                }
-
                 return g_processUserEventOriginal(a_this, a_control);
             }
 
@@ -1544,10 +2603,13 @@ namespace RFAB::Disenchant
         {
             static void Run_Thunk(RE::CraftingSubMenus::EnchantConstructMenu::EnchantMenuCraftCallback* a_this, RE::IMessageBoxCallback::Message a_msg)
             {
+                HookScope scope(HookId::kCraftRun);
                 auto keyToMark = (a_this && a_this->subMenu) ? GetSelectedEntryMarkKey(a_this->subMenu) : std::nullopt;
                 auto signatureToMark = (a_this && a_this->subMenu) ? GetSelectedEntryMarkSignature(a_this->subMenu) : std::nullopt;
 
                 Run_Original(a_this, a_msg);
+                // The enchanted entry's row state just changed without a container event.
+                RetireRowPrewarm();
 
                 if (!keyToMark && a_this && a_this->subMenu) {
                     keyToMark = GetSelectedEntryMarkKey(a_this->subMenu);
@@ -1559,9 +2621,19 @@ namespace RFAB::Disenchant
 
                 if (keyToMark && ItemHasExtraEnchantment(*keyToMark)) {
                     MarkItem(*keyToMark);
+                    return;
+                }
+
+                if (!signatureToMark) {
+                    return;
                 }
 
-                if (signatureToMark && ItemHasExtraEnchantment(*signatureToMark)) {
+                // The new instance has no ExtraUniqueID yet; give it one so the mark is a precise key.
+                // Only an instance that could not be keyed falls back to a signature mark.
+                std::size_t matched = 0;
+                const auto keys = AssignUniqueIDs(RE::PlayerCharacter::GetSingleton(), { &*signatureToMark, 1 }, &matched);
+                MarkItems(keys);
+                if (keys.empty() && matched != 0) {
                     MarkItem(*signatureToMark);
                 }
             }
@@ -1579,25 +2651,24 @@ namespace RFAB::Disenchant
         {
             static void Run_Thunk(RE::CraftingSubMenus::EnchantConstructMenu::EnchantMenuDisenchantCallback* a_this, RE::IMessageBoxCallback::Message a_msg)
             {
+                HookScope scope(HookId::kDisenchantRun);
                 auto* subMenu = a_this ? a_this->subMenu : nullptr;
                 auto* selectionEntry = subMenu ? ResolveDisenchantSelection(subMenu) : nullptr;
-                const auto keyBefore = selectionEntry ? FindMarkedKeyInEntry(selectionEntry) : std::nullopt;
-                const auto signatureBefore = selectionEntry ? GetEntryMarkSignature(selectionEntry) : std::nullopt;
+                std::optional<std::uint64_t> keyBefore;
+                std::optional<MarkSignature> signatureBefore;
+                if (selectionEntry) {
+                    (void)IsEntryMarked(selectionEntry, &keyBefore, &signatureBefore);
+                }
 
-                auto* selectedItemEntry = (subMenu && subMenu->selected.item) ? subMenu->selected.item.get() : nullptr;
                 auto* highlightedItemEntry = subMenu ? GetHighlightedItemEntry(subMenu) : nullptr;
-                auto* selectedEntryData = (selectedItemEntry && selectedItemEntry->data) ? selectedItemEntry->data : nullptr;
-                auto* highlightedEntryData = (highlightedItemEntry && highlightedItemEntry->data) ? highlightedItemEntry->data : nullptr;
 
-                const auto isMarked = selectionEntry && IsEntryMarked(selectionEntry);
-                const auto selectedMarked = selectedEntryData && IsEntryMarked(selectedEntryData);
-                const auto highlightedMarked = highlightedEntryData && IsEntryMarked(highlightedEntryData);
-
-                const auto staleSelectionNoEnchant =
-                    (selectionEntry && !EntryHasAnyEnchantment(selectionEntry)) ||
-                    (selectedEntryData && !EntryHasAnyEnchantment(selectedEntryData)) ||
-                    (highlightedEntryData && !EntryHasAnyEnchantment(highlightedEntryData));
-                const auto shouldBlockVanilla = isMarked || selectedMarked || highlightedMarked || staleSelectionNoEnchant;
+                SelectionTargets targets;
+                targets.resolved = MakeTargetState(selectionEntry);
+                targets.selected = MakeTargetState(subMenu ? GameEntryTraits::SelectedData(subMenu) : nullptr);
+                targets.highlighted = MakeTargetState(highlightedItemEntry ? highlightedItemEntry->data : nullptr);
+                const auto shouldBlockVanilla = ShouldBlockVanillaDisenchant(targets);
+                scope.SetInput(targets);
+                scope.SetDecision(shouldBlockVanilla ? 1u : 0u);
 
                 if (shouldBlockVanilla) {
                     return;
@@ -1605,14 +2676,21 @@ namespace RFAB::Disenchant
 
                 Run_Original(a_this, a_msg);
 
+                std::optional<std::uint64_t> unmarkKey;
+                std::optional<MarkSignature> unmarkSignature;
                 if (keyBefore && IsMarked(*keyBefore) &&
                     (!ItemExistsInPlayerInventory(*keyBefore) || !ItemHasExtraEnchantment(*keyBefore))) {
-                    UnmarkItem(*keyBefore);
+                    unmarkKey = keyBefore;
                 }
-
+                // A signature mark goes with the last carried instance of its pair.
                 if (signatureBefore && IsMarked(*signatureBefore) &&
-                    (!ItemExistsInPlayerInventory(*signatureBefore) || !ItemHasExtraEnchantment(*signatureBefore))) {
-                    UnmarkItem(*signatureBefore);
+                    !ContainerHoldsSignature(RE::PlayerCharacter::GetSingleton(), *signatureBefore)) {
+                    unmarkSignature = signatureBefore;
+                }
+                if (unmarkKey || unmarkSignature) {
+                    UnmarkItems(
+                        unmarkKey ? std::span<const std::uint64_t>(&*unmarkKey, 1) : std::span<const std::uint64_t>{},
+                        unmarkSignature ? std::span<const MarkSignature>(&*unmarkSignature, 1) : std::span<const MarkSignature>{});
                 }
             }
 
@@ -1625,110 +2703,539 @@ namespace RFAB::Disenchant
             static inline REL::Relocation<decltype(Run_Thunk)> Run_Original;
         };
 
+        class SerializationRecordWriter final : public RecordWriter
+        {
+        public:
+            explicit SerializationRecordWriter(SKSE::SerializationInterface* a_serialization) :
+                _serialization(a_serialization)
+            {}
+
+            [[nodiscard]] bool WriteBytes(const void* a_data, std::uint32_t a_size) override
+            {
+                return _serialization->WriteRecordData(a_data, a_size);
+            }
+
+        private:
+            SKSE::SerializationInterface* _serialization;
+        };
+
+        class SerializationRecordReader final : public RecordReader
+        {
+        public:
+            explicit SerializationRecordReader(SKSE::SerializationInterface* a_serialization) :
+                _serialization(a_serialization)
+            {}
+
+            [[nodiscard]] bool ReadBytes(void* a_data, std::uint32_t a_size) override
+            {
+                return _serialization->ReadRecordData(a_data, a_size) == a_size;
+            }
+
+        private:
+            SKSE::SerializationInterface* _serialization;
+        };
+
+        void LogCodecError(const CodecResult& a_result, bool a_write)
+        {
+            const auto* verb = a_write ? "write" : "read";
+            switch (a_result.error) {
+            case CodecError::kNone:
+                break;
+            case CodecError::kKeyCount:
+                SKSE::log::error("Failed to {} marked item count", verb);
+                break;
+            case CodecError::kKey:
+                if (a_write) {
+                    SKSE::log::error("Failed to write marked key {:016X}", a_result.value);
+                } else {
+                    SKSE::log::error("Failed to read marked item key #{}", a_result.index);
+                }
+                break;
+            case CodecError::kContainerCount:
+                SKSE::log::error("Failed to {} marked container count", verb);
+                break;
+            case CodecError::kContainer:
+                if (a_write) {
+                    SKSE::log::error("Failed to write marked container for base {:08X}", a_result.value);
+                } else {
+                    SKSE::log::error("Failed to read marked container #{}", a_result.index);
+                }
+                break;
+            case CodecError::kSignatureCount:
+                SKSE::log::error("Failed to {} marked signature count", verb);
+                break;
+            case CodecError::kSignature:
+                if (a_write) {
+                    const auto signature = static_cast<MarkSignature>(a_result.value);
+                    SKSE::log::error(
+                        "Failed to write marked signature {:08X}:{:08X}",
+                        GetSignatureObjectFormID(signature),
+                        GetSignatureEnchantmentFormID(signature));
+                } else {
+                    SKSE::log::error("Failed to read marked signature #{}", a_result.index);
+                }
+                break;
+            case CodecError::kJournalLink:
+                SKSE::log::error("Failed to {} mark journal token", verb);
+                break;
+            case CodecError::kLocationCount:
+                SKSE::log::error("Failed to {} mark location count", verb);
+                break;
+            case CodecError::kLocation:
+                if (a_write) {
+                    SKSE::log::error("Failed to write mark location for {:016X}", a_result.value);
+                } else {
+                    SKSE::log::error("Failed to read mark location #{}", a_result.index);
+                }
+                break;
+            }
+        }
+
+        void SaveMarkLocations(SKSE::SerializationInterface* a_serialization)
+        {
+            (void)g_markLocations.Prune(g_markStore);
+            if (!a_serialization->OpenRecord(kLocationRecordType, kLocationRecordVersion)) {
+                SKSE::log::error("Failed to open mark location record");
+                return;
+            }
+
+            SerializationRecordWriter writer(a_serialization);
+            if (const auto result = WriteLocationRecord(writer, g_markLocations.Entries()); !result) {
+                LogCodecError(result, true);
+            }
+        }
+
         void SaveCallback(SKSE::SerializationInterface* a_serialization)
         {
-            std::scoped_lock lk(g_markedItemsLock);
+            ChromeSpan span("SaveCallback", kChromeCoSaveCategory);
             if (!a_serialization->OpenRecord(kSerializationRecordType, kSerializationVersion)) {
                 SKSE::log::error("Failed to open serialization record");
                 return;
             }
 
-            const auto count = static_cast<std::uint32_t>(g_markedItems.size());
-            if (!a_serialization->WriteRecordData(count)) {
-                SKSE::log::error("Failed to write marked item count");
+            if (Settings::GetSingleton().journalEnabled && g_markJournalID == 0) {
+                g_markJournalID = GenerateJournalToken();
+            }
+
+            const JournalLink link{ g_markJournalID, GenerateJournalToken() };
+            SerializationRecordWriter writer(a_serialization);
+            const auto result = g_markStore.Visit([&](const MarkSet& a_marks) {
+                return WriteMarkRecord(writer, a_marks, link);
+            });
+            if (!result) {
+                LogCodecError(result, true);
                 return;
             }
 
-            for (const auto key : g_markedItems) {
-                if (!a_serialization->WriteRecordData(key)) {
-                    SKSE::log::error("Failed to write marked key {:016X}", key);
-                    return;
-                }
+            // The co-save now holds the full set; compact the journal down to nothing.
+            g_markJournalBaseToken = link.baseToken;
+            EnsureMarkJournalAttached();
+            if (g_markStore.HasJournal()) {
+                (void)g_markStore.CompactJournal(link.baseToken);
+            }
+
+            SaveMarkLocations(a_serialization);
+
+            if (g_hookInstrumentation.load(std::memory_order_relaxed) & kInstrumentTrace) {
+                g_trace.Flush();
             }
+        }
 
-            const auto signatureCount = static_cast<std::uint32_t>(g_markedSignatures.size());
-            if (!a_serialization->WriteRecordData(signatureCount)) {
-                SKSE::log::error("Failed to write marked signature count");
+        void LoadMarkRecord(SKSE::SerializationInterface* a_serialization, std::uint32_t a_version)
+        {
+            MarkSet marks;
+            JournalLink link;
+            SerializationRecordReader reader(a_serialization);
+            const auto result = ReadMarkRecord(reader, a_version, marks, link);
+            g_markStore.Replace(std::move(marks));
+            PublishMarkCounts();
+            if (!result) {
+                LogCodecError(result, false);
                 return;
             }
 
-            for (const auto& signature : g_markedSignatures) {
-                const auto raw = static_cast<std::uint64_t>(signature);
-                const auto objectFormID = static_cast<std::uint32_t>(raw >> 32u);
-                const auto enchantmentFormID = static_cast<std::uint32_t>(raw & 0xFFFFFFFFu);
-                if (!a_serialization->WriteRecordData(objectFormID) ||
-                    !a_serialization->WriteRecordData(enchantmentFormID)) {
-                    SKSE::log::error("Failed to write marked signature {:08X}:{:08X}", objectFormID, enchantmentFormID);
-                    return;
+            g_markJournalID = link.journalID;
+            g_markJournalBaseToken = link.baseToken;
+            if (g_markJournalID == 0 || !Settings::GetSingleton().journalEnabled) {
+                return;
+            }
+
+            // Only replay a journal written on top of exactly this save; one left by a
+            // newer save or another branch of the character is stale and gets reset. Replayed
+            // ops now live in the store and are gone from the journal, so reloading this save
+            // again does not bring them back.
+            const auto path = GetMarkJournalPath(g_markJournalID);
+            std::size_t replayed = 0;
+            if (!g_markStore.AttachJournal(path, g_markJournalBaseToken, &replayed)) {
+                SKSE::log::error("Failed to open mark journal {}", path.string());
+                return;
+            }
+
+            if (replayed != 0) {
+                PublishMarkCounts();
+                SKSE::log::info("Replayed {} mark journal ops", replayed);
+            }
+        }
+
+        // Owners are references, so their FormIDs go through the load-order remap; entries whose
+        // owner no longer exists are dropped and left to the scans.
+        void LoadMarkLocations(SKSE::SerializationInterface* a_serialization, std::uint32_t a_version, std::uint32_t a_length)
+        {
+            std::vector<MarkLocationRecord> records;
+            SerializationRecordReader reader(a_serialization);
+            if (const auto result = ReadLocationRecord(reader, a_version, a_length, records); !result) {
+                LogCodecError(result, false);
+                return;
+            }
+
+            std::vector<MarkLocationIndex::Entry> entries;
+            entries.reserve(records.size());
+            for (const auto& record : records) {
+                RE::FormID owner = 0;
+                if (a_serialization->ResolveFormID(record.ownerFormID, owner)) {
+                    entries.push_back({ record.key, { owner, record.kind } });
                 }
             }
+
+            g_markLocations.Replace(entries);
+            if (entries.size() != records.size()) {
+                SKSE::log::info("Dropped {} mark location(s) with unresolved owners", records.size() - entries.size());
+            }
+        }
+
+        // The worker of the last load validation. Joined before the marks it looked at go away,
+        // so it never outlives the load (or the plugin) it was started for.
+        std::jthread g_markValidationThread;
+
+        void StopMarkValidation()
+        {
+            if (g_markValidationThread.joinable()) {
+                g_markValidationThread.request_stop();
+                g_markValidationThread.join();
+            }
         }
 
         void LoadCallback(SKSE::SerializationInterface* a_serialization)
         {
+            ChromeSpan span("LoadCallback", kChromeCoSaveCategory);
             std::uint32_t type = 0;
             std::uint32_t version = 0;
             std::uint32_t length = 0;
 
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedItems.clear();
-            g_markedSignatures.clear();
+            ++g_markValidationTicket;
+            StopMarkValidation();
+            DropPendingRestacks();
+            g_markStore.DetachJournal();
+            g_markStore.Clear();
+            g_markLocations.Clear();
+            g_markJournalID = 0;
+            g_markJournalBaseToken = 0;
 
+            bool marksLoaded = false;
             while (a_serialization->GetNextRecordInfo(type, version, length)) {
-                if (type != kSerializationRecordType || (version != 1 && version != kSerializationVersion)) {
-                    continue;
+                if (type == kSerializationRecordType && !marksLoaded && version >= 1 && version <= kSerializationVersion) {
+                    LoadMarkRecord(a_serialization, version);
+                    marksLoaded = true;
+                } else if (type == kLocationRecordType && version >= 1 && version <= kLocationRecordVersion) {
+                    LoadMarkLocations(a_serialization, version, length);
                 }
+            }
 
-                std::uint32_t count = 0;
-                if (!a_serialization->ReadRecordData(count)) {
-                    SKSE::log::error("Failed to read marked item count");
-                    return;
-                }
+            // Journal replay may have unmarked keys the saved index still places.
+            (void)g_markLocations.Prune(g_markStore);
+        }
 
-                for (std::uint32_t i = 0; i < count; ++i) {
-                    std::uint64_t key = 0;
-                    if (!a_serialization->ReadRecordData(key)) {
-                        SKSE::log::error("Failed to read marked item key #{}", i);
-                        return;
-                    }
+        void RevertCallback(SKSE::SerializationInterface*)
+        {
+            ChromeSpan span("RevertCallback", kChromeCoSaveCategory);
+            ++g_markValidationTicket;
+            StopMarkValidation();
+            DropPendingRestacks();
+            g_markStore.DetachJournal();
+            g_markStore.Clear();
+            g_markLocations.Clear();
+            PublishMarkCounts();
+            g_markJournalID = 0;
+            g_markJournalBaseToken = 0;
+        }
+
+        // One pass on the game thread over everything validation reads: the marks and their
+        // index, the unique keys and signatures the player holds, and which of the FormIDs all
+        // of those refer to still resolve.
+        [[nodiscard]] MarkValidationSnapshot CaptureMarkValidationSnapshot(RE::PlayerCharacter* a_player)
+        {
+            ChromeSpan span("CaptureMarkValidationSnapshot", kChromeScanCategory);
+            MarkValidationSnapshot snapshot;
+            snapshot.playerFormID = kPlayerFormID;
+            g_markStore.Visit([&](const MarkSet& a_marks) {
+                snapshot.marks.reserve(a_marks.keys.Size());
+                a_marks.keys.ForEach([&](std::uint64_t a_key) { snapshot.marks.push_back(a_key); });
+                snapshot.signatures.assign(a_marks.signatures.begin(), a_marks.signatures.end());
+                snapshot.generation = g_markStore.Generation();
+            });
+            snapshot.locations = g_markLocations.Entries();
 
-                    g_markedItems.insert(key);
+            for (const auto& item : GetPlayerInventory(a_player)) {
+                auto* entry = GetInventoryEntry(item);
+                GameEntryTraits::ForEachUniqueKey(entry, [&](std::uint64_t a_key) {
+                    snapshot.heldKeys.push_back(a_key);
+                    return false;
+                });
+                if (const auto signature = GetEntryMarkSignature(entry)) {
+                    snapshot.heldSignatures.push_back(*signature);
                 }
+            }
+            std::sort(snapshot.heldKeys.begin(), snapshot.heldKeys.end());
+            std::sort(snapshot.heldSignatures.begin(), snapshot.heldSignatures.end());
 
-                if (version >= 2) {
-                    std::uint32_t signatureCount = 0;
-                    if (!a_serialization->ReadRecordData(signatureCount)) {
-                        SKSE::log::error("Failed to read marked signature count");
-                        return;
-                    }
+            // Keys come grouped by base, so the distinct FormIDs are few next to the marks.
+            std::vector<std::uint32_t> referenced;
+            for (const auto key : snapshot.marks) {
+                const auto base = static_cast<std::uint32_t>(key >> 16u);
+                if (referenced.empty() || referenced.back() != base) {
+                    referenced.push_back(base);
+                }
+            }
+            for (const auto& entry : snapshot.locations) {
+                referenced.push_back(entry.location.ownerFormID);
+            }
+            for (const auto signature : snapshot.signatures) {
+                referenced.push_back(GetSignatureObjectFormID(signature));
+                referenced.push_back(GetSignatureEnchantmentFormID(signature));
+            }
+            std::sort(referenced.begin(), referenced.end());
+            referenced.erase(std::unique(referenced.begin(), referenced.end()), referenced.end());
+            for (const auto formID : referenced) {
+                if (RE::TESForm::LookupByID(formID)) {
+                    snapshot.resolvedForms.push_back(formID);
+                }
+            }
+            return snapshot;
+        }
 
-                    for (std::uint32_t i = 0; i < signatureCount; ++i) {
-                        std::uint32_t objectFormID = 0;
-                        std::uint32_t enchantmentFormID = 0;
-                        if (!a_serialization->ReadRecordData(objectFormID) ||
-                            !a_serialization->ReadRecordData(enchantmentFormID)) {
-                            SKSE::log::error("Failed to read marked signature #{}", i);
-                            return;
-                        }
+        struct MarkValidationTimings
+        {
+            double captureMs{ 0 };
+            double validateMs{ 0 };
+        };
 
-                        g_markedSignatures.insert(MakeMarkSignature(objectFormID, enchantmentFormID));
-                    }
+        // Runs on the game thread. Results computed against a snapshot that no longer matches
+        // the store (another load, or a mark changed meanwhile) are thrown away whole.
+        void ApplyMarkValidation(
+            std::uint64_t a_ticket,
+            const MarkValidationSnapshot& a_snapshot,
+            const MarkValidationResult& a_result,
+            MarkValidationTimings a_timings)
+        {
+            if (a_ticket != g_markValidationTicket.load() || a_result.stopped) {
+                RFAB_LOG_DEBUG("Dropped mark validation for a superseded load");
+                return;
+            }
+            if (g_markStore.Generation() != a_snapshot.generation) {
+                SKSE::log::info("Skipped mark validation: marks changed while it ran");
+                return;
+            }
+
+            const auto applyStart = ReadSteadyNs();
+            std::size_t removed = 0;
+            if (!a_result.staleKeys.empty() || !a_result.staleSignatures.empty()) {
+                EnsureMarkJournalAttached();
+                removed = g_markStore.Unmark(a_result.staleKeys, a_result.staleSignatures);
+                for (const auto key : a_result.staleKeys) {
+                    g_markLocations.Erase(key);
+                    TraceMarkDelta(JournalOp::kUnmarkKey, key);
+                }
+                for (const auto signature : a_result.staleSignatures) {
+                    TraceMarkDelta(JournalOp::kUnmarkSignature, static_cast<std::uint64_t>(signature));
+                }
+                PublishMarkCounts();
+            }
+            for (const auto key : a_result.reindexKeys) {
+                g_markLocations.Set(key, { kPlayerFormID, MarkLocationKind::kContainer });
+            }
+
+            SKSE::log::info(
+                "Validated {} mark(s): {} held, {} elsewhere, {} unlocated, {} stale removed, {} reindexed; "
+                "capture {:.2f} ms, validate {:.2f} ms on {} thread(s), apply {:.2f} ms",
+                a_snapshot.marks.size() + a_snapshot.signatures.size(),
+                a_result.held,
+                a_result.elsewhere,
+                a_result.unknown,
+                removed,
+                a_result.reindexKeys.size(),
+                a_timings.captureMs,
+                a_timings.validateMs,
+                a_result.workers,
+                ElapsedMs(applyStart));
+        }
+
+        // Capture on the game thread, validate on a worker, apply back on the game thread in one batch.
+        void StartMarkValidation()
+        {
+            StopMarkValidation();
+
+            auto* player = RE::PlayerCharacter::GetSingleton();
+            if (!player || !SKSE::GetTaskInterface()) {
+                return;
+            }
+
+            const auto ticket = g_markValidationTicket.load();
+            MarkValidationTimings timings;
+            const auto captureStart = ReadSteadyNs();
+            auto snapshot = std::make_shared<const MarkValidationSnapshot>(CaptureMarkValidationSnapshot(player));
+            timings.captureMs = ElapsedMs(captureStart);
+            if (snapshot->marks.empty() && snapshot->signatures.empty()) {
+                return;
+            }
+
+            g_markValidationThread = std::jthread([snapshot, ticket, timings](std::stop_token a_stop) mutable {
+                const auto validateStart = ReadSteadyNs();
+                auto result = std::make_shared<const MarkValidationResult>(ValidateMarks(*snapshot, 0, a_stop));
+                timings.validateMs = ElapsedMs(validateStart);
+                if (result->stopped || a_stop.stop_requested()) {
+                    return;
                 }
+                SKSE::GetTaskInterface()->AddTask([snapshot, result, ticket, timings]() {
+                    ApplyMarkValidation(ticket, *snapshot, *result, timings);
+                });
+            });
+        }
 
+        // Published to other plugins by pointer; see RFAB_Disenchant/MarkAPI.h for the contract.
+        // Every entry reads the store's snapshot, so none of them takes the store lock.
+        const RFABDisenchantMarkAPI g_markAPI{
+            RFAB_DISENCHANT_MARK_API_VERSION,
+            sizeof(RFABDisenchantMarkAPI),
+            [](std::uint32_t a_baseFormID, std::uint16_t a_uniqueID) -> std::uint64_t {
+                return MakeMarkKey(a_baseFormID, a_uniqueID);
+            },
+            [](std::uint64_t a_key) -> int {
+                return g_markStore.IsMarked(a_key) ? 1 : 0;
+            },
+            [](std::uint32_t a_objectFormID, std::uint32_t a_enchantmentFormID) -> int {
+                return g_markStore.IsMarked(MakeMarkSignature(a_objectFormID, a_enchantmentFormID)) ? 1 : 0;
+            },
+            [](const std::uint64_t* a_keys, std::size_t a_count, std::uint64_t* a_bits) -> std::size_t {
+                if (a_count == 0 || !a_keys || !a_bits) {
+                    return 0;
+                }
+                return g_markStore.AreMarked(std::span(a_keys, a_count), a_bits);
+            },
+            []() -> std::uint64_t {
+                return g_markStore.Generation();
+            }
+        };
+
+        void OnMarkAPIRequest(const char* a_sender)
+        {
+            SKSE::log::info("Mark API requested by {}", a_sender);
+            if (auto* messaging = SKSE::GetMessagingInterface()) {
+                (void)messaging->Dispatch(RFAB_DISENCHANT_MSG_MARK_API_RESPONSE, const_cast<RFABDisenchantMarkAPI*>(&g_markAPI),
+                    static_cast<std::uint32_t>(sizeof(g_markAPI)), a_sender);
+            }
+        }
+
+        void OnStatsRequest(const char* a_sender)
+        {
+            const auto previous = g_hookInstrumentation.fetch_or(kInstrumentCounters, std::memory_order_acq_rel);
+            if (!(previous & kInstrumentCounters)) {
+                SKSE::log::info("Stats requested by {}; collecting hook counters from now on", a_sender);
+            }
+
+            StoreStat(g_stats.ticksPerSecond, static_cast<std::uint64_t>(1e9 / g_hookTicks.NsPerTick()));
+            PublishMarkCounts();
+
+            if (auto* messaging = SKSE::GetMessagingInterface()) {
+                (void)messaging->Dispatch(RFAB_DISENCHANT_MSG_STATS_RESPONSE, &g_stats, static_cast<std::uint32_t>(sizeof(g_stats)), a_sender);
+            }
+        }
+
+        void OnPluginMessage(SKSE::MessagingInterface::Message* a_msg)
+        {
+            if (!a_msg || !a_msg->sender) {
                 return;
             }
+
+            switch (a_msg->type) {
+            case RFAB_DISENCHANT_MSG_STATS_REQUEST:
+                OnStatsRequest(a_msg->sender);
+                break;
+            case RFAB_DISENCHANT_MSG_MARK_API_REQUEST:
+                OnMarkAPIRequest(a_msg->sender);
+                break;
+            default:
+                break;
+            }
         }
+    }
 
-        void RevertCallback(SKSE::SerializationInterface*)
+    namespace Papyrus
+    {
+        constexpr auto* kScriptName = "RFAB_Disenchant";
+
+        [[nodiscard]] RE::TESObjectREFR* ResolveContainer(RE::TESObjectREFR* a_ref)
+        {
+            return a_ref ? a_ref : RE::PlayerCharacter::GetSingleton();
+        }
+
+        // Each native below walks the container's inventory exactly once, using the same notion of
+        // "marked" as the enchanting menu.
+        template <class F>
+        void ForEachMarkedEntry(RE::TESObjectREFR* a_ref, std::function<bool(RE::TESBoundObject&)> a_filter, F&& a_visitor)
+        {
+            ForEachMarkedInventoryEntry(ResolveContainer(a_ref), std::move(a_filter), std::forward<F>(a_visitor));
+        }
+
+        std::int32_t GetMarkedItemCount(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref)
+        {
+            std::int32_t marked = 0;
+            ForEachMarkedEntry(a_ref, nullptr, [&](auto*, auto*, const auto&, const auto&) { ++marked; });
+            return marked;
+        }
+
+        std::vector<RE::TESForm*> GetMarkedItems(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref)
+        {
+            std::vector<RE::TESForm*> items;
+            ForEachMarkedEntry(a_ref, nullptr, [&](RE::TESBoundObject* a_object, auto*, const auto&, const auto&) {
+                items.push_back(a_object);
+            });
+            return items;
+        }
+
+        bool IsItemMarked(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref, RE::TESForm* a_item)
+        {
+            if (!a_item) {
+                return false;
+            }
+
+            bool marked = false;
+            ForEachMarkedEntry(
+                a_ref,
+                [a_item](RE::TESBoundObject& a_object) { return &a_object == a_item; },
+                [&](auto*, auto*, const auto&, const auto&) { marked = true; });
+            return marked;
+        }
+
+        std::int32_t RemoveAllMarkedEnchantments(RE::StaticFunctionTag*, RE::TESObjectREFR* a_ref)
         {
-            std::scoped_lock lk(g_markedItemsLock);
-            g_markedItems.clear();
-            g_markedSignatures.clear();
+            return static_cast<std::int32_t>(StripAllMarkedEnchantments(ResolveContainer(a_ref), GetActiveEnchantConstructMenu()));
+        }
+
+        bool RegisterFunctions(RE::BSScript::IVirtualMachine* a_vm)
+        {
+            a_vm->RegisterFunction("GetMarkedItemCount", kScriptName, GetMarkedItemCount);
+            a_vm->RegisterFunction("GetMarkedItems", kScriptName, GetMarkedItems);
+            a_vm->RegisterFunction("IsItemMarked", kScriptName, IsItemMarked);
+            a_vm->RegisterFunction("RemoveAllMarkedEnchantments", kScriptName, RemoveAllMarkedEnchantments);
+            return true;
         }
     }
 
     bool Install()
     {
+        g_hookTicks.Start();
+        ConfigureSuppressionWindows();
+        RemoveEmptyMarkJournals();
         ItemChangeSetDataHook::Install();
         ItemChangeActivateHook::Install();
         ProcessUserEventHook::Install();
@@ -1742,9 +3249,62 @@ namespace RFAB::Disenchant
         } else {
             SKSE::log::error("Failed to install input sink (BSInputDeviceManager singleton null)");
         }
+        if (auto* ui = RE::UI::GetSingleton()) {
+            ui->AddEventSink<RE::MenuOpenCloseEvent>(&g_menuOpenCloseSink);
+        }
+        if (auto* events = RE::ScriptEventSourceHolder::GetSingleton()) {
+            events->AddEventSink<RE::TESContainerChangedEvent>(&g_containerChangedSink);
+        } else {
+            SKSE::log::error("Failed to install container sink (ScriptEventSourceHolder singleton null)");
+        }
+        StartHookTrace();
+        StartHookStats();
+        StartChromeTrace();
+        RFAB_LOG_DEBUG("Mark probe using {}", GetProbeIsaName(DetectProbeIsa()));
         return true;
     }
 
+    void RegisterPluginListener()
+    {
+        auto* messaging = SKSE::GetMessagingInterface();
+        if (!messaging || !messaging->RegisterListener(nullptr, OnPluginMessage)) {
+            SKSE::log::error("Failed to register plugin message listener");
+        }
+    }
+
+    void RegisterPapyrus()
+    {
+        auto* papyrus = SKSE::GetPapyrusInterface();
+        if (!papyrus || !papyrus->Register(Papyrus::RegisterFunctions)) {
+            SKSE::log::error("Failed to register Papyrus functions");
+        }
+    }
+
+    // Signature marks predate unique-ID assignment. Once per load, on the game thread, every
+    // carried instance of a signature-marked pair gets a unique ID and a key mark in one batch; the
+    // signatures stay, since they are all that marks the copies the player does not carry.
+    void MigrateSignatureMarks()
+    {
+        ChromeSpan span("MigrateSignatureMarks", kChromeCoSaveCategory);
+        std::vector<MarkSignature> signatures;
+        g_markStore.Visit([&](const MarkSet& a_marks) { signatures.assign(a_marks.signatures.begin(), a_marks.signatures.end()); });
+        if (signatures.empty()) {
+            return;
+        }
+
+        std::ranges::sort(signatures);
+        const auto keys = AssignUniqueIDs(RE::PlayerCharacter::GetSingleton(), signatures);
+        MarkItems(keys);
+        SKSE::log::info("Keyed {} carried instance(s) of {} signature mark(s)", keys.size(), signatures.size());
+    }
+
+    void ValidateMarksAfterLoad()
+    {
+        if (Settings::GetSingleton().validateOnLoad) {
+            StartMarkValidation();
+        }
+    }
+
     void RegisterSerialization()
     {
         auto* serialization = SKSE::GetSerializationInterface();
@@ -4,6 +4,10 @@ namespace RFAB::Disenchant
 {
     bool Install();
     void RegisterSerialization();
+    void RegisterPluginListener();
+    void RegisterPapyrus();
+    void MigrateSignatureMarks();
+    void ValidateMarksAfterLoad();
 }
 
 
@@ -1,16 +1,55 @@
 #pragma once
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
+// Hot-path logging that compiles away entirely below RFAB_LOG_ACTIVE_LEVEL (spdlog level
+// numbering: 0 trace, 1 debug, 2 info). What survives is still filtered by the runtime level
+// from [Log] sLevel, and costs one level compare when filtered out.
+#ifndef RFAB_LOG_ACTIVE_LEVEL
+#    define RFAB_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+#endif
+
+#if RFAB_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#    define RFAB_LOG_TRACE(...) SKSE::log::trace(__VA_ARGS__)
+#else
+#    define RFAB_LOG_TRACE(...) (void)0
+#endif
+
+#if RFAB_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#    define RFAB_LOG_DEBUG(...) SKSE::log::debug(__VA_ARGS__)
+#else
+#    define RFAB_LOG_DEBUG(...) (void)0
+#endif
+
+// Log calls only format and enqueue; a single background thread owns the file. When the queue
+// is full the oldest pending message is dropped rather than stalling the game thread.
 inline void SetupLog()
 {
+    constexpr std::size_t kQueueSize = 8192;
+    constexpr auto kFlushInterval = std::chrono::seconds(1);
+
     auto logsFolder = SKSE::log::log_directory();
     if (!logsFolder) SKSE::stl::report_and_fail("SKSE log_directory not provided, logs disabled.");
     auto pluginName = SKSE::PluginDeclaration::GetSingleton()->GetName();
     auto logFilePath = *logsFolder / std::format("{}.log", pluginName);
-    auto fileLoggerPtr = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
-    auto loggerPtr = std::make_shared<spdlog::logger>("log", std::move(fileLoggerPtr));
+    auto fileSinkPtr = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
+    spdlog::init_thread_pool(kQueueSize, 1);
+    auto loggerPtr = std::make_shared<spdlog::async_logger>(
+        "log", std::move(fileSinkPtr), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
     spdlog::set_default_logger(std::move(loggerPtr));
     spdlog::set_level(spdlog::level::info);
     spdlog::flush_on(spdlog::level::err);
+    spdlog::flush_every(kFlushInterval);
+}
+
+inline void SetLogLevel(std::string_view a_level)
+{
+    const auto level = spdlog::level::from_str(std::string(a_level));
+    if (level == spdlog::level::off && a_level != "off") {
+        SKSE::log::warn("Unknown log level '{}', keeping the current level", a_level);
+        return;
+    }
+
+    spdlog::set_level(level);
 }
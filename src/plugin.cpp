@@ -1,5 +1,6 @@
 #include "log.h"
 #include "hook.h"
+#include "settings.h"
 
 void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
 {
@@ -12,6 +13,10 @@ void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
     case SKSE::MessagingInterface::kPreLoadGame:
         break;
     case SKSE::MessagingInterface::kPostLoadGame:
+        if (a_msg->data) {
+            RFAB::Disenchant::MigrateSignatureMarks();
+            RFAB::Disenchant::ValidateMarksAfterLoad();
+        }
         break;
     case SKSE::MessagingInterface::kNewGame:
         break;
@@ -23,13 +28,16 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse)
     SKSE::Init(skse);
     SKSE::AllocTrampoline(1 << 12);
     SetupLog();
+    RFAB::Disenchant::Settings::GetSingleton().Load();
 
     RFAB::Disenchant::RegisterSerialization();
+    RFAB::Disenchant::RegisterPapyrus();
 
     auto messaging = SKSE::GetMessagingInterface();
     if (!messaging->RegisterListener("SKSE", MessageHandler)) {
         return false;
     }
+    RFAB::Disenchant::RegisterPluginListener();
 
     return true;
 }
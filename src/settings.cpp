@@ -0,0 +1,88 @@
+#include "settings.h"
+
+#include "log.h"
+
+#include <cwctype>
+#include <iterator>
+#include <Windows.h>
+
+namespace RFAB::Disenchant
+{
+    namespace
+    {
+        constexpr auto* kIniFileName = L"RFAB_Disenchant.ini";
+
+        [[nodiscard]] bool ReadBool(const std::filesystem::path& a_path, const wchar_t* a_section, const wchar_t* a_key, bool a_default)
+        {
+            return ::GetPrivateProfileIntW(a_section, a_key, a_default ? 1 : 0, a_path.c_str()) != 0;
+        }
+
+        [[nodiscard]] std::string ReadString(const std::filesystem::path& a_path, const wchar_t* a_section, const wchar_t* a_key, const std::string& a_default)
+        {
+            wchar_t buffer[64]{};
+            const auto length = ::GetPrivateProfileStringW(a_section, a_key, L"", buffer, static_cast<DWORD>(std::size(buffer)), a_path.c_str());
+            if (length == 0) {
+                return a_default;
+            }
+
+            std::string value;
+            value.reserve(length);
+            for (DWORD i = 0; i < length; ++i) {
+                value.push_back(buffer[i] < 0x80 ? static_cast<char>(std::towlower(buffer[i])) : '?');
+            }
+            return value;
+        }
+
+        [[nodiscard]] std::uint32_t ReadUInt(const std::filesystem::path& a_path, const wchar_t* a_section, const wchar_t* a_key, std::uint32_t a_default)
+        {
+            const auto value = static_cast<int>(::GetPrivateProfileIntW(a_section, a_key, static_cast<int>(a_default), a_path.c_str()));
+            return value < 0 ? a_default : static_cast<std::uint32_t>(value);
+        }
+    }
+
+    Settings& Settings::GetSingleton()
+    {
+        static Settings singleton;
+        return singleton;
+    }
+
+    std::filesystem::path Settings::GetPluginFolder()
+    {
+        return std::filesystem::current_path() / "Data" / "SKSE" / "Plugins" / "RFAB_Disenchant";
+    }
+
+    void Settings::Load()
+    {
+        const auto path = GetPluginFolder() / kIniFileName;
+        logLevel = ReadString(path, L"Log", L"sLevel", logLevel);
+        SetLogLevel(logLevel);
+
+        journalEnabled = ReadBool(path, L"Journal", L"bEnabled", journalEnabled);
+        restackStripped = ReadBool(path, L"Removal", L"bRestackStripped", restackStripped);
+        validateOnLoad = ReadBool(path, L"Validation", L"bOnLoad", validateOnLoad);
+        prewarmRows = ReadBool(path, L"Menu", L"bPrewarmRows", prewarmRows);
+        recordTrace = ReadBool(path, L"Diagnostics", L"bRecordTrace", recordTrace);
+        chromeTrace = ReadBool(path, L"Diagnostics", L"bChromeTrace", chromeTrace);
+        hookStats = ReadBool(path, L"Diagnostics", L"bHookStats", hookStats);
+        hookStatsIntervalSec = ReadUInt(path, L"Diagnostics", L"iHookStatsIntervalSec", hookStatsIntervalSec);
+        confirmWindows.forceHideMinMs = ReadUInt(path, L"Timing", L"iForceHideMinMs", confirmWindows.forceHideMinMs);
+        confirmWindows.forceHideMaxMs = ReadUInt(path, L"Timing", L"iForceHideMaxMs", confirmWindows.forceHideMaxMs);
+        confirmWindows.suppressInputMinMs = ReadUInt(path, L"Timing", L"iSuppressInputMinMs", confirmWindows.suppressInputMinMs);
+        confirmWindows.suppressInputMaxMs = ReadUInt(path, L"Timing", L"iSuppressInputMaxMs", confirmWindows.suppressInputMaxMs);
+        confirmWindows.allowNoDataMinMs = ReadUInt(path, L"Timing", L"iAllowNoDataMinMs", confirmWindows.allowNoDataMinMs);
+        confirmWindows.allowNoDataMaxMs = ReadUInt(path, L"Timing", L"iAllowNoDataMaxMs", confirmWindows.allowNoDataMaxMs);
+        confirmWindows.confirmDebounceMinMs = ReadUInt(path, L"Timing", L"iConfirmDebounceMinMs", confirmWindows.confirmDebounceMinMs);
+        confirmWindows.confirmDebounceMaxMs = ReadUInt(path, L"Timing", L"iConfirmDebounceMaxMs", confirmWindows.confirmDebounceMaxMs);
+
+        SKSE::log::info(
+            "Settings: log level {}, journal {}, restack {}, load validation {}, row pre-warm {}, hook trace {}, Chrome trace {}, hook stats {}",
+            logLevel,
+            journalEnabled ? "enabled" : "disabled",
+            restackStripped ? "enabled" : "disabled",
+            validateOnLoad ? "enabled" : "disabled",
+            prewarmRows ? "enabled" : "disabled",
+            recordTrace ? "enabled" : "disabled",
+            chromeTrace ? "enabled" : "disabled",
+            hookStats ? "enabled" : "disabled");
+    }
+}
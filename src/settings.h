@@ -0,0 +1,29 @@
+#pragma once
+
+#include "core/confirm_flow.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace RFAB::Disenchant
+{
+    struct Settings
+    {
+        std::string logLevel{ "info" };
+        bool journalEnabled{ true };
+        bool restackStripped{ false };
+        bool validateOnLoad{ true };
+        bool prewarmRows{ true };
+        bool recordTrace{ false };
+        bool chromeTrace{ false };
+        bool hookStats{ false };
+        std::uint32_t hookStatsIntervalSec{ 60 };
+        ConfirmWindowBounds confirmWindows;
+
+        [[nodiscard]] static Settings& GetSingleton();
+        [[nodiscard]] static std::filesystem::path GetPluginFolder();
+
+        void Load();
+    };
+}
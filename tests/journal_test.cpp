@@ -0,0 +1,238 @@
+#include "core/journal.h"
+#include "core/mark_store.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define RFAB_CHECK(a_expr)                                                                    \
+    do {                                                                                      \
+        if (!(a_expr)) {                                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #a_expr); \
+            ++g_failures;                                                                     \
+        }                                                                                     \
+    } while (false)
+
+namespace RFAB::Disenchant::JournalTest
+{
+    namespace
+    {
+        int g_failures = 0;
+
+        using Ops = std::vector<std::pair<JournalOp, std::uint64_t>>;
+
+        // On-disk layout the corruption cases poke at: a 32-byte header, then 16-byte records
+        // with the check at offset 4.
+        constexpr std::size_t kHeaderBytes = 32;
+        constexpr std::size_t kRecordBytes = 16;
+        constexpr std::size_t kCheckOffset = 4;
+
+        [[nodiscard]] Ops ReplayFile(const std::filesystem::path& a_path)
+        {
+            Ops ops;
+            MarkJournal journal;
+            if (!journal.Open(a_path)) {
+                return ops;
+            }
+            journal.Replay([&](JournalOp a_op, std::uint64_t a_value) { ops.emplace_back(a_op, a_value); });
+            return ops;
+        }
+
+        void PatchFile(const std::filesystem::path& a_path, std::size_t a_offset, const void* a_bytes, std::size_t a_size)
+        {
+            std::fstream file(a_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(a_offset));
+            file.write(static_cast<const char*>(a_bytes), static_cast<std::streamsize>(a_size));
+        }
+
+        void AppendAndReplay(const std::filesystem::path& a_path)
+        {
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Reset(7));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 0x14'0001));
+                RFAB_CHECK(journal.Append(JournalOp::kUnmarkKey, 0x14'0001));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkSignature, 0x1234'0000'5678));
+                RFAB_CHECK(journal.Size() == 3);
+            }
+
+            const auto ops = ReplayFile(a_path);
+            RFAB_CHECK(ops.size() == 3);
+            RFAB_CHECK(ops.size() == 3 && ops[0] == std::make_pair(JournalOp::kMarkKey, std::uint64_t{ 0x14'0001 }));
+            RFAB_CHECK(ops.size() == 3 && ops[2] == std::make_pair(JournalOp::kMarkSignature, std::uint64_t{ 0x1234'0000'5678 }));
+
+            MarkJournal journal;
+            RFAB_CHECK(journal.Open(a_path));
+            RFAB_CHECK(journal.BaseToken() == 7);
+        }
+
+        void ResetDropsRecords(const std::filesystem::path& a_path)
+        {
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Reset(1));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 1));
+                RFAB_CHECK(journal.Reset(2));
+                RFAB_CHECK(journal.Size() == 0);
+            }
+            RFAB_CHECK(ReplayFile(a_path).empty());
+        }
+
+        // Save A (token 1), mark, save B (reset to 2), load A again (reset back to 1): what was
+        // marked on top of A before B must not come back.
+        void ResetToEarlierTokenStaysEmpty(const std::filesystem::path& a_path)
+        {
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Reset(1));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 0xAA));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 0xBB));
+                RFAB_CHECK(journal.Reset(2));
+                RFAB_CHECK(journal.Reset(1));
+            }
+            RFAB_CHECK(ReplayFile(a_path).empty());
+
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Size() == 0);
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 0xCC));
+            }
+            const auto ops = ReplayFile(a_path);
+            RFAB_CHECK(ops.size() == 1 && ops[0].second == 0xCC);
+        }
+
+        // Loading the same save twice attaches against the same token both times: the first
+        // attach replays what was appended on top of it, the second must not replay it again.
+        void SameTokenReloadReplaysOnce(const std::filesystem::path& a_path)
+        {
+            {
+                MarkStore store;
+                RFAB_CHECK(store.AttachJournal(a_path, 6));
+                RFAB_CHECK(store.Mark(std::uint64_t{ 0x14'0001 }));
+                RFAB_CHECK(store.Mark(std::uint64_t{ 0x14'0002 }));
+            }
+
+            {
+                MarkStore store;
+                std::size_t replayed = 0;
+                RFAB_CHECK(store.AttachJournal(a_path, 6, &replayed));
+                RFAB_CHECK(replayed == 2);
+                RFAB_CHECK(store.IsMarked(std::uint64_t{ 0x14'0001 }));
+                RFAB_CHECK(store.Unmark(std::uint64_t{ 0x14'0002 }));
+                RFAB_CHECK(store.Mark(std::uint64_t{ 0x14'0003 }));
+            }
+
+            MarkStore store;
+            std::size_t replayed = 0;
+            RFAB_CHECK(store.AttachJournal(a_path, 6, &replayed));
+            RFAB_CHECK(replayed == 2);
+            RFAB_CHECK(!store.IsMarked(std::uint64_t{ 0x14'0001 }));
+            RFAB_CHECK(!store.IsMarked(std::uint64_t{ 0x14'0002 }));
+            RFAB_CHECK(store.IsMarked(std::uint64_t{ 0x14'0003 }));
+        }
+
+        void TornTailIsDropped(const std::filesystem::path& a_path)
+        {
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Reset(3));
+                for (std::uint64_t value = 1; value <= 4; ++value) {
+                    RFAB_CHECK(journal.Append(JournalOp::kMarkKey, value));
+                }
+            }
+
+            // A crash between the payload and the check store leaves the check at zero.
+            const std::uint32_t zero = 0;
+            PatchFile(a_path, kHeaderBytes + 2 * kRecordBytes + kCheckOffset, &zero, sizeof(zero));
+            const auto ops = ReplayFile(a_path);
+            RFAB_CHECK(ops.size() == 2);
+            RFAB_CHECK(ops.size() == 2 && ops[1].second == 2);
+
+            // Appending after the torn record overwrites it and carries on from there.
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Append(JournalOp::kUnmarkKey, 9));
+            }
+            const auto resumed = ReplayFile(a_path);
+            RFAB_CHECK(resumed.size() == 3 && resumed[2] == std::make_pair(JournalOp::kUnmarkKey, std::uint64_t{ 9 }));
+        }
+
+        void GrowsPastInitialCapacity(const std::filesystem::path& a_path)
+        {
+            constexpr std::uint64_t kCount = 10000;
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(a_path));
+                RFAB_CHECK(journal.Reset(4));
+                for (std::uint64_t value = 0; value < kCount; ++value) {
+                    RFAB_CHECK(journal.Append(JournalOp::kMarkKey, value));
+                }
+            }
+            const auto ops = ReplayFile(a_path);
+            RFAB_CHECK(ops.size() == kCount);
+            RFAB_CHECK(ops.size() == kCount && ops.back().second == kCount - 1);
+        }
+
+        void RemovesOnlyEmptyJournals(const std::filesystem::path& a_folder)
+        {
+            const auto empty = a_folder / (std::string("empty") + MarkJournal::kExtension);
+            const auto full = a_folder / (std::string("full") + MarkJournal::kExtension);
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(empty));
+                RFAB_CHECK(journal.Reset(5));
+            }
+            {
+                MarkJournal journal;
+                RFAB_CHECK(journal.Open(full));
+                RFAB_CHECK(journal.Reset(5));
+                RFAB_CHECK(journal.Append(JournalOp::kMarkKey, 1));
+            }
+
+            RFAB_CHECK(MarkJournal::RemoveEmpty(a_folder) == 1);
+            RFAB_CHECK(!std::filesystem::exists(empty));
+            RFAB_CHECK(std::filesystem::exists(full));
+        }
+    }
+
+    int Run()
+    {
+        const auto root = std::filesystem::temp_directory_path() / "rfab_journal_test";
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+        std::filesystem::create_directories(root);
+
+        const auto file = [&](const char* a_name) { return root / (std::string(a_name) + ".bin"); };
+        AppendAndReplay(file("append"));
+        ResetDropsRecords(file("reset"));
+        ResetToEarlierTokenStaysEmpty(file("reset_back"));
+        SameTokenReloadReplaysOnce(file("reload"));
+        TornTailIsDropped(file("torn"));
+        GrowsPastInitialCapacity(file("grow"));
+        std::filesystem::create_directories(root / "prune");
+        RemovesOnlyEmptyJournals(root / "prune");
+
+        std::filesystem::remove_all(root, ec);
+        if (g_failures != 0) {
+            std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+            return 1;
+        }
+        std::printf("journal: all checks passed\n");
+        return 0;
+    }
+}
+
+int main()
+{
+    return RFAB::Disenchant::JournalTest::Run();
+}
@@ -0,0 +1,580 @@
+#include "core/confirm_flow.h"
+#include "core/gating.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replays the remove-confirmation flow under a virtual clock. The game side (frames, UI tasks,
+// the MessageBoxMenu message queue, menu creation and the vanilla disenchant prompt) is scripted
+// here; the plugin side is the same ConfirmFlow and gating calls the hooks make, in the same
+// order as hook.cpp. Nothing waits on real time, so thousands of iterations run in milliseconds.
+namespace RFAB::Disenchant::ConfirmSim
+{
+    namespace
+    {
+        struct Options
+        {
+            std::uint32_t frameMs{ 16 };
+            std::uint32_t createMs{ 60 };
+            std::uint32_t promptMs{ 250 };
+            std::uint32_t clickMs{ 400 };
+            std::uint32_t jitterPercent{ 25 };
+            std::size_t iterations{ 200 };
+            std::uint32_t seed{ 1 };
+            std::string scenario;
+        };
+
+        // Latencies the scripted game uses for one scenario, scaled from the options.
+        struct Timing
+        {
+            std::uint32_t frameMs;
+            std::uint32_t createMs;
+            std::uint32_t promptMs;
+            std::uint32_t clickMs;
+        };
+
+        struct Report
+        {
+            std::size_t intents{ 0 };
+            std::size_t dialogsShown{ 0 };
+            std::size_t duplicates{ 0 };
+            std::size_t dropped{ 0 };
+            std::size_t blocked{ 0 };
+            std::size_t hotkeysRefused{ 0 };
+            std::size_t abandoned{ 0 };
+            std::size_t vanillaPrompts{ 0 };
+            std::size_t vanillaLeaks{ 0 };
+            std::size_t forceHides{ 0 };
+            std::vector<std::uint32_t> inputToDialog;
+            std::vector<std::uint32_t> confirmToInteractive;
+        };
+
+        [[nodiscard]] double Percentile(std::vector<std::uint32_t> a_values, double a_p)
+        {
+            if (a_values.empty()) {
+                return 0;
+            }
+
+            std::sort(a_values.begin(), a_values.end());
+            const auto index = static_cast<std::size_t>(a_p * static_cast<double>(a_values.size() - 1));
+            return static_cast<double>(a_values[index]);
+        }
+
+        class Simulator
+        {
+        public:
+            Simulator(const Timing& a_timing, std::uint32_t a_jitterPercent, std::uint32_t a_seed) :
+                _timing(a_timing),
+                _jitterPercent(a_jitterPercent),
+                _rng(a_seed)
+            {
+                _flow.Configure(ConfirmWindowBounds{});
+            }
+
+            [[nodiscard]] std::uint32_t Now() const noexcept { return _now; }
+            [[nodiscard]] const Timing& GetTiming() const noexcept { return _timing; }
+            [[nodiscard]] const ConfirmFlow& Flow() const noexcept { return _flow; }
+            [[nodiscard]] Report& GetReport() noexcept { return _report; }
+
+            void At(std::uint32_t a_atMs, std::function<void()> a_run)
+            {
+                _events.push(Event{ std::max(a_atMs, _now), _nextSeq++, std::move(a_run) });
+            }
+
+            // Input, UI tasks and menu messages are all pumped on the next frame boundary.
+            void OnNextFrame(std::function<void()> a_run)
+            {
+                At((_now / _timing.frameMs + 1) * _timing.frameMs, std::move(a_run));
+            }
+
+            void RunUntilIdle()
+            {
+                while (!_events.empty()) {
+                    auto event = _events.top();
+                    _events.pop();
+                    _now = event.atMs;
+                    event.run();
+                }
+            }
+
+            [[nodiscard]] std::uint32_t Jitter(std::uint32_t a_ms)
+            {
+                if (_jitterPercent == 0 || a_ms == 0) {
+                    return a_ms;
+                }
+
+                const auto spread = static_cast<double>(a_ms) * _jitterPercent / 100.0;
+                std::uniform_real_distribution<double> dist(-spread, spread);
+                return static_cast<std::uint32_t>(std::max(0.0, a_ms + dist(_rng)));
+            }
+
+            [[nodiscard]] bool Chance(double a_p) { return std::bernoulli_distribution(a_p)(_rng); }
+
+            // One user intent: counts the dialogs it produced once the world has gone idle. An
+            // intent whose hotkey was never taken (another box was up) is blocked, not dropped;
+            // a claimed confirmation that never became interactive is dropped.
+            void BeginIntent()
+            {
+                _claimedThisIntent = 0;
+                _shownThisIntent = 0;
+            }
+
+            void EndIntent()
+            {
+                ++_report.intents;
+                if (_claimedThisIntent == 0) {
+                    ++_report.blocked;
+                } else if (_shownThisIntent == 0) {
+                    ++_report.dropped;
+                } else if (_shownThisIntent > 1) {
+                    _report.duplicates += _shownThisIntent - 1;
+                }
+            }
+
+            // RemoveHotkeySink + ShowRemoveConfirmation.
+            void PressHotkey()
+            {
+                const auto pressedAt = _now;
+                OnNextFrame([this, pressedAt]() {
+                    const bool menuUp = _open || _creating || !_pending.empty();
+                    if (menuUp || _flow.IsBusy() || !_flow.TryBegin(_now)) {
+                        ++_report.hotkeysRefused;
+                        return;
+                    }
+
+                    ++_claimedThisIntent;
+                    _claimed = true;
+
+                    OnNextFrame([this, pressedAt]() {
+                        if (!_flow.IsOpen()) {
+                            return;
+                        }
+
+                        _flow.OnQueued(_now);
+                        PostShow(Box{ true, true, false, pressedAt });
+                    });
+                });
+            }
+
+            // A vanilla prompt with MessageBoxData, e.g. the disenchant confirmation. It leaks when
+            // it shows up on screen after following our confirmation, or while one is claimed;
+            // one opened before the hotkey is simply the player's.
+            void ShowVanillaPrompt(bool a_afterConfirm = false)
+            {
+                ++_report.vanillaPrompts;
+                PostShow(Box{ false, true, a_afterConfirm, _now });
+            }
+
+        private:
+            struct Event
+            {
+                std::uint32_t atMs;
+                std::uint64_t seq;
+                std::function<void()> run;
+
+                [[nodiscard]] bool operator>(const Event& a_rhs) const noexcept
+                {
+                    return atMs != a_rhs.atMs ? atMs > a_rhs.atMs : seq > a_rhs.seq;
+                }
+            };
+
+            struct Box
+            {
+                bool ours;
+                bool hasData;
+                bool mustHide;
+                std::uint32_t requestedAt;
+            };
+
+            void PostShow(Box a_box)
+            {
+                OnNextFrame([this, a_box]() { ProcessShow(a_box); });
+            }
+
+            // MessageBoxMenuProcessMessageHook for a show-like message.
+            void ProcessShow(Box a_box)
+            {
+                a_box.mustHide = a_box.mustHide || (!a_box.ours && _claimed);
+                MessageBoxInput input;
+                input.showLike = true;
+                input.hasData = a_box.hasData;
+                input.isOurConfirm = a_box.ours;
+                if (!a_box.ours) {
+                    input.suppress = _flow.ShouldSuppressMessageBox(_now);
+                    input.allowNoData = !input.hasData && _flow.ShouldAllowNoData(_now);
+                }
+
+                if (ShouldForceHideMessageBoxMessage(input)) {
+                    (void)_flow.OnMessageBoxSuppressed(_now);
+                    if (!_flow.IsOpen()) {
+                        QueueForceHide();
+                    }
+                    return;
+                }
+
+                if (a_box.hasData) {
+                    _flow.OnMessageBoxData(a_box.ours);
+                }
+
+                // The menu shows one box at a time; the rest wait in its data queue.
+                _pending.push_back(a_box);
+                if (!_open && !_creating) {
+                    CreateNext();
+                }
+            }
+
+            void CreateNext()
+            {
+                if (_pending.empty()) {
+                    return;
+                }
+
+                _creating = true;
+                const auto box = _pending.front();
+                _pending.pop_front();
+                At(_now + Jitter(_timing.createMs), [this, box, serial = ++_createSerial]() {
+                    if (_creating && serial == _createSerial) {
+                        PostCreate(box);
+                    }
+                });
+            }
+
+            [[nodiscard]] bool ForceHideDisplay()
+            {
+                const bool suppressNow = _flow.ShouldSuppressMessageBox(_now);
+                const bool allowNow = _flow.IsShowingOurs() || _flow.ShouldAllowNoData(_now);
+                return ShouldForceHideMessageBoxDisplay(suppressNow, allowNow);
+            }
+
+            // MessageBoxMenuPostCreateHook, then PreDisplay on the following frame.
+            void PostCreate(const Box& a_box)
+            {
+                _creating = false;
+                if (ForceHideDisplay()) {
+                    (void)_flow.OnMessageBoxSuppressed(_now);
+                    QueueForceHide();
+                    CreateNext();
+                    return;
+                }
+
+                (void)_flow.OnMessageBoxCreated(_now);
+                _open = true;
+                _openBox = a_box;
+                ++_openSerial;
+                OnNextFrame([this, serial = _openSerial]() { PreDisplay(serial); });
+            }
+
+            void PreDisplay(std::uint64_t a_serial)
+            {
+                if (!_open || _openSerial != a_serial) {
+                    return;
+                }
+
+                if (ForceHideDisplay()) {
+                    (void)_flow.OnMessageBoxSuppressed(_now);
+                    QueueForceHide();
+                    return;
+                }
+
+                if (!_openBox.ours) {
+                    if (_openBox.mustHide) {
+                        ++_report.vanillaLeaks;
+                    }
+                    At(_now + Jitter(_timing.clickMs), [this, a_serial]() { CloseBox(a_serial); });
+                    return;
+                }
+
+                ++_report.dialogsShown;
+                ++_shownThisIntent;
+                _report.inputToDialog.push_back(_now - _openBox.requestedAt);
+                At(_now + Jitter(_timing.clickMs), [this, a_serial]() { ClickConfirm(a_serial); });
+            }
+
+            // RemoveConfirmCallback::Run, then the game's own disenchant prompt some time later.
+            void ClickConfirm(std::uint64_t a_serial)
+            {
+                if (!_open || _openSerial != a_serial) {
+                    return;
+                }
+
+                const auto clickedAt = _now;
+                _claimed = false;
+                _flow.OnClosed(_now);
+                QueueForceHide();
+                CloseBox(a_serial);
+
+                // One prompt in twenty stalls (autosave, script lag) for several times as long.
+                auto promptMs = Jitter(_timing.promptMs);
+                if (Chance(0.05)) {
+                    promptMs *= 3;
+                }
+                At(_now + promptMs, [this]() { ShowVanillaPrompt(true); });
+                PollInteractive(clickedAt);
+            }
+
+            // The enchanting menu takes input again once the input suppression window lapses.
+            void PollInteractive(std::uint32_t a_clickedAt)
+            {
+                OnNextFrame([this, a_clickedAt]() {
+                    if (_flow.ShouldSuppressInput(_now)) {
+                        PollInteractive(a_clickedAt);
+                        return;
+                    }
+                    _report.confirmToInteractive.push_back(_now - a_clickedAt);
+                });
+            }
+
+            void CloseBox(std::uint64_t a_serial)
+            {
+                if (!_open || _openSerial != a_serial) {
+                    return;
+                }
+
+                _open = false;
+                NotifyClosed();
+            }
+
+            // MenuOpenCloseSink sees the close a frame later.
+            void NotifyClosed()
+            {
+                OnNextFrame([this]() {
+                    if (_flow.OnMessageBoxClosed()) {
+                        ++_report.abandoned;
+                        _claimed = false;
+                        if (_flow.Abort()) {
+                            QueueForceHide();
+                        }
+                    }
+                    if (!_open && !_creating) {
+                        CreateNext();
+                    }
+                });
+            }
+
+            // QueueMessageBoxForceHide: one kForceHide per frame, closing whatever box is up or
+            // still being created.
+            void QueueForceHide()
+            {
+                if (_forceHideQueued) {
+                    return;
+                }
+
+                _forceHideQueued = true;
+                ++_report.forceHides;
+                OnNextFrame([this]() {
+                    _forceHideQueued = false;
+                    if (_open) {
+                        CloseBox(_openSerial);
+                    } else if (_creating) {
+                        _creating = false;
+                        NotifyClosed();
+                    }
+                });
+            }
+
+            Timing _timing;
+            std::uint32_t _jitterPercent;
+            std::mt19937 _rng;
+            ConfirmFlow _flow;
+            std::priority_queue<Event, std::vector<Event>, std::greater<>> _events;
+            std::uint64_t _nextSeq{ 0 };
+            std::uint32_t _now{ 0 };
+            std::deque<Box> _pending;
+            Box _openBox{};
+            std::uint64_t _openSerial{ 0 };
+            std::uint64_t _createSerial{ 0 };
+            bool _open{ false };
+            bool _creating{ false };
+            bool _forceHideQueued{ false };
+            bool _claimed{ false };
+            std::size_t _claimedThisIntent{ 0 };
+            std::size_t _shownThisIntent{ 0 };
+            Report _report;
+        };
+
+        // Idle time between intents; long enough for every window from the last one to lapse.
+        constexpr std::uint32_t kIntentGapMs = 8000;
+
+        // Hotkey, confirm, vanilla prompt after Run.
+        void RunHotkeyConfirm(Simulator& a_sim, std::size_t a_iterations)
+        {
+            for (std::size_t i = 0; i < a_iterations; ++i) {
+                a_sim.BeginIntent();
+                a_sim.At(a_sim.Now() + kIntentGapMs, [&a_sim]() { a_sim.PressHotkey(); });
+                a_sim.RunUntilIdle();
+                a_sim.EndIntent();
+            }
+        }
+
+        // A vanilla prompt lands anywhere from just before the hotkey to after our dialog queues.
+        void RunVanillaRace(Simulator& a_sim, std::size_t a_iterations)
+        {
+            const auto& timing = a_sim.GetTiming();
+            const auto span = static_cast<std::int64_t>(timing.createMs + 4 * timing.frameMs);
+            for (std::size_t i = 0; i < a_iterations; ++i) {
+                a_sim.BeginIntent();
+                const auto pressAt = a_sim.Now() + kIntentGapMs;
+                const auto offset = -static_cast<std::int64_t>(timing.frameMs) +
+                                    static_cast<std::int64_t>(i % 16) * span / 15;
+                a_sim.At(pressAt, [&a_sim]() { a_sim.PressHotkey(); });
+                a_sim.At(static_cast<std::uint32_t>(pressAt + offset), [&a_sim]() { a_sim.ShowVanillaPrompt(); });
+                a_sim.RunUntilIdle();
+                a_sim.EndIntent();
+            }
+        }
+
+        // Hotkey mashed once per frame for a burst: exactly one dialog per burst.
+        void RunRapidClicks(Simulator& a_sim, std::size_t a_iterations)
+        {
+            constexpr std::uint32_t kBurst = 8;
+            const auto frameMs = a_sim.GetTiming().frameMs;
+            for (std::size_t i = 0; i < a_iterations; ++i) {
+                a_sim.BeginIntent();
+                const auto start = a_sim.Now() + kIntentGapMs;
+                for (std::uint32_t press = 0; press < kBurst; ++press) {
+                    a_sim.At(start + press * frameMs, [&a_sim]() { a_sim.PressHotkey(); });
+                }
+                a_sim.RunUntilIdle();
+                a_sim.EndIntent();
+            }
+        }
+
+        struct Scenario
+        {
+            std::string_view name;
+            std::uint32_t slowdown;
+            void (*run)(Simulator&, std::size_t);
+        };
+
+        constexpr Scenario kScenarios[] = {
+            { "hotkey-confirm", 1, RunHotkeyConfirm },
+            { "vanilla-race", 1, RunVanillaRace },
+            { "rapid-clicks", 1, RunRapidClicks },
+            { "slow-machine", 4, RunHotkeyConfirm },
+        };
+
+        void PrintWindow(const char* a_name, const AdaptiveWindow& a_window, bool a_last)
+        {
+            std::printf(
+                "\"%s\": {\"ms\": %u, \"samples\": %zu}%s",
+                a_name, a_window.Current(), a_window.SampleCount(), a_last ? "" : ", ");
+        }
+
+        void PrintReport(const Scenario& a_scenario, Simulator& a_sim, bool a_first)
+        {
+            const auto& report = a_sim.GetReport();
+            const auto& flow = a_sim.Flow();
+            std::printf(
+                "%s  {\"scenario\": \"%.*s\", \"intents\": %zu, \"dialogsShown\": %zu, \"duplicates\": %zu, "
+                "\"dropped\": %zu, \"blocked\": %zu, \"abandoned\": %zu, \"hotkeysRefused\": %zu, \"vanillaPrompts\": %zu, \"vanillaLeaks\": %zu, "
+                "\"forceHides\": %zu, \"inputToDialogP50Ms\": %.0f, \"inputToDialogP95Ms\": %.0f, "
+                "\"inputToDialogMaxMs\": %.0f, \"confirmToInteractiveP50Ms\": %.0f, "
+                "\"confirmToInteractiveP95Ms\": %.0f, \"confirmToInteractiveMaxMs\": %.0f, \"windows\": {",
+                a_first ? "" : ",\n",
+                static_cast<int>(a_scenario.name.size()), a_scenario.name.data(),
+                report.intents, report.dialogsShown, report.duplicates, report.dropped, report.blocked, report.abandoned, report.hotkeysRefused,
+                report.vanillaPrompts, report.vanillaLeaks, report.forceHides,
+                Percentile(report.inputToDialog, 0.50), Percentile(report.inputToDialog, 0.95),
+                Percentile(report.inputToDialog, 1.0),
+                Percentile(report.confirmToInteractive, 0.50), Percentile(report.confirmToInteractive, 0.95),
+                Percentile(report.confirmToInteractive, 1.0));
+            PrintWindow("forceHide", flow.ForceHideWindow(), false);
+            PrintWindow("suppressInput", flow.SuppressInputWindow(), false);
+            PrintWindow("allowNoData", flow.AllowNoDataWindow(), false);
+            PrintWindow("confirmDebounce", flow.ConfirmDebounceWindow(), true);
+            std::printf("}}");
+        }
+
+        [[nodiscard]] bool ParseOptions(int a_argc, char** a_argv, Options& a_options)
+        {
+            auto ok = true;
+            for (int i = 1; i < a_argc; ++i) {
+                const std::string_view arg = a_argv[i];
+                const auto hasValue = i + 1 < a_argc;
+                const auto next = [&]() { return static_cast<std::uint32_t>(std::strtoul(a_argv[++i], nullptr, 10)); };
+                if (arg == "--frame-ms" && hasValue) {
+                    a_options.frameMs = std::max<std::uint32_t>(1, next());
+                } else if (arg == "--create-ms" && hasValue) {
+                    a_options.createMs = next();
+                } else if (arg == "--prompt-ms" && hasValue) {
+                    a_options.promptMs = next();
+                } else if (arg == "--click-ms" && hasValue) {
+                    a_options.clickMs = next();
+                } else if (arg == "--jitter" && hasValue) {
+                    a_options.jitterPercent = std::min<std::uint32_t>(100, next());
+                } else if (arg == "--iterations" && hasValue) {
+                    a_options.iterations = std::max<std::size_t>(1, std::strtoull(a_argv[++i], nullptr, 10));
+                } else if (arg == "--seed" && hasValue) {
+                    a_options.seed = next();
+                } else if (arg == "--scenario" && hasValue) {
+                    a_options.scenario = a_argv[++i];
+                } else {
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (!ok) {
+                std::fprintf(
+                    stderr,
+                    "usage: %s [--scenario NAME] [--iterations N] [--seed N] [--frame-ms N] [--create-ms N]\n"
+                    "       [--prompt-ms N] [--click-ms N] [--jitter PERCENT]\n"
+                    "scenarios: hotkey-confirm, vanilla-race, rapid-clicks, slow-machine\n",
+                    a_argv[0]);
+            }
+            return ok;
+        }
+    }
+
+    int Run(int a_argc, char** a_argv)
+    {
+        Options options;
+        if (!ParseOptions(a_argc, a_argv, options)) {
+            return 1;
+        }
+
+        std::size_t failures = 0;
+        bool first = true;
+        std::printf("[\n");
+        for (const auto& scenario : kScenarios) {
+            if (!options.scenario.empty() && options.scenario != scenario.name) {
+                continue;
+            }
+
+            const Timing timing{
+                options.frameMs * scenario.slowdown,
+                options.createMs * scenario.slowdown,
+                options.promptMs * scenario.slowdown,
+                options.clickMs,
+            };
+            Simulator sim(timing, options.jitterPercent, options.seed);
+            scenario.run(sim, options.iterations);
+            PrintReport(scenario, sim, first);
+            first = false;
+
+            const auto& report = sim.GetReport();
+            failures += report.duplicates + report.dropped;
+        }
+        std::printf("\n]\n");
+
+        if (first) {
+            std::fprintf(stderr, "unknown scenario %s\n", options.scenario.c_str());
+            return 1;
+        }
+        return failures != 0 ? 2 : 0;
+    }
+}
+
+int main(int a_argc, char** a_argv)
+{
+    return RFAB::Disenchant::ConfirmSim::Run(a_argc, a_argv);
+}
@@ -0,0 +1,229 @@
+#include "core/gating.h"
+#include "core/hook_id.h"
+#include "core/hook_trace.h"
+#include "core/mark_key.h"
+#include "core/mark_store.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RFAB::Disenchant::Replay
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Options
+        {
+            std::string tracePath;
+            std::size_t repeat{ 100 };
+            std::size_t maxDiffs{ 20 };
+        };
+
+        struct HookStats
+        {
+            std::vector<HookTraceEvent> events;
+            std::vector<std::uint32_t> durations;
+            std::size_t diffs{ 0 };
+            double replayNsPerOp{ 0 };
+        };
+
+        volatile std::uint32_t g_sink = 0;
+
+        // Reruns the decision a recorded hook made with the current build's gating logic.
+        // Returns false for hooks that only carry timing.
+        [[nodiscard]] bool Decide(const HookTraceEvent& a_event, std::uint32_t& a_decision)
+        {
+            switch (a_event.hook) {
+            case HookId::kProcessUserEvent:
+                a_decision = PackTraceDecision(DecideUserEvent(UnpackUserEventInput(a_event.input)));
+                return true;
+            case HookId::kItemSetData:
+                a_decision = static_cast<std::uint32_t>(DecideRowDecoration(UnpackRowInput(a_event.input)));
+                return true;
+            case HookId::kItemActivate:
+                a_decision = static_cast<std::uint32_t>(DecideActivate(UnpackActivateInput(a_event.input)));
+                return true;
+            case HookId::kMessageBoxProcessMessage:
+                a_decision = ShouldForceHideMessageBoxMessage(UnpackMessageBoxInput(a_event.input)) ? 1u : 0u;
+                return true;
+            case HookId::kMessageBoxPreDisplay:
+            case HookId::kMessageBoxPostCreate:
+                a_decision = ShouldForceHideMessageBoxDisplay((a_event.input & 1u) != 0, (a_event.input & 2u) != 0) ? 1u : 0u;
+                return true;
+            case HookId::kDisenchantRun:
+                a_decision = ShouldBlockVanillaDisenchant(UnpackSelectionTargets(a_event.input)) ? 1u : 0u;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        [[nodiscard]] double Percentile(const std::vector<std::uint32_t>& a_sorted, double a_p)
+        {
+            if (a_sorted.empty()) {
+                return 0;
+            }
+
+            const auto index = static_cast<std::size_t>(a_p * static_cast<double>(a_sorted.size() - 1));
+            return static_cast<double>(a_sorted[index]);
+        }
+
+        void ApplyMarkDelta(MarkStore& a_store, const MarkDeltaEvent& a_event)
+        {
+            switch (a_event.op) {
+            case JournalOp::kMarkKey:
+                (void)a_store.Mark(a_event.value);
+                break;
+            case JournalOp::kUnmarkKey:
+                (void)a_store.Unmark(a_event.value);
+                break;
+            case JournalOp::kMarkSignature:
+                (void)a_store.Mark(static_cast<MarkSignature>(a_event.value));
+                break;
+            case JournalOp::kUnmarkSignature:
+                (void)a_store.Unmark(static_cast<MarkSignature>(a_event.value));
+                break;
+            }
+        }
+
+        [[nodiscard]] bool ParseOptions(int a_argc, char** a_argv, Options& a_options)
+        {
+            for (int i = 1; i < a_argc; ++i) {
+                const std::string_view arg = a_argv[i];
+                const auto hasValue = i + 1 < a_argc;
+                if (arg == "--repeat" && hasValue) {
+                    a_options.repeat = std::max<std::size_t>(1, std::strtoull(a_argv[++i], nullptr, 10));
+                } else if (arg == "--max-diffs" && hasValue) {
+                    a_options.maxDiffs = std::strtoull(a_argv[++i], nullptr, 10);
+                } else if (!arg.starts_with("--") && a_options.tracePath.empty()) {
+                    a_options.tracePath = a_argv[i];
+                } else {
+                    a_options.tracePath.clear();
+                    break;
+                }
+            }
+
+            if (a_options.tracePath.empty()) {
+                std::fprintf(stderr, "usage: %s <trace.rftrace> [--repeat N] [--max-diffs N]\n", a_argv[0]);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    int Run(int a_argc, char** a_argv)
+    {
+        Options options;
+        if (!ParseOptions(a_argc, a_argv, options)) {
+            return 1;
+        }
+
+        TraceReader reader;
+        if (!reader.Open(options.tracePath)) {
+            std::fprintf(stderr, "failed to open trace %s\n", options.tracePath.c_str());
+            return 1;
+        }
+
+        std::array<HookStats, kHookCount> stats;
+        MarkStore store;
+        std::size_t markDeltas = 0;
+        std::size_t reportedDiffs = 0;
+        std::uint64_t firstTimestamp = 0;
+
+        TraceEvent event;
+        while (reader.Next(event)) {
+            if (event.kind == TraceRecordKind::kMarkDelta) {
+                ApplyMarkDelta(store, event.markDelta);
+                ++markDeltas;
+                continue;
+            }
+
+            const auto index = static_cast<std::size_t>(event.hook.hook);
+            if (index >= kHookCount) {
+                continue;
+            }
+
+            if (firstTimestamp == 0) {
+                firstTimestamp = event.hook.timestampNs;
+            }
+
+            auto& hook = stats[index];
+            hook.events.push_back(event.hook);
+            hook.durations.push_back(event.hook.durationNs);
+
+            std::uint32_t decision = 0;
+            if (!Decide(event.hook, decision) || decision == event.hook.decision) {
+                continue;
+            }
+
+            ++hook.diffs;
+            if (reportedDiffs++ < options.maxDiffs) {
+                const auto control = reader.GetControlName(event.hook.controlID);
+                std::fprintf(stderr,
+                    "diff: %s at +%.3f ms control=\"%.*s\" input=%08X recorded=%08X replayed=%08X\n",
+                    std::string(GetHookName(event.hook.hook)).c_str(),
+                    static_cast<double>(event.hook.timestampNs - firstTimestamp) / 1e6,
+                    static_cast<int>(control.size()), control.data(),
+                    event.hook.input, event.hook.decision, decision);
+            }
+        }
+
+        for (auto& hook : stats) {
+            if (hook.events.empty()) {
+                continue;
+            }
+
+            std::uint32_t decision = 0;
+            if (!Decide(hook.events.front(), decision)) {
+                continue;
+            }
+
+            const auto start = Clock::now();
+            for (std::size_t pass = 0; pass < options.repeat; ++pass) {
+                for (const auto& recorded : hook.events) {
+                    (void)Decide(recorded, decision);
+                    g_sink = decision;
+                }
+            }
+            const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            hook.replayNsPerOp = elapsed / static_cast<double>(options.repeat * hook.events.size());
+        }
+
+        std::printf("[\n");
+        bool first = true;
+        for (std::size_t i = 0; i < kHookCount; ++i) {
+            auto& hook = stats[i];
+            if (hook.events.empty()) {
+                continue;
+            }
+
+            std::sort(hook.durations.begin(), hook.durations.end());
+            std::printf(
+                "%s  {\"hook\": \"%s\", \"calls\": %zu, \"recordedP50Ns\": %.0f, \"recordedP99Ns\": %.0f, "
+                "\"recordedMaxNs\": %.0f, \"replayNsPerOp\": %.2f, \"decisionDiffs\": %zu}",
+                first ? "" : ",\n",
+                std::string(kHookNames[i]).c_str(), hook.durations.size(),
+                Percentile(hook.durations, 0.50), Percentile(hook.durations, 0.99), Percentile(hook.durations, 1.0),
+                hook.replayNsPerOp, hook.diffs);
+            first = false;
+        }
+        std::printf(
+            "%s  {\"markDeltas\": %zu, \"finalMarkedKeys\": %zu, \"finalMarkedSignatures\": %zu}\n]\n",
+            first ? "" : ",\n",
+            markDeltas, store.KeyCount(), store.SignatureCount());
+
+        return reportedDiffs != 0 ? 2 : 0;
+    }
+}
+
+int main(int a_argc, char** a_argv)
+{
+    return RFAB::Disenchant::Replay::Run(a_argc, a_argv);
+}